@@ -0,0 +1,76 @@
+// Times glwx::BlockCompressor for every format/quality combination on a synthetic image (smooth
+// gradients with some noise, so the blocks are neither trivial nor random) and reports the
+// throughput. It does not need GL, so it runs anywhere.
+// Usage:
+//   bcencoder [size] [threads]   size defaults to 2048, threads to the default of the compressor
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glwx/blockcompressor.hpp"
+
+namespace {
+constexpr size_t iterations = 5;
+
+double run(const glwx::BlockCompressor& compressor, const std::vector<uint8_t>& image, size_t size,
+    const glwx::BlockCompressor::Options& options)
+{
+    double best = 1e10;
+    for (size_t i = 0; i < iterations; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto data = compressor.compress(image.data(), size, size, 4, options);
+        const auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+}
+
+int main(int argc, char** argv)
+{
+    const size_t size = argc > 1 ? std::stoul(argv[1]) : 2048;
+    const size_t threads
+        = argc > 2 ? std::stoul(argv[2]) : glwx::WorkerPool::getDefaultThreadCount();
+    const glwx::BlockCompressor compressor(threads);
+
+    std::mt19937 rng(42);
+    std::vector<uint8_t> image(size * size * 4);
+    for (size_t y = 0; y < size; ++y) {
+        for (size_t x = 0; x < size; ++x) {
+            const auto fx = static_cast<float>(x) / size, fy = static_cast<float>(y) / size;
+            const auto noise = [&rng]() { return static_cast<float>(rng() % 16) - 8.0f; };
+            const auto texel = image.data() + (y * size + x) * 4;
+            texel[0] = static_cast<uint8_t>(std::clamp(fx * 255.0f + noise(), 0.0f, 255.0f));
+            texel[1] = static_cast<uint8_t>(std::clamp(fy * 255.0f + noise(), 0.0f, 255.0f));
+            texel[2] = static_cast<uint8_t>(
+                std::clamp(128.0f + 100.0f * std::sin(fx * 40.0f) + noise(), 0.0f, 255.0f));
+            texel[3] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * std::cos(fy * 30.0f)));
+        }
+    }
+
+    std::printf("%zux%zu, %zu worker threads, best of %zu, without mipmaps\n", size, size,
+        threads, iterations);
+    using Format = glwx::BlockCompressor::Format;
+    using Quality = glwx::BlockCompressor::Quality;
+    const auto mpix = static_cast<double>(size * size) / 1e6;
+    for (const auto format : { Format::Bc1, Format::Bc3, Format::Bc4, Format::Bc5 }) {
+        for (const auto quality : { Quality::Fast, Quality::Normal, Quality::High }) {
+            static const char* formatNames[] = { "bc1", "bc3", "bc4", "bc5" };
+            static const char* qualityNames[] = { "fast", "normal", "high" };
+            const auto name = std::string(formatNames[static_cast<int>(format)]) + "."
+                + qualityNames[static_cast<int>(quality)];
+            glwx::BlockCompressor::Options options;
+            options.format = format;
+            options.quality = quality;
+            options.mipmaps = false;
+            const auto ms = run(compressor, image, size, options);
+            std::printf("%-24s %10.3f ms %10.1f MPix/s\n", name.c_str(), ms, mpix / ms * 1000.0);
+        }
+    }
+    return 0;
+}
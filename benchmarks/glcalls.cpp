@@ -0,0 +1,208 @@
+// Counts the GL calls (and bytes) glw/glwx issue for common workloads using the mock GL backend,
+// so no GPU or window is needed.
+// Usage:
+//   glcalls                      prints the results
+//   glcalls --write <file>       also writes them to <file>
+//   glcalls --check <file>       fails (exit code 1) if any result is higher than in <file>
+// ctest runs it with --check against glcalls.baseline (with GLWRAP_BUILD_MOCKGL). Regenerate the
+// baseline with --write when a change intentionally increases the number of calls.
+
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "glw/mockgl.hpp"
+#include "glw/state.hpp"
+#include "glwx/commandbuffer.hpp"
+#include "glwx/meshgen.hpp"
+#include "glwx/shader.hpp"
+#include "glwx/spriterenderer.hpp"
+#include "glwx/texture.hpp"
+#include "glwx/textureatlas.hpp"
+
+using Results = std::map<std::string, double>;
+
+namespace {
+constexpr auto vert = R"(
+    #version 330 core
+    uniform mat4 modelViewProjection;
+    layout (location = 0) in vec3 attrPosition;
+    void main() {
+        gl_Position = modelViewProjection * vec4(attrPosition, 1.0);
+    }
+)";
+
+constexpr auto frag = R"(
+    #version 330 core
+    uniform sampler2D tex;
+    out vec4 fragColor;
+    void main() {
+        fragColor = texture(tex, vec2(0.0));
+    }
+)";
+
+constexpr size_t drawCount = 1000;
+
+void addResults(Results& results, const std::string& name, size_t count)
+{
+    results[name + ".calls"] = static_cast<double>(glw::mock::getTotalCalls()) / count;
+    results[name + ".bytes"] = static_cast<double>(glw::mock::getTotalBytes()) / count;
+}
+
+// Every draw sets a transform and uses one of a few textures, like a simple scene would
+void meshDraws(Results& results)
+{
+    glw::VertexFormat vfmt;
+    vfmt.add(0, 3, glw::AttributeType::F32);
+    const auto box = glwx::makeBoxMesh(vfmt, { 0 }, 1.0f, 1.0f, 1.0f);
+    const auto prog = glwx::makeShaderProgram(std::string_view(vert), std::string_view(frag));
+    const std::array textures = {
+        glwx::makeTexture2D(glm::vec4(1.0f)),
+        glwx::makeTexture2D(glm::vec4(0.5f)),
+    };
+    const auto mvpLoc = prog->getUniformLocation("modelViewProjection");
+    const auto texLoc = prog->getUniformLocation("tex");
+
+    glw::mock::resetCounters();
+    for (size_t i = 0; i < drawCount; ++i) {
+        prog->bind();
+        prog->setUniform(mvpLoc, glm::mat4(static_cast<float>(i)));
+        prog->setUniform(texLoc, textures[i % textures.size()]);
+        box.primitive.draw();
+    }
+    addResults(results, "mesh", drawCount);
+
+    glwx::CommandBuffer cmd;
+    for (size_t i = 0; i < drawCount; ++i) {
+        cmd.bindShader(*prog);
+        cmd.setUniform(mvpLoc, glm::mat4(static_cast<float>(i)));
+        cmd.setUniform(texLoc, textures[i % textures.size()]);
+        cmd.draw(box.primitive);
+    }
+    glw::mock::resetCounters();
+    cmd.submit();
+    addResults(results, "commandbuffer", drawCount);
+}
+
+// Sprites with a texture switch every 10 sprites
+void sprites(Results& results)
+{
+    const std::array textures = {
+        glwx::makeTexture2D(glm::vec4(1.0f)),
+        glwx::makeTexture2D(glm::vec4(0.5f)),
+    };
+    glwx::SpriteRenderer renderer;
+    renderer.setShaderProgram(&glwx::SpriteRenderer::getDefaultShaderProgram());
+
+    glw::mock::resetCounters();
+    for (size_t i = 0; i < drawCount; ++i) {
+        const auto transform = glwx::Transform2D(glm::vec2(static_cast<float>(i), 0.0f));
+        renderer.draw(textures[(i / 10) % textures.size()], transform);
+    }
+    renderer.flush();
+    addResults(results, "sprites", drawCount);
+}
+
+// Like above, but both images are in the same TextureAtlas page, so there is only one batch
+void atlasSprites(Results& results)
+{
+    glwx::TextureAtlas atlas;
+    const std::array<uint32_t, 2> colors = { 0xffffffff, 0xff808080 };
+    const std::array regions = {
+        *atlas.add(reinterpret_cast<const uint8_t*>(&colors[0]), 1, 1, 4),
+        *atlas.add(reinterpret_cast<const uint8_t*>(&colors[1]), 1, 1, 4),
+    };
+    glwx::SpriteRenderer renderer;
+    renderer.setShaderProgram(&glwx::SpriteRenderer::getDefaultShaderProgram());
+
+    glw::mock::resetCounters();
+    for (size_t i = 0; i < drawCount; ++i) {
+        const auto transform = glwx::Transform2D(glm::vec2(static_cast<float>(i), 0.0f));
+        renderer.draw(regions[(i / 10) % regions.size()], transform);
+    }
+    renderer.flush();
+    addResults(results, "atlassprites", drawCount);
+}
+
+// Alternates between two pipeline states that differ in blending only
+void pipelineStates(Results& results)
+{
+    auto opaque = glw::PipelineState::Desc {};
+    opaque.depth.test = true;
+    auto transparent = opaque;
+    transparent.depth.write = false;
+    transparent.blend.enabled = true;
+    transparent.blend.func = { glw::BlendFunc::SrcAlpha, glw::BlendFunc::One,
+        glw::BlendFunc::OneMinusSrcAlpha, glw::BlendFunc::OneMinusSrcAlpha };
+    const std::array states = { glw::PipelineState(opaque), glw::PipelineState(transparent) };
+
+    glw::mock::resetCounters();
+    for (size_t i = 0; i < drawCount; ++i)
+        glw::State::instance().apply(states[(i / 10) % states.size()]);
+    addResults(results, "pipelinestate", drawCount);
+}
+
+Results run()
+{
+    Results results;
+    meshDraws(results);
+    sprites(results);
+    atlasSprites(results);
+    pipelineStates(results);
+    return results;
+}
+
+bool write(const Results& results, const std::string& path)
+{
+    std::ofstream file(path);
+    for (const auto& [name, value] : results)
+        file << name << " " << value << "\n";
+    return static_cast<bool>(file);
+}
+
+bool check(const Results& results, const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file) {
+        std::printf("Could not open baseline '%s'\n", path.c_str());
+        return false;
+    }
+    bool ok = true;
+    std::string name;
+    double baseline = 0.0;
+    while (file >> name >> baseline) {
+        const auto it = results.find(name);
+        if (it == results.end()) {
+            std::printf("Missing result '%s'\n", name.c_str());
+            ok = false;
+        } else if (it->second > baseline + 1e-6) {
+            std::printf("Regression in '%s': %g (baseline %g)\n", name.c_str(), it->second,
+                baseline);
+            ok = false;
+        }
+    }
+    return ok;
+}
+}
+
+int main(int argc, char** argv)
+{
+    glw::mock::install();
+    const auto results = run();
+    for (const auto& [name, value] : results)
+        std::printf("%-24s %10.3f\n", name.c_str(), value);
+
+    if (argc == 3 && argv[1] == std::string("--write"))
+        return write(results, argv[2]) ? 0 : 1;
+    if (argc == 3 && argv[1] == std::string("--check"))
+        return check(results, argv[2]) ? 0 : 1;
+    if (argc != 1) {
+        std::printf("Usage: %s [--write <file> | --check <file>]\n", argv[0]);
+        return 1;
+    }
+    return 0;
+}
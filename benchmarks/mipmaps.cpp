@@ -0,0 +1,60 @@
+// Times glwx::MipmapGenerator for every filter/option combination on a random image. It does not
+// need GL, so it runs anywhere.
+// Usage:
+//   mipmaps [size] [threads]     size defaults to 2048, threads to the default of the generator
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glwx/mipmaps.hpp"
+
+namespace {
+constexpr size_t iterations = 5;
+
+double run(const glwx::MipmapGenerator& generator, const std::vector<uint8_t>& image, size_t size,
+    size_t channels, const glwx::MipmapGenerator::Options& options)
+{
+    double best = 1e10;
+    for (size_t i = 0; i < iterations; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto levels = generator.generate(image.data(), size, size, channels, options);
+        const auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+}
+
+int main(int argc, char** argv)
+{
+    const size_t size = argc > 1 ? std::stoul(argv[1]) : 2048;
+    const size_t threads
+        = argc > 2 ? std::stoul(argv[2]) : glwx::WorkerPool::getDefaultThreadCount();
+    const glwx::MipmapGenerator generator(threads);
+
+    std::mt19937 rng(42);
+    std::vector<uint8_t> image(size * size * 4);
+    for (auto& v : image)
+        v = static_cast<uint8_t>(rng());
+
+    std::printf("%zux%zu, %zu worker threads, best of %zu\n", size, size, threads, iterations);
+    using Filter = glwx::MipmapGenerator::Filter;
+    for (const auto filter : { Filter::Box, Filter::Kaiser }) {
+        for (const auto channels : { size_t(3), size_t(4) }) {
+            for (const auto srgb : { false, true }) {
+                const auto name = std::string(filter == Filter::Box ? "box" : "kaiser")
+                    + (channels == 4 ? ".rgba" : ".rgb") + (srgb ? ".srgb" : "");
+                std::printf("%-24s %10.3f ms\n", name.c_str(),
+                    run(generator, image, size, channels, { filter, srgb, 0.0f }));
+                if (channels == 4)
+                    std::printf("%-24s %10.3f ms\n", (name + ".coverage").c_str(),
+                        run(generator, image, size, channels, { filter, srgb, 0.5f }));
+            }
+        }
+    }
+    return 0;
+}
@@ -78,7 +78,7 @@ int main(int, char**)
     const auto aspect = static_cast<float>(window.getSize().x) / window.getSize().y;
     glm::mat4 projectionMatrix = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 10.0f);
 
-    glEnable(GL_DEPTH_TEST);
+    glw::State::instance().setDepthTestEnabled(true);
 
     SDL_Event event;
     bool running = true;
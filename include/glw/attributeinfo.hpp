@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+#include "glad/glad.h"
+
+#include "glw/uniforminfo.hpp"
+
+namespace glw {
+class AttributeInfo {
+public:
+    // Attributes use the same type enums as uniforms (minus samplers and bools)
+    using Type = UniformInfo::Type;
+
+    std::string name = {};
+    int index = -1;
+    int size = 0;
+    Type type = Type::Invalid;
+    GLint location = -1;
+};
+
+// The number of consecutive locations an attribute of this type occupies (matrices take one
+// per column). Multiply by AttributeInfo::size for arrays.
+size_t getAttributeLocationCount(AttributeInfo::Type type);
+// The number of components of a single location, e.g. 3 for a vec3 or a mat4x3
+size_t getAttributeComponentCount(AttributeInfo::Type type);
+}
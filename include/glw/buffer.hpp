@@ -55,37 +55,48 @@ public:
 
     void free();
 
-    // http://hacksoflife.blogspot.de/2015/06/glmapbuffer-no-longer-cool.html
-    // => Don't implement map()?
+    // glBufferStorage requires ARB_buffer_storage (core in 4.4)
+    static bool storageSupported();
 
     void bind(Target target) const;
 
+    // For the indexed targets (Uniform and TransformFeedback), e.g. to bind (a range of) the buffer
+    // to the binding point of a uniform block. See State::bindBufferRange.
+    void bindBase(Target target, unsigned int index) const;
+    // offset has to be a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT for Target::Uniform
+    void bindRange(Target target, unsigned int index, size_t offset, size_t size) const;
+
+    // Allocates an immutable data store. data() must not be called afterwards.
+    void storage(Target target, size_t size, GLbitfield flags, const void* data = nullptr);
+
+    // http://hacksoflife.blogspot.de/2015/06/glmapbuffer-no-longer-cool.html
+    // Only map with GL_MAP_UNSYNCHRONIZED_BIT or persistently (and do your own synchronization),
+    // otherwise you likely stall just the same as with glBufferSubData.
+    void* map(Target target, size_t offset, size_t size, GLbitfield access) const;
+    void flushMappedRange(Target target, size_t offset, size_t size) const;
+    // Returns false if the data store was corrupted while mapped and has to be reinitialized
+    bool unmap(Target target) const;
+
+    // With DSA (see State::getDirectStateAccess) the target is ignored for all of these
     template <typename... Args>
     void data(Target target, UsageHint usage, Args&&... args)
     {
-        bind(target);
         const auto [data, size] = toPtrRange(std::forward<Args>(args)...);
-        glBufferData(static_cast<GLenum>(target), size, data, static_cast<GLenum>(usage));
-        size_ = size;
-        unbind(target);
+        dataBytes(target, usage, data, size);
     }
 
     template <typename... Args>
     void subData(Target target, size_t offset, Args&&... args) const
     {
-        bind(target);
         const auto [byteOffset, data, size] = toOffsetPtrRange(offset, std::forward<Args>(args)...);
-        glBufferSubData(static_cast<GLenum>(target), byteOffset, size, data);
-        unbind(target);
+        subDataBytes(target, byteOffset, data, size);
     }
 
     template <typename... Args>
     void subData(Target target, Args&&... args) const
     {
-        bind(target);
         const auto [data, size] = toPtrRange(std::forward<Args>(args)...);
-        glBufferSubData(static_cast<GLenum>(target), 0, size, data);
-        unbind(target);
+        subDataBytes(target, 0, data, size);
     }
 
     template <typename... Args>
@@ -104,6 +115,9 @@ public:
     size_t getSize() const;
 
 private:
+    void dataBytes(Target target, UsageHint usage, const void* data, size_t size);
+    void subDataBytes(Target target, size_t offset, const void* data, size_t size) const;
+
     GLuint buffer_ = 0;
     // I know this is not really in the spirit of these "thin" OpenGL wrappers, but it is necessary
     // to keep track of the data store size in a couple of places and it would be *way* dirtier
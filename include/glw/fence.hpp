@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+#include "glad/glad.h"
+
+namespace glw {
+// A sync object created with glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0).
+// A default-constructed (or moved-from) Fence counts as signaled.
+class Fence {
+public:
+    enum class WaitResult : GLenum {
+        AlreadySignaled = GL_ALREADY_SIGNALED,
+        TimeoutExpired = GL_TIMEOUT_EXPIRED,
+        ConditionSatisfied = GL_CONDITION_SATISFIED,
+        WaitFailed = GL_WAIT_FAILED,
+    };
+
+    Fence() = default;
+    ~Fence();
+
+    Fence(const Fence&) = delete;
+    Fence& operator=(const Fence&) = delete;
+
+    Fence(Fence&& other);
+    Fence& operator=(Fence&& other);
+
+    void free();
+
+    // Deletes the previous sync object (if any) and inserts a new one into the command stream
+    void insert();
+
+    // Does not block
+    bool isSignaled() const;
+
+    // This will flush the command stream, so the fence will be signaled eventually
+    WaitResult clientWait(uint64_t timeoutNs) const;
+
+    // Blocks until the fence is signaled. Returns false if the wait failed.
+    bool wait() const;
+
+    GLsync getSync() const;
+
+private:
+    GLsync sync_ = nullptr;
+};
+}
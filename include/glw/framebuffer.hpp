@@ -69,6 +69,14 @@ public:
     void detach(Target target, Attachment attachment);
     void detach(Attachment attachment);
 
+    // Selects the color buffer glReadPixels reads from. Binds the framebuffer to Target::Read.
+    void readBuffer(Attachment attachment) const;
+
+    // Reads from the framebuffer currently bound to Target::Read. If a buffer is bound to
+    // Buffer::Target::PixelPack, data is an offset into that buffer and this does not block.
+    static void readPixels(int x, int y, size_t width, size_t height,
+        Texture::DataFormat dataFormat, Texture::DataType dataType, void* data);
+
     Status getStatus(Target target = Target::Draw) const;
 
     bool isComplete() const;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 #include "glad/glad.h"
 
 namespace glw {
@@ -98,6 +100,16 @@ enum class ImageFormat : GLenum {
     CompressedSignedRedRgtc1 = GL_COMPRESSED_SIGNED_RED_RGTC1,
     CompressedRgRgtc2 = GL_COMPRESSED_RG_RGTC2,
     CompressedSignedRgRgtc2 = GL_COMPRESSED_SIGNED_RG_RGTC2,
+    // EXT_texture_compression_s3tc is not core, but supported by every desktop driver
+    CompressedRgbS3tcDxt1 = GL_COMPRESSED_RGB_S3TC_DXT1_EXT, // BC1
+    CompressedRgbaS3tcDxt1 = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, // BC1 with 1 bit alpha
+    CompressedRgbaS3tcDxt3 = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, // BC2
+    CompressedRgbaS3tcDxt5 = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, // BC3
+    // These additionally need EXT_texture_sRGB
+    CompressedSrgbS3tcDxt1 = GL_COMPRESSED_SRGB_S3TC_DXT1_EXT,
+    CompressedSrgbAlphaS3tcDxt1 = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT,
+    CompressedSrgbAlphaS3tcDxt3 = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT,
+    CompressedSrgbAlphaS3tcDxt5 = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT,
     // CompressedRgbaBptcUnorm = GL_COMPRESSED_RGBA_BPTC_UNORM, // 4.2
     // CompressedSrgbAlphaBptcUnorm = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, // 4.2
     // CompressedRgbBptcSignedFloat = GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, // 4.2
@@ -106,4 +118,17 @@ enum class ImageFormat : GLenum {
 
 extern bool hasDepth(ImageFormat format);
 extern bool hasStencil(ImageFormat format);
+
+// Maps the base formats (Red, Rgba, Depth, ...) to the sized formats drivers pick for them
+// (R8, Rgba8, Depth24, ...), because immutable storage only takes sized formats.
+// Everything else is returned as is.
+extern ImageFormat getSizedFormat(ImageFormat format);
+
+// Size of a 4x4 block of a block-compressed (S3TC/RGTC) format in bytes, 0 for every other format
+// (including the generic compressed formats, which are compressed however the driver likes).
+extern size_t getCompressedBlockSize(ImageFormat format);
+// Size of a whole level of a block-compressed format in bytes
+extern size_t getCompressedImageSize(ImageFormat format, size_t width, size_t height);
+// Whether the driver supports the extension the format needs (if it needs one)
+extern bool isCompressedFormatSupported(ImageFormat format);
 }
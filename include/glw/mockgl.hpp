@@ -0,0 +1,53 @@
+#pragma once
+
+#include <map>
+#include <string_view>
+
+#include "glad/glad.h"
+
+namespace glw::mock {
+// A recording stand-in for the GL driver, so State, Buffer, Texture, Primitive, SpriteBatch etc.
+// can be exercised without a context (e.g. to count GL calls in CI on machines without a GPU).
+// install() replaces the glad function pointers of every entry point glw and glwx use with stubs
+// that count calls and bytes transferred from client memory, hand out object names and track
+// bindings. Buffers get real storage, so mapping works. Shaders always compile and link, fences
+// are always signaled and framebuffers are always complete. Nothing is ever rendered.
+// Linked programs report the uniforms and vertex attributes of simple global declarations in the
+// shader sources (e.g. "uniform vec4 colors[4];") as active. Uniform blocks are not reflected.
+// Entry points that glw does not use stay null. This is not thread-safe (like a GL context).
+struct Options {
+    bool directStateAccess = false;
+    bool bufferStorage = false;
+    bool textureStorage = false;
+    // Programs report a (dummy) binary and any binary is accepted
+    bool programBinary = false;
+    // Compiles and links always report being finished
+    bool parallelShaderCompile = false;
+};
+
+struct CallStats {
+    size_t calls = 0;
+    size_t bytes = 0;
+};
+
+// Call this instead of gladLoadGL and before creating any GL objects
+void install(const Options& options = Options {});
+
+// Resets the call counters, but not the objects or bindings
+void resetCounters();
+
+const std::map<std::string_view, CallStats>& getCalls();
+CallStats getCalls(std::string_view entryPoint);
+size_t getTotalCalls();
+size_t getTotalBytes();
+
+// All object types (buffers, textures, shaders, ...) share one name space here.
+// Useful to check for leaks.
+size_t getLiveObjectCount();
+
+GLuint getBoundBuffer(GLenum target);
+GLuint getBoundTexture(unsigned int unit, GLenum target);
+GLuint getBoundVertexArray();
+GLuint getBoundFramebuffer(GLenum target);
+GLuint getCurrentProgram();
+}
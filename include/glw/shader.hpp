@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -8,9 +9,12 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "glw/attributeinfo.hpp"
 #include "glw/log.hpp"
 #include "glw/state.hpp"
+#include "glw/texture.hpp"
 #include "glw/uniforminfo.hpp"
+#include "glw/uniformname.hpp"
 
 namespace glw {
 struct ShaderResult {
@@ -21,6 +25,10 @@ struct ShaderResult {
     explicit operator bool() const;
 };
 
+// KHR_parallel_shader_compile. If it is available, the driver compiles and links on its own
+// threads and the is*Finished functions can be used to poll without blocking.
+bool getParallelCompileSupported();
+
 class Shader {
 public:
     enum class Type : GLenum {
@@ -76,8 +84,16 @@ public:
 
     void setSources(std::initializer_list<std::string_view> sources) const;
 
+    // Same as startCompile() followed by getCompileResult()
     ShaderResult compile() const;
 
+    // Querying the compile status (or the log) forces the driver to finish compilation, so to
+    // compile many shaders in parallel, start all of them first and only get the results when
+    // isCompileFinished returns true. Without parallel compile support that is always true.
+    void startCompile() const;
+    bool isCompileFinished() const;
+    ShaderResult getCompileResult() const;
+
     GLuint getShader() const;
 
 private:
@@ -90,6 +106,11 @@ public:
     using AttributeLocation = GLint;
     static constexpr GLint invalidLocation = -1;
 
+    struct Binary {
+        GLenum format;
+        std::vector<uint8_t> data;
+    };
+
     ShaderProgram();
 
     ~ShaderProgram();
@@ -106,28 +127,73 @@ public:
     void detach(const Shader& shader);
     void detach();
 
+    // Same as startLink() followed by getLinkResult()
     ShaderResult link();
 
+    // See Shader::startCompile. You may link right after starting the compiles of the attached
+    // shaders, if the link fails you can get the compile logs afterwards.
+    void startLink() const;
+    bool isLinkFinished() const;
+    ShaderResult getLinkResult();
+
+    // ARB_get_program_binary (core in 4.1). Check getBinarySupported() before using any of these.
+    static bool getBinarySupported();
+    // Call this before link() if you want to retrieve the binary afterwards
+    void setBinaryRetrievable(bool retrievable) const;
+    // Returns nullopt if the program is not linked or the driver does not give out a binary
+    std::optional<Binary> getBinary() const;
+    // Replaces link(). This might fail for a binary that was retrieved from a different driver
+    // (version), in which case you have to link from source.
+    ShaderResult loadBinary(const Binary& binary);
+
+    // Active attributes are retrieved on link, other names are queried from GL once
     AttributeLocation getAttributeLocation(const std::string& name) const;
-    UniformLocation getUniformLocation(const std::string& name) const;
+    // All active vertex attributes (without built-ins like gl_VertexID), keyed by name
+    const std::unordered_map<std::string, AttributeInfo>& getAttributeInfo() const;
+    // Uniform locations are looked up in a flat hash table (populated on link), so this neither
+    // allocates nor compares strings. Names that are not active uniforms (e.g. array elements)
+    // are queried from GL once and then added to the table.
+    UniformLocation getUniformLocation(UniformName name) const;
+
+    template <RuntimeString S>
+    UniformLocation getUniformLocation(const S& name) const
+    {
+        return getUniformLocation(UniformName(std::string_view(name)));
+    }
 
     const std::unordered_map<std::string, UniformInfo>& getUniformInfo() const;
 
+    // Reflection for all active uniform blocks (retrieved on link), keyed by block name
+    const std::unordered_map<std::string, UniformBlockInfo>& getUniformBlockInfo() const;
+    // Returns nullptr if there is no active block with that name
+    const UniformBlockInfo* getUniformBlockInfo(const std::string& name) const;
+    // Assigns the block to a uniform buffer binding point (see Buffer::bindRange). You only have
+    // to do this once after linking, the binding is part of the program object.
+    void setUniformBlockBinding(GLuint blockIndex, GLuint binding);
+    // Returns false if there is no active block with that name
+    bool setUniformBlockBinding(const std::string& blockName, GLuint binding);
+
     void bind() const;
     static void unbind();
 
     GLuint getProgram() const;
 
     template <typename... Args>
-    void setUniform(const std::string& name, Args&&... args) const
+    void setUniform(UniformName name, Args&&... args) const
     {
         const auto loc = getUniformLocation(name);
         if (loc != -1)
             setUniform(loc, std::forward<Args>(args)...);
     }
 
+    template <RuntimeString S, typename... Args>
+    void setUniform(const S& name, Args&&... args) const
+    {
+        setUniform(UniformName(std::string_view(name)), std::forward<Args>(args)...);
+    }
+
     void setUniform(UniformLocation loc, int value) const;
-    void setUniform(UniformLocation loc, const int* vals, size_t count = 1);
+    void setUniform(UniformLocation loc, const int* vals, size_t count = 1) const;
     void setUniform(UniformLocation loc, float value) const;
     void setUniform(UniformLocation loc, const float* vals, size_t count = 1) const;
     void setUniform(UniformLocation loc, const glm::vec2& val) const;
@@ -143,29 +209,57 @@ public:
     void setUniform(UniformLocation loc, const glm::mat4& val) const;
     void setUniform(UniformLocation loc, const glm::mat4* vals, size_t count = 1) const;
 
-    /*void setUniform(UniformLocation loc, const Texture& tex) const
-    {
-        bind();
-        int unit = tex.getUnit();
-        assert(unit >= 0);
-        glUniform1i(loc, unit);
-    }
+    // All of these skip the GL call if the values are the same as the ones that were last set at
+    // that location (see State::Statistics). This only works if you don't call glUniform* for this
+    // program yourself.
 
-    void setUniform(UniformLocation loc, const Texture& tex, int unit) const
-    {
-        bind();
-        tex.bind(unit);
-        glUniform1i(loc, unit);
-    }*/
+    // Sets a sampler uniform. The texture is bound to a unit from State::allocateTextureUnit, so
+    // textures that are used by many draws keep their unit and are not rebound every time.
+    void setUniform(UniformLocation loc, const Texture& tex) const;
+    void setUniform(UniformLocation loc, const Texture& tex, unsigned int unit) const;
+
+    // Sets every uniform of this program that has a value in the shadow copy of `other` (i.e. was
+    // set through setUniform) and the same name and type, to that value. This is for rebuilding a
+    // program (e.g. hot reloading) without losing its uniform values. Unsigned and double
+    // uniforms and non-square matrices are skipped, since they can't be set with setUniform.
+    void copyUniformValues(const ShaderProgram& other) const;
 
 private:
+    // Every element of an array has its own location and slot, which points into the same data as
+    // the slot of the array, so setting the whole array or single elements updates the same values.
+    struct ShadowSlot {
+        uint32_t offset = 0;
+        // Up to the end of the uniform (for arrays the end of the whole array)
+        uint32_t size = 0;
+        uint32_t elementSize = 0;
+        // Index in shadowKnown_ of the element at offset
+        uint32_t element = 0;
+    };
+
+    // Locations above this are not shadowed, so a driver with huge locations can't make us
+    // allocate a huge slot array.
+    static constexpr size_t maxShadowLocation = 4096;
+
+    void retrieveAttributeInfo();
     void retrieveUniformInfo();
+    void retrieveUniformBlockInfo();
+    void addShadowSlots(const UniformInfo& info);
+    // Returns false if the values are the same as the ones last set at that location, in which case
+    // the glUniform* call can be skipped.
+    bool updateShadow(UniformLocation loc, const void* data, size_t size) const;
 
     GLuint program_ = 0;
     std::vector<GLuint> attachedShaders_;
     mutable std::unordered_map<std::string, UniformLocation> attribLocations_;
-    mutable std::unordered_map<std::string, UniformLocation> uniformLocations_;
+    mutable UniformLocationTable uniformLocations_;
+    std::unordered_map<std::string, AttributeInfo> attributeInfo_;
     std::unordered_map<std::string, UniformInfo> uniformInfo_;
+    std::unordered_map<std::string, UniformBlockInfo> uniformBlockInfo_;
+    // A copy of the uniform values (for the default uniform block), indexed by location
+    mutable std::vector<ShadowSlot> shadowSlots_;
+    mutable std::vector<uint8_t> shadowData_;
+    // One per array element (or uniform), 1 if shadowData_ holds the value last set for it
+    mutable std::vector<uint8_t> shadowKnown_;
 };
 
 }
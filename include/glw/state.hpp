@@ -2,6 +2,7 @@
 
 #include <array>
 #include <cassert>
+#include <cstdint>
 #include <cstdlib>
 #include <optional>
 #include <tuple>
@@ -61,16 +62,142 @@ enum BlendFunc : GLenum {
     OneMinusSrc1Alpha = GL_ONE_MINUS_SRC1_ALPHA,
 };
 
+enum class StencilOp : GLenum {
+    Keep = GL_KEEP,
+    Zero = GL_ZERO,
+    Replace = GL_REPLACE,
+    Incr = GL_INCR,
+    IncrWrap = GL_INCR_WRAP,
+    Decr = GL_DECR,
+    DecrWrap = GL_DECR_WRAP,
+    Invert = GL_INVERT,
+};
+
 struct BlendFuncSeparate {
     BlendFunc srcRgb;
     BlendFunc srcAlpha;
     BlendFunc dstRgb;
     BlendFunc dstAlpha;
+
+    bool operator==(const BlendFuncSeparate&) const = default;
 };
 
 struct BlendEquationRgba {
     BlendEquation rgb;
     BlendEquation a;
+
+    bool operator==(const BlendEquationRgba&) const = default;
+};
+
+struct StencilFaceState {
+    DepthFunc func = DepthFunc::Always;
+    int ref = 0;
+    GLuint readMask = ~0u;
+    GLuint writeMask = ~0u;
+    StencilOp stencilFail = StencilOp::Keep;
+    StencilOp depthFail = StencilOp::Keep;
+    StencilOp depthPass = StencilOp::Keep;
+
+    bool operator==(const StencilFaceState&) const = default;
+};
+
+// A complete block of fixed function state, so you don't have to call a bunch of setters before
+// every draw. It's immutable and hashed on construction, so it can be compared (and used as a key)
+// cheaply. Apply it with State::apply.
+// All members of Desc default to the initial GL values.
+class PipelineState {
+public:
+    struct Desc {
+        struct Depth {
+            bool test = false;
+            bool write = true;
+            DepthFunc func = DepthFunc::Less;
+
+            bool operator==(const Depth&) const = default;
+        };
+
+        struct Cull {
+            bool enabled = false;
+            FaceCullMode mode = FaceCullMode::Back;
+            FrontFaceMode frontFace = FrontFaceMode::Ccw;
+
+            bool operator==(const Cull&) const = default;
+        };
+
+        struct Blend {
+            bool enabled = false;
+            BlendFuncSeparate func = {
+                .srcRgb = BlendFunc::One,
+                .srcAlpha = BlendFunc::One,
+                .dstRgb = BlendFunc::Zero,
+                .dstAlpha = BlendFunc::Zero,
+            };
+            BlendEquationRgba equation = { .rgb = BlendEquation::Add, .a = BlendEquation::Add };
+            std::tuple<float, float, float, float> color = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+            bool operator==(const Blend&) const = default;
+        };
+
+        struct ColorMask {
+            bool r = true;
+            bool g = true;
+            bool b = true;
+            bool a = true;
+
+            bool operator==(const ColorMask&) const = default;
+        };
+
+        struct Stencil {
+            bool enabled = false;
+            StencilFaceState front;
+            StencilFaceState back;
+
+            bool operator==(const Stencil&) const = default;
+        };
+
+        struct Scissor {
+            bool enabled = false;
+            int x = 0;
+            int y = 0;
+            size_t width = 0;
+            size_t height = 0;
+
+            bool operator==(const Scissor&) const = default;
+        };
+
+        // Only GL_POLYGON_OFFSET_FILL
+        struct PolygonOffset {
+            bool enabled = false;
+            float factor = 0.0f;
+            float units = 0.0f;
+
+            bool operator==(const PolygonOffset&) const = default;
+        };
+
+        Depth depth;
+        Cull cull;
+        Blend blend;
+        ColorMask colorMask;
+        Stencil stencil;
+        Scissor scissor;
+        PolygonOffset polygonOffset;
+
+        bool operator==(const Desc&) const = default;
+    };
+
+    PipelineState() = default;
+    explicit PipelineState(const Desc& desc);
+
+    const Desc& getDesc() const;
+    size_t getHash() const;
+
+    bool operator==(const PipelineState& other) const;
+
+private:
+    static size_t hash(const Desc& desc);
+
+    Desc desc_;
+    size_t hash_ = hash(Desc {});
 };
 
 class State {
@@ -81,23 +208,61 @@ public:
         size_t textureBinds = 0;
         size_t frameBufferBinds = 0;
         size_t drawCalls = 0;
+        // GL calls issued and skipped by apply(const PipelineState&)
+        size_t pipelineStateCalls = 0;
+        size_t pipelineStateCallsElided = 0;
+        // glUniform* calls issued and skipped by ShaderProgram::setUniform, because the value
+        // didn't change
+        size_t uniformUpdates = 0;
+        size_t uniformUpdatesSkipped = 0;
+        // glBindBufferRange/glBindBufferBase calls for GL_UNIFORM_BUFFER
+        size_t uniformBufferBinds = 0;
     };
 
     // GL_MAX_TEXTURE_IMAGE_UNITS is 16 in GL 3.3
     static constexpr size_t maxTextureUnits = 16;
+    // GL_MAX_UNIFORM_BUFFER_BINDINGS is 36 in GL 3.3
+    static constexpr size_t maxUniformBufferBindings = 36;
 
+    // Bindings are per context, so there should be one State per GL context. The current State is
+    // thread-local and has to be switched together with the context (glwx::Window does that).
+    // If no State was made current on this thread, a default one (per thread) is used, so for a
+    // single context you don't have to do anything.
     static State& instance();
+    static State* getCurrent();
+    static void setCurrent(State* state);
+
+    State() = default;
+    ~State();
 
-    ~State() = default;
+    State(const State&) = delete;
+    State& operator=(const State&) = delete;
 
     void resetStatistics();
     Statistics& getStatistics();
 
+    // If ARB_direct_state_access (core in 4.5) is available, Texture and Buffer are created and
+    // modified without binding them, so edits don't disturb the bindings tracked here.
+    // You can disable it (e.g. to test the fallback), but enabling it won't make it supported.
+    bool getDirectStateAccess() const;
+    void setDirectStateAccess(bool enabled);
+
     std::tuple<int, int, size_t, size_t> getViewport() const;
     void setViewport(int x, int y, size_t width, size_t height);
     void setViewport(const std::tuple<int, int, size_t, size_t>& viewport);
     void setViewport(size_t width, size_t height);
 
+    // Only issues the GL calls for state that differs from the current state. State that has
+    // no effect while the corresponding feature is disabled (e.g. the blend func while blending
+    // is disabled) is not applied either, with the exception of the depth, color and stencil
+    // write masks, since they affect glClear.
+    void apply(const PipelineState& pipelineState);
+    // The state that is currently set, with the caveat above
+    const PipelineState::Desc& getPipelineState() const;
+
+    bool getDepthTestEnabled() const;
+    void setDepthTestEnabled(bool enabled);
+
     DepthFunc getDepthFunc() const;
     void setDepthFunc(DepthFunc func);
 
@@ -142,10 +307,28 @@ public:
     void bindBuffer(GLenum target, GLuint buffer);
     void unbindBuffer(GLenum target);
 
+    // Indexed bindings (GL_UNIFORM_BUFFER and GL_TRANSFORM_FEEDBACK_BUFFER). These also change the
+    // generic binding of the target. Only the uniform buffer bindings are tracked, so redundant
+    // binds of the same range are skipped for those.
+    void bindBufferBase(GLenum target, unsigned int index, GLuint buffer);
+    void bindBufferRange(
+        GLenum target, unsigned int index, GLuint buffer, size_t offset, size_t size);
+    // Deleting a buffer unbinds it from every (indexed) binding point, so this forgets those
+    // bindings. Otherwise a new buffer with the same name would be considered bound already.
+    void bufferDeleted(GLuint buffer);
+
     GLuint getCurrentTexture(unsigned int unit, GLenum target) const;
     std::optional<unsigned int> getTextureUnit(GLenum target, GLuint texture) const;
     void bindTexture(unsigned int unit, GLenum target, GLuint texture);
+    // Returns a unit the texture is already bound to, or binds it to the least recently used unit
+    // and returns that. Unit 0 is never used, because Texture binds to it for editing (even with
+    // DSA, some paths like image() need a binding). As long as a draw call uses less than
+    // maxTextureUnits - 1 textures, allocating units for its textures will never evict one of the
+    // others.
+    unsigned int allocateTextureUnit(GLenum target, GLuint texture);
     void unbindTexture(unsigned int unit, GLenum target);
+    // Like bufferDeleted: GL unbinds a deleted texture from every unit and the name may be reused.
+    void textureDeleted(GLuint texture);
 
     GLuint getCurrentFramebuffer(GLenum target) const;
     void bindFramebuffer(GLenum target, GLuint fbo);
@@ -202,33 +385,37 @@ private:
         std::abort();
     }
 
+    struct IndexedBufferBinding {
+        GLuint buffer = 0;
+        size_t offset = 0;
+        // 0 for glBindBufferBase
+        size_t size = 0;
+
+        bool operator==(const IndexedBufferBinding&) const = default;
+    };
+
     static size_t getBufferIndex(GLenum target);
+    // Returns false if the binding is already current
+    bool updateIndexedBinding(GLenum target, unsigned int index, const IndexedBufferBinding& b);
     static size_t getTextureIndex(GLenum target);
 
-    State() = default;
-    State(const State&) = delete;
-    State& operator=(const State&) = delete;
-
     Statistics statistics_;
+    bool directStateAccess_ = true;
     std::tuple<int, int, size_t, size_t> viewport_ = { 0, 0, 0, 0 };
-    DepthFunc depthFunc_ = DepthFunc::Less;
-    bool depthWrite_ = true;
-    bool cullFaceEnabled_ = false;
-    FrontFaceMode frontFaceMode_ = FrontFaceMode::Ccw;
-    FaceCullMode faceCullMode_ = FaceCullMode::Back;
-    bool blendEnabled_ = false;
-    std::tuple<float, float, float, float> blendColor_ = { 0.0f, 0.0f, 0.0f, 0.0f };
-    BlendFuncSeparate blendFunc_ = {
-        .srcRgb = BlendFunc::One,
-        .srcAlpha = BlendFunc::One,
-        .dstRgb = BlendFunc::Zero,
-        .dstAlpha = BlendFunc::Zero,
-    };
-    BlendEquationRgba blendEquation_ = { .rgb = BlendEquation::Add, .a = BlendEquation::Add };
+    PipelineState::Desc pipeline_;
+    // If the last apply() was called with this and no setter has been called since, we can skip
+    // the whole diff.
+    std::optional<PipelineState> appliedPipelineState_;
     GLuint vao_ = 0;
     GLuint shaderProgram_ = 0;
-    std::array<GLuint, bufferBindings.size()> buffers_;
-    std::array<std::array<GLuint, textureBindings.size()>, maxTextureUnits> textures_ {};
+    std::array<GLuint, bufferBindings.size()> buffers_ {};
+    std::array<IndexedBufferBinding, maxUniformBufferBindings> uniformBuffers_ {};
+    // Indexed by [target][unit], so looking for a texture in all units touches a single cache line
+    std::array<std::array<GLuint, maxTextureUnits>, textureBindings.size()> textures_ {};
+    // For allocateTextureUnit. Every bind "uses" a unit.
+    std::array<uint64_t, maxTextureUnits> textureUnitLastUse_ {};
+    uint64_t textureUnitClock_ = 0;
+    unsigned int activeTextureUnit_ = 0;
     GLuint readFramebuffer_ = 0;
     GLuint drawFramebuffer_ = 0;
     GLuint renderbuffer_ = 0;
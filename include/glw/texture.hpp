@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <optional>
 
 #include <glad/glad.h>
 #include <glm/vec4.hpp>
@@ -116,6 +117,9 @@ public:
         One = GL_ONE,
     };
 
+    // Size of a single pixel in client memory (without any row alignment)
+    static size_t getPixelSize(DataFormat dataFormat, DataType dataType);
+
     Texture() = default;
     Texture(Target target);
     ~Texture();
@@ -129,6 +133,8 @@ public:
     void free() const;
 
     void bind(unsigned int unit) const;
+    // Binds to a unit chosen by State::allocateTextureUnit and returns it
+    unsigned int bind() const;
 
     void bind(unsigned int unit, Target target) const;
 
@@ -145,13 +151,37 @@ public:
         DataFormat dataFormat, DataType dataType, const void* data) const;
     // common use-case variants
     void subImage(DataFormat dataFormat, DataType dataType, const void* data) const;
+    // Uploads the whole level (the size of the level is derived from the size of level 0)
     void subImage(size_t level, DataFormat dataFormat, DataType dataType, const void* data);
 
+    // For block-compressed formats, data is imageSize bytes of compressed blocks
+    // (see getCompressedImageSize). x, y, width and height of sub images have to be multiples of
+    // 4, except at the right and bottom edge of the level.
+    void compressedImage(Target target, size_t level, ImageFormat imageFormat, size_t width,
+        size_t height, size_t imageSize, const void* data);
+    void compressedSubImage(Target target, size_t level, size_t x, size_t y, size_t width,
+        size_t height, size_t imageSize, const void* data) const;
+    // Uploads the whole level
+    void compressedSubImage(size_t level, size_t imageSize, const void* data) const;
+
+    // glTexStorage requires ARB_texture_storage (core in 4.2). storage() falls back to allocating
+    // every level with glTexImage if it is not supported, which works, but leaves the texture
+    // mutable and the driver has to check the mip chain for completeness on every draw.
+    static bool storageSupported();
+
+    // Allocates all levels (levels = 0 means a full mip chain) at once. If glTexStorage is used,
+    // the texture is immutable afterwards (see isImmutable) and image() must not be called anymore.
+    // Base formats (e.g. Rgba) are replaced by the corresponding sized formats (e.g. Rgba8).
+    // target may be Texture2D, TextureRectangle or TextureCubeMap (which allocates all faces).
     void storage(
         Target target, size_t levels, ImageFormat imageFormat, size_t width, size_t height);
 
     void storage(size_t levels, ImageFormat imageFormat, size_t width, size_t height);
 
+    // For Texture3D and Texture2DArray (depth is the number of layers)
+    void storage(
+        size_t levels, ImageFormat imageFormat, size_t width, size_t height, size_t depth);
+
     void generateMipmaps() const;
 
     void setWrapS(WrapMode wrap);
@@ -183,10 +213,15 @@ public:
     GLuint getTexture() const;
     size_t getWidth() const;
     size_t getHeight() const;
+    size_t getDepth() const;
     ImageFormat getImageFormat() const;
+    // Number of levels allocated by storage(), 0 if storage() was not used
+    size_t getLevels() const;
+    bool isImmutable() const;
 
 private:
     static DataFormat getStorageFormat(ImageFormat format);
+    static std::optional<size_t> getCubeMapFace(Target target);
 
     size_t getMaxNumMipLevels() const;
 
@@ -199,7 +234,10 @@ private:
     GLuint texture_ = 0;
     size_t width_ = 0;
     size_t height_ = 0;
+    size_t depth_ = 1;
     ImageFormat imageFormat_ = ImageFormat::Invalid;
+    size_t levels_ = 0;
+    bool immutable_ = false;
 };
 
 }
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cassert>
+#include <charconv>
+#include <concepts>
+#include <string>
+#include <string_view>
+
+#include "glw/shader.hpp"
+
+namespace glw {
+template <typename T>
+concept UniformHandleType = std::same_as<T, int> || std::same_as<T, float>
+    || std::same_as<T, glm::vec2> || std::same_as<T, glm::vec3> || std::same_as<T, glm::vec4>
+    || std::same_as<T, glm::mat2> || std::same_as<T, glm::mat3> || std::same_as<T, glm::mat4>
+    || std::same_as<T, Texture>;
+
+// Whether glUniform* for T may be used for a uniform of that type. Bools can be set with either
+// ints or floats and samplers with ints.
+template <UniformHandleType T>
+constexpr bool isCompatibleUniformType(UniformInfo::Type type)
+{
+    using Type = UniformInfo::Type;
+    if constexpr (std::same_as<T, int>)
+        return type == Type::Int || type == Type::Bool || isSamplerType(type);
+    else if constexpr (std::same_as<T, float>)
+        return type == Type::Float || type == Type::Bool;
+    else if constexpr (std::same_as<T, glm::vec2>)
+        return type == Type::Vec2 || type == Type::BVec2;
+    else if constexpr (std::same_as<T, glm::vec3>)
+        return type == Type::Vec3 || type == Type::BVec3;
+    else if constexpr (std::same_as<T, glm::vec4>)
+        return type == Type::Vec4 || type == Type::BVec4;
+    else if constexpr (std::same_as<T, glm::mat2>)
+        return type == Type::Mat2;
+    else if constexpr (std::same_as<T, glm::mat3>)
+        return type == Type::Mat3;
+    else if constexpr (std::same_as<T, glm::mat4>)
+        return type == Type::Mat4;
+    else
+        return isSamplerType(type);
+}
+
+// A handle to a uniform of a specific program, which is looked up (and type-checked) once, so
+// setting it afterwards does not involve any lookups at all.
+// If the uniform is not active (e.g. it was optimized out) or has a different type, the handle
+// is invalid. Setting an invalid handle is fine and does nothing (GL ignores location -1).
+// The location is cached, so if the program is relinked (e.g. by ShaderWatcher), get new handles.
+template <UniformHandleType T>
+class Uniform {
+public:
+    Uniform() = default;
+
+    // name may also refer to an element of an array, e.g. "lights[2]"
+    Uniform(const ShaderProgram& program, UniformName name)
+        : program_(&program)
+    {
+        const auto& infos = program.getUniformInfo();
+        auto it = infos.find(std::string(name.getName()));
+        size_t element = 0;
+        if (it == infos.end()) {
+            // Element names are not in the uniform info (only the first one)
+            const auto str = name.getName();
+            const auto bracket = str.find('[');
+            if (bracket == std::string_view::npos || str.back() != ']')
+                return;
+            const auto index = str.substr(bracket + 1, str.size() - bracket - 2);
+            const auto end = index.data() + index.size();
+            const auto [ptr, ec] = std::from_chars(index.data(), end, element);
+            if (ec != std::errc() || ptr != end)
+                return;
+            it = infos.find(std::string(str.substr(0, bracket)));
+            if (it == infos.end() || element >= static_cast<size_t>(it->second.size))
+                return;
+        }
+        const auto& info = it->second;
+        if (!isCompatibleUniformType<T>(info.type)) {
+            LOG_ERROR("Uniform '{}' has type {:#x}, which does not match the type of the handle",
+                name.getName(), static_cast<GLenum>(info.type));
+            return;
+        }
+        location_ = element == 0 ? info.location : program.getUniformLocation(name);
+        size_ = location_ != ShaderProgram::invalidLocation ? info.size - element : 0;
+    }
+
+    bool isValid() const
+    {
+        return location_ != ShaderProgram::invalidLocation;
+    }
+
+    ShaderProgram::UniformLocation getLocation() const
+    {
+        return location_;
+    }
+
+    // The number of array elements, starting at the element the handle refers to
+    size_t getSize() const
+    {
+        return size_;
+    }
+
+    void set(const T& value) const
+    {
+        assert(program_);
+        program_->setUniform(location_, value);
+    }
+
+    void set(const T* values, size_t count) const
+        requires(!std::same_as<T, Texture>)
+    {
+        assert(program_);
+        assert(!isValid() || count <= size_);
+        program_->setUniform(location_, values, count);
+    }
+
+private:
+    const ShaderProgram* program_ = nullptr;
+    ShaderProgram::UniformLocation location_ = ShaderProgram::invalidLocation;
+    size_t size_ = 0;
+};
+}
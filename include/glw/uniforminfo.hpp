@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 
 #include "glad/glad.h"
 
@@ -77,5 +78,81 @@ public:
     int index = -1;
     int size = 0;
     Type type = Type::Invalid;
+    // -1 for uniforms in uniform blocks
+    GLint location = -1;
+};
+
+constexpr bool isSamplerType(UniformInfo::Type type)
+{
+    using T = UniformInfo::Type;
+    switch (type) {
+    case T::Sampler1D:
+    case T::Sampler2D:
+    case T::Sampler3D:
+    case T::SamplerVube:
+    case T::Sampler1DShadow:
+    case T::Sampler2DShadow:
+    case T::Sampler1DArray:
+    case T::Sampler2DArray:
+    case T::Sampler1DArrayshadow:
+    case T::Sampler2DArrayshadow:
+    case T::Sampler2DMs:
+    case T::Sampler2DMsArray:
+    case T::SamplerCubeShadow:
+    case T::SamplerBuffer:
+    case T::Sampler2DRect:
+    case T::Sampler2DRectShadow:
+    case T::ISampler1D:
+    case T::ISampler2D:
+    case T::ISampler3D:
+    case T::ISamplercube:
+    case T::ISampler1DArray:
+    case T::ISampler2DArray:
+    case T::ISampler2DMs:
+    case T::ISampler2DMsArray:
+    case T::ISamplerBuffer:
+    case T::ISampler2DRect:
+    case T::USampler1D:
+    case T::USampler2D:
+    case T::USampler3D:
+    case T::USamplerCube:
+    case T::USampler1DArray:
+    case T::USampler2DArray:
+    case T::USampler2DMs:
+    case T::USampler2DMsArray:
+    case T::USamplerBuffer:
+    case T::USampler2DRect:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Uniforms in a uniform block have no location. Instead they live at fixed offsets in the buffer
+// range that is bound to the block's binding point.
+class UniformBlockInfo {
+public:
+    struct Member {
+        std::string name = {};
+        UniformInfo::Type type = UniformInfo::Type::Invalid;
+        // Number of array elements (1 for non-arrays)
+        int size = 0;
+        size_t offset = 0;
+        // 0 if the member is not an array
+        size_t arrayStride = 0;
+        // Distance between columns (or rows, if rowMajor). 0 if the member is not a matrix.
+        size_t matrixStride = 0;
+        bool rowMajor = false;
+    };
+
+    std::string name = {};
+    GLuint index = GL_INVALID_INDEX;
+    // The minimum size of the buffer range bound to this block
+    size_t size = 0;
+    GLuint binding = 0;
+    // Keyed like ShaderProgram::getUniformInfo (arrays are present with and without "[0]").
+    // If the block has an instance name, the member names are prefixed with the block name
+    // (not the instance name!), e.g. "Camera.viewMatrix".
+    std::unordered_map<std::string, Member> members = {};
 };
 }
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "glad/glad.h"
+
+namespace glw {
+// FNV-1a. Never returns 0, because UniformLocationTable uses that for empty slots.
+constexpr uint64_t hashUniformName(std::string_view name)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (const auto c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3;
+    }
+    return hash != 0 ? hash : 1;
+}
+
+// A uniform name with its hash. String literals convert to this implicitly and are hashed at
+// compile time, so prog.setUniform("modelMatrix", m) does not allocate or hash anything.
+// The name has to outlive the UniformName and be null-terminated (it might be passed to
+// glGetUniformLocation), which string literals are.
+class UniformName {
+public:
+    template <size_t N>
+    consteval UniformName(const char (&name)[N])
+        : name_(name, N - 1)
+        , hash_(hashUniformName(name_))
+    {
+    }
+
+    // For names that are only known at runtime
+    explicit constexpr UniformName(std::string_view name)
+        : name_(name)
+        , hash_(hashUniformName(name))
+    {
+    }
+
+    constexpr std::string_view getName() const
+    {
+        return name_;
+    }
+
+    constexpr uint64_t getHash() const
+    {
+        return hash_;
+    }
+
+private:
+    std::string_view name_;
+    uint64_t hash_;
+};
+
+// Anything that is a string, but not a string literal (those become UniformNames)
+template <typename T>
+concept RuntimeString = std::convertible_to<const T&, std::string_view> && !std::is_array_v<T>;
+
+// An open-addressing (linear probing) hash table from name hashes to locations. It's a flat array,
+// so a lookup usually touches a single cache line.
+class UniformLocationTable {
+public:
+    std::optional<GLint> find(uint64_t hash) const
+    {
+        if (entries_.empty())
+            return std::nullopt;
+        const auto mask = entries_.size() - 1;
+        for (auto i = static_cast<size_t>(hash) & mask;; i = (i + 1) & mask) {
+            if (entries_[i].hash == hash)
+                return entries_[i].location;
+            if (entries_[i].hash == 0)
+                return std::nullopt;
+        }
+    }
+
+    // Overwrites the location, if the hash is already present
+    void insert(uint64_t hash, GLint location);
+
+    void clear();
+    size_t size() const;
+
+private:
+    struct Entry {
+        uint64_t hash = 0; // 0 means empty
+        GLint location = -1;
+    };
+
+    // Keep it at most half full, so probe sequences stay short
+    static constexpr size_t maxLoadDenominator = 2;
+
+    void rehash(size_t capacity);
+
+    std::vector<Entry> entries_;
+    size_t count_ = 0;
+};
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <stddef.h>
 #include <tuple>
 #include <utility>
@@ -38,6 +39,13 @@ std::vector<uint8_t> makeByteVector(Args&&... args)
 
 std::vector<uint8_t> makeByteVector();
 
+// Same as boost::hash_combine
+template <typename T>
+void hashCombine(size_t& seed, const T& v)
+{
+    seed ^= std::hash<T> {}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
 template <typename T>
 std::tuple<size_t, const uint8_t*, size_t> toOffsetPtrRange(
     size_t offset, const T* ptr, size_t count)
@@ -78,6 +78,7 @@ public:
 
     // add might obviously invalidate the pointers!
     const Attribute* get(size_t location) const;
+    const std::vector<Attribute>& getAttributes() const;
 
     // If offset is -1, it's set to getStride().
     // Sets the stride to max(stride, offset + attribute.getAlignedSize)
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "glw/shader.hpp"
+
+namespace glwx {
+// Resolves when the AsyncShaderCompiler that returned it has finished the program
+class ShaderProgramFuture {
+public:
+    ShaderProgramFuture() = default;
+
+    bool isReady() const;
+    // Only meaningful if ready
+    bool isSuccessful() const;
+    // Returns nullopt if the program is not ready yet or failed to compile or link. This moves the
+    // program out of the future, so you can only get it once.
+    std::optional<glw::ShaderProgram> get();
+
+private:
+    friend class AsyncShaderCompiler;
+
+    struct Shared {
+        bool ready = false;
+        std::optional<glw::ShaderProgram> program;
+    };
+
+    explicit ShaderProgramFuture(std::shared_ptr<Shared> shared);
+
+    std::shared_ptr<Shared> shared_;
+};
+
+// Issues all glCompileShader and glLinkProgram calls right away and only queries the results
+// (which blocks until the driver is done) once they are finished. With KHR_parallel_shader_compile
+// the driver compiles on its own threads and update() never blocks. Without it, update() resolves
+// everything in one go, which still lets drivers that compile in the background (some do anyway)
+// work on all programs at once.
+// Everything here must be called on the GL thread.
+class AsyncShaderCompiler {
+public:
+    using Stage = std::pair<glw::Shader::Type, std::string_view>;
+
+    // Passed to glMaxShaderCompilerThreadsKHR. The default lets the driver decide.
+    explicit AsyncShaderCompiler(unsigned int maxThreads = 0xFFFFFFFF);
+
+    AsyncShaderCompiler(const AsyncShaderCompiler&) = delete;
+    AsyncShaderCompiler& operator=(const AsyncShaderCompiler&) = delete;
+
+    AsyncShaderCompiler(AsyncShaderCompiler&&) = default;
+    AsyncShaderCompiler& operator=(AsyncShaderCompiler&&) = default;
+
+    ShaderProgramFuture add(const std::vector<Stage>& stages);
+    ShaderProgramFuture add(std::string_view vertSource, std::string_view fragSource);
+
+    // Resolves the futures of all finished programs. Call this regularly (e.g. once per frame on a
+    // loading screen).
+    void update();
+
+    // Blocks until all programs are finished
+    void finish();
+
+    size_t getPendingCount() const;
+
+private:
+    struct Job {
+        std::vector<glw::Shader> shaders;
+        glw::ShaderProgram program;
+        std::shared_ptr<ShaderProgramFuture::Shared> shared;
+    };
+
+    static void resolve(Job& job);
+
+    std::deque<Job> jobs_;
+};
+}
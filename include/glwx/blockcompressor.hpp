@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+
+#include "glw/imageformat.hpp"
+#include "glwx/compressedtexture.hpp"
+#include "glwx/mipmaps.hpp"
+#include "glwx/workerpool.hpp"
+
+namespace glwx {
+// Compresses 8 bit images into BC1 (DXT1), BC3 (DXT5), BC4 (RGTC1) or BC5 (RGTC2) on the CPU, so
+// textures that are only available as PNG/JPG can use 4-8x less memory on the GPU.
+// The blocks are distributed over the threads of a WorkerPool and the mip levels are generated
+// with a MipmapGenerator on the same pool. Like the MipmapGenerator, this does not use GL.
+class BlockCompressor {
+public:
+    enum class Format {
+        Bc1, // RGB (with 1 bit alpha if the image has 4 channels), 8 bytes per block
+        Bc3, // RGBA, 16 bytes per block
+        Bc4, // Only the first channel, 8 bytes per block
+        Bc5, // Only the first two channels (e.g. normal maps), 16 bytes per block
+    };
+
+    enum class Quality {
+        // Endpoints from the bounding box of the block. Good enough for previews.
+        Fast,
+        // Endpoints from the principal axis of the colors in the block, refined once
+        Normal,
+        // Like Normal, but refined until the error does not decrease anymore and tries more
+        // endpoints for BC4/BC5
+        High,
+    };
+
+    struct Options {
+        Format format = Format::Bc1;
+        Quality quality = Quality::Normal;
+        // Only for BC1 and BC3: Use the sRGB formats and generate the mipmaps in linear space
+        bool srgb = false;
+        bool mipmaps = true;
+        MipmapGenerator::Filter mipmapFilter = MipmapGenerator::Filter::Box;
+        // See MipmapGenerator::Options::alphaCutoff
+        float alphaCutoff = 0.0f;
+    };
+
+    static glw::ImageFormat getImageFormat(Format format, size_t channels, bool srgb);
+
+    explicit BlockCompressor(size_t threads = WorkerPool::getDefaultThreadCount());
+    explicit BlockCompressor(std::shared_ptr<WorkerPool> pool);
+
+    // data are tightly packed rows with 1 to 4 channels (like stb_image returns them).
+    // The channels are interpreted like readTexelRgba (glwx/utility.hpp) does.
+    CompressedTextureData compress(const uint8_t* data, size_t width, size_t height,
+        size_t channels, const Options& options) const;
+
+    // Compresses a single image with rows rowPitch bytes apart. dst has to be
+    // getCompressedImageSize(getImageFormat(format, ...), width, height) bytes.
+    void compressImage(const uint8_t* data, size_t width, size_t height, size_t channels,
+        size_t rowPitch, Format format, Quality quality, uint8_t* dst) const;
+
+private:
+    std::shared_ptr<WorkerPool> pool_;
+    MipmapGenerator mipmaps_;
+};
+
+// Caches the results of BlockCompressor on disk as KTX files. Entries are keyed by a hash of the
+// source data (the pixels or the encoded file) and the options.
+class CompressedTextureCache {
+public:
+    struct Statistics {
+        size_t hits = 0;
+        size_t misses = 0;
+        // Cache files that existed, but could not be loaded
+        size_t rejected = 0;
+    };
+
+    // The directory is created if it doesn't exist
+    explicit CompressedTextureCache(std::filesystem::path directory);
+
+    // data can be anything that determines the image, e.g. the contents of a PNG file, so it does
+    // not have to be decoded if it's in the cache already.
+    static uint64_t getKey(
+        const void* data, size_t size, const BlockCompressor::Options& options);
+
+    std::optional<CompressedTextureData> load(uint64_t key);
+    void store(uint64_t key, const CompressedTextureData& data) const;
+
+    // Compresses the image, unless it is in the cache already
+    CompressedTextureData compress(const BlockCompressor& compressor, const uint8_t* data,
+        size_t width, size_t height, size_t channels, const BlockCompressor::Options& options);
+
+    // Removes all cache files
+    void clear();
+
+    const Statistics& getStatistics() const;
+
+private:
+    std::filesystem::path getPath(uint64_t key) const;
+
+    std::filesystem::path directory_;
+    Statistics statistics_;
+};
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cassert>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "glw/buffer.hpp"
+#include "glw/utility.hpp"
+
+namespace glwx {
+// Sub-allocates vertex and index data from a few large buffers ("pages"), so many meshes can share
+// the same buffers (and therefore the same vertex array, see Primitive::getRange).
+// This is a best-fit free list allocator that coalesces adjacent free blocks.
+class BufferHeap {
+public:
+    struct Allocation {
+        const glw::Buffer* buffer = nullptr;
+        size_t offset = 0;
+        size_t size = 0;
+
+        explicit operator bool() const;
+    };
+
+    static constexpr size_t defaultPageSize = 32 * 1024 * 1024;
+
+    explicit BufferHeap(glw::Buffer::UsageHint usage = glw::Buffer::UsageHint::StaticDraw,
+        size_t pageSize = defaultPageSize);
+
+    BufferHeap(const BufferHeap&) = delete;
+    BufferHeap& operator=(const BufferHeap&) = delete;
+
+    BufferHeap(BufferHeap&&) = default;
+    BufferHeap& operator=(BufferHeap&&) = default;
+
+    // The offset of the allocation will be a multiple of alignment, which does not have to be a
+    // power of two. Pass the vertex stride or index size to be able to express the offset in
+    // vertices/indices. Allocations larger than the page size get a page of their own.
+    Allocation allocate(size_t size, size_t alignment = 4);
+
+    void free(const Allocation& allocation);
+
+    // Like Buffer::subData, offset is relative to the start of the allocation
+    template <typename... Args>
+    void write(const Allocation& allocation, size_t offset, Args&&... args) const
+    {
+        const auto [byteOffset, data, size]
+            = glw::toOffsetPtrRange(offset, std::forward<Args>(args)...);
+        writeBytes(allocation, byteOffset, data, size);
+    }
+
+    template <typename... Args>
+    void write(const Allocation& allocation, Args&&... args) const
+    {
+        const auto [data, size] = glw::toPtrRange(std::forward<Args>(args)...);
+        writeBytes(allocation, 0, data, size);
+    }
+
+    size_t getPageCount() const;
+    const glw::Buffer& getBuffer(size_t page) const;
+
+    // In bytes
+    size_t getAllocatedSize() const;
+    size_t getCapacity() const;
+
+private:
+    struct Page {
+        glw::Buffer buffer;
+        size_t size;
+        // offset -> size
+        std::map<size_t, size_t> freeBlocks;
+    };
+
+    struct BlockRef {
+        Page* page;
+        size_t offset;
+    };
+
+    void writeBytes(
+        const Allocation& allocation, size_t offset, const void* data, size_t size) const;
+
+    void insertFreeBlock(Page* page, size_t offset, size_t size);
+    void eraseFreeBlock(Page* page, size_t offset, size_t size);
+
+    Page* addPage(size_t size);
+
+    glw::Buffer::UsageHint usage_;
+    size_t pageSize_;
+    // The pages are heap-allocated, so Allocation::buffer stays valid when adding pages
+    std::vector<std::unique_ptr<Page>> pages_;
+    // size -> block, for best fit lookup
+    std::multimap<size_t, BlockRef> freeBlocksBySize_;
+    size_t allocatedSize_ = 0;
+};
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cassert>
+#include <span>
 #include <vector>
 
 #include "glw/buffer.hpp"
@@ -68,8 +69,19 @@ struct DefaultBuffer : public glw::Buffer {
 };
 
 // This class saves a GL Buffer and it's local data.
+// It also keeps track of which parts of the local data have been modified (dirty ranges), so
+// update() only has to upload those.
 class BufferData : public DefaultBuffer {
 public:
+    struct DirtyRange {
+        size_t offset;
+        size_t size;
+    };
+
+    // Dirty ranges that are at most this many bytes apart are merged, because a single larger
+    // glBufferSubData is usually cheaper than many small ones.
+    static constexpr size_t defaultCoalesceThreshold = 256;
+
     template <typename... Args>
     BufferData(Buffer::Target target, Buffer::UsageHint usage, Args&&... args)
         : DefaultBuffer(target, usage)
@@ -85,16 +97,37 @@ public:
     BufferData(BufferData&&) = default;
     BufferData& operator=(BufferData&&) = default;
 
+    // setData and update reset the dirty ranges, setSubData does not.
     void setData();
     void setSubData(size_t index, size_t len) const;
     void setSubData() const;
+    // Reallocates the buffer if it's too small, otherwise uploads the dirty ranges only
     void update();
 
+    void markDirty(size_t offset, size_t size);
+    void markDirty(); // everything
+    const std::vector<DirtyRange>& getDirtyRanges() const;
+
+    void setCoalesceThreshold(size_t threshold);
+    size_t getCoalesceThreshold() const;
+
+    // We can't know what you do with the vector, so this marks everything dirty.
+    // Prefer the ranged overload or the accessors (VertexAccessor, IndexAccessor) if you only
+    // modify a small part of the data.
     std::vector<uint8_t>& getData();
+    // Marks only [offset, offset + size) dirty
+    std::span<uint8_t> getData(size_t offset, size_t size);
     const std::vector<uint8_t>& getData() const;
 
+protected:
+    // Only marks the added bytes dirty
+    void resizeData(size_t size);
+
 private:
     std::vector<uint8_t> data_;
+    // Sorted by offset and never closer than coalesceThreshold_ to each other
+    std::vector<DirtyRange> dirtyRanges_;
+    size_t coalesceThreshold_ = defaultCoalesceThreshold;
 };
 
 class VertexBuffer : public BufferData {
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "glw/shader.hpp"
+#include "glw/state.hpp"
+#include "glw/texture.hpp"
+#include "glwx/primitive.hpp"
+
+namespace glwx {
+// Records binds, uniform sets, state changes and draws into a linear arena without touching GL,
+// so scene traversal and draw preparation can be spread across threads. submit() replays the
+// commands on the GL thread and goes through glw::State, so redundant shader, texture, vertex
+// array and pipeline state changes are skipped.
+// Every thread should record into its own CommandBuffer, which are then submitted in whatever
+// order you want. Uniform locations have to be looked up beforehand (that needs GL) and all
+// recorded objects (programs, textures, primitives) must stay alive until they are submitted.
+class CommandBuffer {
+public:
+    using UniformLocation = glw::ShaderProgram::UniformLocation;
+
+    template <typename T>
+    static constexpr bool isUniformType = std::is_same_v<T, int> || std::is_same_v<T, float>
+        || std::is_same_v<T, glm::vec2> || std::is_same_v<T, glm::vec3>
+        || std::is_same_v<T, glm::vec4> || std::is_same_v<T, glm::mat2>
+        || std::is_same_v<T, glm::mat3> || std::is_same_v<T, glm::mat4>;
+
+    static constexpr size_t defaultCapacity = 64 * 1024;
+
+    // Capacity is only the initial size of the arena (in bytes), it grows as needed
+    explicit CommandBuffer(size_t capacity = defaultCapacity);
+
+    CommandBuffer(const CommandBuffer&) = delete;
+    CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+    CommandBuffer(CommandBuffer&&) = default;
+    CommandBuffer& operator=(CommandBuffer&&) = default;
+
+    void bindShader(const glw::ShaderProgram& program);
+
+    // Uniforms are set on the program of the last bindShader in this command buffer.
+    // The values are copied.
+    template <typename T>
+    requires isUniformType<T>
+    void setUniform(UniformLocation loc, const T& value)
+    {
+        setUniform(loc, &value, 1);
+    }
+
+    template <typename T>
+    requires isUniformType<T>
+    void setUniform(UniformLocation loc, const T* vals, size_t count)
+    {
+        recordUniform(getUniformType<T>(), loc, vals, sizeof(T) * count, count);
+    }
+
+    // The unit is allocated when submitting (see glw::State::allocateTextureUnit)
+    void setUniform(UniformLocation loc, const glw::Texture& tex);
+    void setUniform(UniformLocation loc, const glw::Texture& tex, unsigned int unit);
+
+    void bindTexture(unsigned int unit, const glw::Texture& tex);
+
+    // The pipeline state is copied
+    void apply(const glw::PipelineState& pipelineState);
+
+    void setViewport(int x, int y, size_t width, size_t height);
+
+    // The ranges (and vertexRange.offset for the base vertex) are captured when recording, so you
+    // can share one Primitive between many BufferHeap meshes like you would when drawing directly.
+    void draw(const Primitive& primitive);
+    void draw(const Primitive& primitive, size_t offset, size_t count);
+    void draw(const Primitive& primitive, size_t instanceCount);
+    void draw(const Primitive& primitive, size_t offset, size_t count, size_t instanceCount);
+
+    // Must be called on the GL thread. The commands are kept, so a command buffer can be
+    // submitted multiple times (e.g. for static parts of the scene).
+    void submit() const;
+
+    // Keeps the memory, so re-recording every frame does not allocate
+    void clear();
+
+    size_t getCommandCount() const;
+    // In bytes
+    size_t getSize() const;
+
+private:
+    enum class CommandType : uint32_t {
+        BindShader,
+        Uniform,
+        UniformTexture,
+        BindTexture,
+        ApplyPipelineState,
+        Viewport,
+        Draw,
+    };
+
+    enum class UniformType : uint32_t { Int, Float, Vec2, Vec3, Vec4, Mat2, Mat3, Mat4 };
+
+    struct Header {
+        CommandType type;
+        uint32_t size; // including the header
+    };
+
+    struct BindShaderCmd {
+        const glw::ShaderProgram* program;
+    };
+
+    // Followed by the values
+    struct UniformCmd {
+        UniformType type;
+        UniformLocation loc;
+        size_t count;
+    };
+
+    struct UniformTextureCmd {
+        UniformLocation loc;
+        const glw::Texture* texture;
+        // -1 means allocate a unit
+        int unit;
+    };
+
+    struct BindTextureCmd {
+        unsigned int unit;
+        const glw::Texture* texture;
+    };
+
+    struct ApplyPipelineStateCmd {
+        // Index into pipelineStates_, because PipelineState is not trivially copyable
+        size_t index;
+    };
+
+    struct ViewportCmd {
+        int x;
+        int y;
+        size_t width;
+        size_t height;
+    };
+
+    struct DrawCmd {
+        const Primitive* primitive;
+        size_t offset;
+        size_t count;
+        size_t baseVertex;
+        size_t instanceCount;
+        bool instanced;
+    };
+
+    static constexpr size_t commandAlignment = 8;
+
+    template <typename T>
+    static constexpr UniformType getUniformType()
+    {
+        if constexpr (std::is_same_v<T, int>)
+            return UniformType::Int;
+        else if constexpr (std::is_same_v<T, float>)
+            return UniformType::Float;
+        else if constexpr (std::is_same_v<T, glm::vec2>)
+            return UniformType::Vec2;
+        else if constexpr (std::is_same_v<T, glm::vec3>)
+            return UniformType::Vec3;
+        else if constexpr (std::is_same_v<T, glm::vec4>)
+            return UniformType::Vec4;
+        else if constexpr (std::is_same_v<T, glm::mat2>)
+            return UniformType::Mat2;
+        else if constexpr (std::is_same_v<T, glm::mat3>)
+            return UniformType::Mat3;
+        else
+            return UniformType::Mat4;
+    }
+
+    // Returns a pointer to the payload, which has payloadSize bytes (aligned to commandAlignment)
+    uint8_t* push(CommandType type, size_t payloadSize);
+
+    template <typename Cmd>
+    void push(CommandType type, const Cmd& cmd)
+    {
+        static_assert(std::is_trivially_copyable_v<Cmd>);
+        std::memcpy(push(type, sizeof(Cmd)), &cmd, sizeof(Cmd));
+    }
+
+    void recordUniform(
+        UniformType type, UniformLocation loc, const void* data, size_t size, size_t count);
+    void recordDraw(const Primitive& primitive, size_t offset, size_t count,
+        std::optional<size_t> instanceCount);
+
+    static void submitUniform(
+        const glw::ShaderProgram& program, const UniformCmd& cmd, const uint8_t* data);
+
+    std::vector<uint8_t> data_;
+    std::vector<glw::PipelineState> pipelineStates_;
+    size_t commandCount_ = 0;
+};
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "glw/imageformat.hpp"
+#include "glw/texture.hpp"
+
+namespace glwx {
+// A 2D texture or cube map from a KTX (version 1) or DDS file with all levels still compressed
+// (S3TC/BCn or RGTC), so they can be uploaded as they are. Uncompressed files, arrays and 3D
+// textures are not supported.
+// Neither format is flipped, i.e. the first row is the top one, like with stb_image.
+struct CompressedTextureData {
+    struct Image {
+        size_t width;
+        size_t height;
+        // Into data
+        size_t offset;
+        size_t size;
+    };
+
+    glw::Texture::Target target = glw::Texture::Target::Texture2D; // or TextureCubeMap
+    glw::ImageFormat format = glw::ImageFormat::Invalid;
+    size_t width = 0;
+    size_t height = 0;
+    size_t levels = 0;
+    // 6 for cube maps (in the order of the GL cube map targets), 1 otherwise
+    size_t faces = 1;
+    std::vector<Image> images; // level * faces + face
+    std::vector<uint8_t> data;
+
+    const Image& getImage(size_t level, size_t face = 0) const;
+    const uint8_t* getImageData(size_t level, size_t face = 0) const;
+};
+
+// These reject files with dimensions above maxCompressedTextureSize, so a corrupt (or malicious)
+// header can't make them compute huge sizes.
+constexpr size_t maxCompressedTextureSize = 16384;
+std::optional<CompressedTextureData> parseKtx(const uint8_t* data, size_t size);
+std::optional<CompressedTextureData> parseDds(const uint8_t* data, size_t size);
+// Returns the contents of a KTX file (without key/value data)
+std::vector<uint8_t> writeKtx(const CompressedTextureData& data);
+// Chooses the format by the magic bytes at the start of the file
+std::optional<CompressedTextureData> loadCompressedTexture(const std::filesystem::path& path);
+
+// Allocates storage for all levels and uploads them. Returns nullopt if the driver does not
+// support the format.
+std::optional<glw::Texture> makeCompressedTexture(const CompressedTextureData& data);
+std::optional<glw::Texture> makeCompressedTexture(const std::filesystem::path& path);
+}
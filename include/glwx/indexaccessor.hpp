@@ -5,12 +5,14 @@
 namespace glwx {
 class IndexAccessor {
 public:
+    // Writes through a Proxy mark the index dirty in the buffer, reads don't
     struct Proxy {
         size_t operator=(size_t index);
         operator size_t() const;
         size_t get() const;
 
-        uint8_t* data;
+        IndexBuffer* buffer;
+        size_t offset;
         size_t elementSize;
     };
 
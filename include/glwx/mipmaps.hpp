@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glw/texture.hpp"
+#include "glwx/workerpool.hpp"
+
+namespace glwx {
+// Generates mip levels on the CPU for 8 bit textures with 1 to 4 channels. Compared to
+// glGenerateMipmap this is filtered properly for sRGB content (the averaging happens in linear
+// space), can use a better filter than a box, can preserve alpha test coverage and it does not
+// block the GL thread (only the upload does).
+// The generator does not use GL at all, so it may be used on any thread (also concurrently).
+// The rows of every level are split between the calling thread and the threads of a WorkerPool.
+class MipmapGenerator {
+public:
+    enum class Filter {
+        // Averages 2x2 texels. Fast, but a little blurry and it aliases.
+        Box,
+        // Kaiser-windowed sinc (8 taps per axis). Sharper and less aliasing, but it may ring a
+        // little at hard edges.
+        Kaiser,
+    };
+
+    struct Options {
+        Filter filter = Filter::Box;
+        // Whether the color channels (not alpha) are sRGB encoded
+        bool srgb = false;
+        // If > 0, the alpha of every level (4 channels only) is scaled, so that the fraction of
+        // texels with alpha > alphaCutoff is the same as in level 0. Otherwise alpha tested
+        // geometry like foliage gets thinner with every level and eventually disappears.
+        float alphaCutoff = 0.0f;
+    };
+
+    struct Level {
+        size_t width;
+        size_t height;
+        // Rows are padded to a multiple of 4 bytes (the default GL_UNPACK_ALIGNMENT)
+        size_t rowPitch;
+        std::vector<uint8_t> data;
+    };
+
+    // threads is the number of worker threads in addition to the calling thread
+    explicit MipmapGenerator(size_t threads = WorkerPool::getDefaultThreadCount());
+    // To share the threads with something else (e.g. BlockCompressor)
+    explicit MipmapGenerator(std::shared_ptr<WorkerPool> pool);
+
+    MipmapGenerator(const MipmapGenerator&) = delete;
+    MipmapGenerator& operator=(const MipmapGenerator&) = delete;
+    MipmapGenerator(MipmapGenerator&&) = delete;
+    MipmapGenerator& operator=(MipmapGenerator&&) = delete;
+
+    // data are tightly packed rows (like stb_image returns them). Returns levels 1 to n (down to
+    // 1x1), so levels[i] is mip level i + 1. Blocks until all levels are done.
+    std::vector<Level> generate(const uint8_t* data, size_t width, size_t height, size_t channels,
+        const Options& options) const;
+
+    // Uploads the levels returned by generate() to a texture with storage for all of them
+    static void upload(glw::Texture& texture, const std::vector<Level>& levels,
+        glw::Texture::DataFormat dataFormat);
+
+    const WorkerPool& getWorkerPool() const;
+
+private:
+    std::shared_ptr<WorkerPool> pool_;
+};
+}
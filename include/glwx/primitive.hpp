@@ -1,7 +1,10 @@
 #pragma once
 
+#include <optional>
+
 #include "glw/enums.hpp"
 #include "glw/vertexarray.hpp"
+#include "glwx/bufferheap.hpp"
 #include "glwx/buffers.hpp"
 
 namespace glwx {
@@ -12,6 +15,8 @@ public:
         size_t count = 0;
     };
 
+    // For indexed primitives, vertexRange.offset is used as the base vertex (the value added to
+    // each index), so multiple primitives can share vertex and index buffers.
     Range vertexRange;
     // This is unused if no index buffer was added
     Range indexRange;
@@ -20,15 +25,25 @@ public:
 
     explicit Primitive(glw::DrawMode mode = glw::DrawMode::Triangles);
 
+    // Returns the range of elements (vertices or indices) of size elementSize covered by an
+    // allocation. The allocation offset has to be a multiple of elementSize.
+    // To draw many meshes from the same BufferHeap page with a single vertex array, attach the
+    // page buffers once and set vertexRange and indexRange for each mesh before drawing.
+    static Range getRange(const BufferHeap::Allocation& allocation, size_t elementSize);
+
     // Make sure to set vertexRange before drawing!
     // These don't have an extra count parameter, because you might have multiple vertex buffers for
     // a single primitive
     void addVertexBuffer(const glw::Buffer& buffer, const glw::VertexFormat& vfmt);
     void addVertexBuffer(const VertexBuffer& buffer); // sets count too
+    // Sets vertexRange to the allocation
+    void addVertexBuffer(const BufferHeap::Allocation& allocation, const glw::VertexFormat& vfmt);
 
     // Make sure to set indexRange before drawing!
     void setIndexBuffer(const glw::Buffer& buffer, glw::IndexType indexType);
     void setIndexBuffer(const IndexBuffer& buffer); // sets count too
+    // Sets indexRange to the allocation
+    void setIndexBuffer(const BufferHeap::Allocation& allocation, glw::IndexType indexType);
 
     // For index meshes this range is a range in the index buffer, for non-indexed meshes
     // it's a range of vertex indices.
@@ -41,6 +56,15 @@ public:
     void draw(size_t instanceCount) const;
 
 private:
+    friend class CommandBuffer;
+
+    const Range& getDrawRange() const;
+
+    // Expects the vertex array to be bound already. The base vertex is passed explicitly, so
+    // CommandBuffer can capture vertexRange.offset when recording.
+    void drawBound(size_t offset, size_t count, size_t baseVertex,
+        std::optional<size_t> instanceCount) const;
+
     std::optional<glw::IndexType> indexType_;
 };
 }
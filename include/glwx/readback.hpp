@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "glw/buffer.hpp"
+#include "glw/fence.hpp"
+#include "glw/framebuffer.hpp"
+#include "glwx/rendertarget.hpp"
+
+namespace glwx {
+// Asynchronous glReadPixels. The pixels are read into one of a small pool of PixelPack buffers
+// and a fence is inserted after the read, so the call itself does not stall. A few frames later
+// you can poll the ticket and map the buffer to get at the pixels without an extra copy.
+// Every successful read() has to be released eventually, otherwise the pool runs dry.
+class AsyncReadback {
+public:
+    using Ticket = uint64_t;
+
+    struct View {
+        const uint8_t* data;
+        size_t width;
+        size_t height;
+        // Rows are aligned to 4 bytes (read() sets GL_PACK_ALIGNMENT)
+        size_t rowPitch;
+        size_t size;
+    };
+
+    static constexpr size_t defaultPoolSize = 3;
+
+    explicit AsyncReadback(size_t poolSize = defaultPoolSize);
+
+    AsyncReadback(const AsyncReadback&) = delete;
+    AsyncReadback& operator=(const AsyncReadback&) = delete;
+
+    AsyncReadback(AsyncReadback&&) = default;
+    AsyncReadback& operator=(AsyncReadback&&) = default;
+
+    // Reads from the framebuffer currently bound to Framebuffer::Target::Read.
+    // All read functions return nullopt if every buffer in the pool is still in use.
+    std::optional<Ticket> read(int x, int y, size_t width, size_t height,
+        glw::Texture::DataFormat dataFormat, glw::Texture::DataType dataType);
+
+    // For depth/stencil attachments the data format is replaced by Depth, Stencil or
+    // DepthStencil (whichever matches the attachment), because only those can be read from them.
+    std::optional<Ticket> read(const glw::Framebuffer& framebuffer,
+        glw::Framebuffer::Attachment attachment, int x, int y, size_t width, size_t height,
+        glw::Texture::DataFormat dataFormat, glw::Texture::DataType dataType);
+
+    // Reads the whole attachment
+    std::optional<Ticket> read(RenderTarget& renderTarget, RenderTarget::Attachment attachment,
+        glw::Texture::DataFormat dataFormat, glw::Texture::DataType dataType);
+
+    // Does not block. Unknown (e.g. released) tickets are never ready.
+    bool isReady(Ticket ticket) const;
+
+    // Returns false if the ticket is unknown or the wait failed
+    bool wait(Ticket ticket) const;
+
+    // Waits if the read has not finished yet, so check isReady first if you don't want to block.
+    // The view stays valid until release is called with the same ticket.
+    std::optional<View> map(Ticket ticket);
+
+    // Unmaps the buffer (if mapped) and returns it to the pool. Also use this to discard reads
+    // you are not interested in anymore.
+    void release(Ticket ticket);
+
+    size_t getPoolSize() const;
+    size_t getFreeCount() const;
+
+private:
+    struct Slot {
+        glw::Buffer buffer;
+        glw::Fence fence;
+        Ticket ticket = 0; // 0 means the slot is free
+        size_t width = 0;
+        size_t height = 0;
+        size_t rowPitch = 0;
+        size_t size = 0;
+        const uint8_t* mapped = nullptr;
+    };
+
+    static constexpr size_t packAlignment = 4;
+
+    Slot* findSlot(Ticket ticket);
+    const Slot* findSlot(Ticket ticket) const;
+
+    std::vector<Slot> slots_;
+    Ticket nextTicket_ = 1;
+};
+}
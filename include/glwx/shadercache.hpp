@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "glw/shader.hpp"
+
+namespace glwx {
+// Caches linked program binaries (ARB_get_program_binary) on disk, so programs don't have to be
+// compiled and linked from source on every start. Programs are keyed by a hash of all stage
+// sources and GL_VENDOR, GL_RENDERER and GL_VERSION, so a driver update invalidates the cache.
+// If the binary can't be loaded (or the extension is not available), the program is compiled
+// from source and the cache entry is (re)written.
+class ShaderProgramCache {
+public:
+    using Stage = std::pair<glw::Shader::Type, std::string_view>;
+
+    struct Statistics {
+        size_t hits = 0;
+        size_t misses = 0;
+        // Cache files that existed, but could not be loaded
+        size_t rejected = 0;
+    };
+
+    // The directory is created if it doesn't exist
+    explicit ShaderProgramCache(std::filesystem::path directory);
+
+    std::optional<glw::ShaderProgram> get(const std::vector<Stage>& stages);
+    std::optional<glw::ShaderProgram> get(std::string_view vertSource, std::string_view fragSource);
+
+    // Removes all cache files
+    void clear();
+
+    const Statistics& getStatistics() const;
+
+private:
+    static uint64_t getKey(const std::vector<Stage>& stages);
+
+    std::filesystem::path getPath(uint64_t key) const;
+    std::optional<glw::ShaderProgram::Binary> load(uint64_t key) const;
+    void store(uint64_t key, const glw::ShaderProgram::Binary& binary) const;
+
+    std::filesystem::path directory_;
+    bool supported_;
+    Statistics statistics_;
+};
+}
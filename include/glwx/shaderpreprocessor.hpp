@@ -0,0 +1,59 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace glwx {
+// Resolves #include "file" (or <file>) directives and injects #defines right after the #version
+// directive, so permutations of a shader don't have to be built by concatenating strings.
+// Includes are looked up relative to the including file first and then in the search paths (in the
+// order they were added). Included files may use #pragma once.
+// #line directives are inserted around every include, with the source string number being the
+// index of the file in Result::files, so compile logs point at the right file and line.
+// This is not a real preprocessor: #include has to be the first thing on its line and includes
+// in comments or in disabled #if blocks are still resolved.
+class ShaderPreprocessor {
+public:
+    // Name and value. The value may be empty.
+    using Defines = std::vector<std::pair<std::string, std::string>>;
+
+    struct Result {
+        std::string source;
+        // All files that were read, starting with the main file (which is empty for
+        // processSource). Useful to find out which programs depend on a file.
+        std::vector<std::filesystem::path> files;
+    };
+
+    static constexpr size_t maxIncludeDepth = 32;
+
+    void addSearchPath(std::filesystem::path path);
+
+    // Registers a file that only exists in memory. It can be included (or passed to process) by
+    // name and takes precedence over the file system.
+    void addFile(std::filesystem::path name, std::string source);
+
+    std::optional<Result> process(
+        const std::filesystem::path& path, const Defines& defines = {}) const;
+    // Includes are resolved against the search paths only
+    std::optional<Result> processSource(std::string_view source, const Defines& defines = {}) const;
+
+private:
+    struct Context;
+
+    std::optional<Result> run(const std::filesystem::path& path, std::string_view source,
+        const Defines& defines) const;
+    std::optional<std::string> loadFile(const std::filesystem::path& path) const;
+    std::optional<std::filesystem::path> resolveInclude(
+        const std::filesystem::path& includingFile, const std::filesystem::path& name) const;
+    bool processFile(Context& ctx, const std::filesystem::path& path, std::string_view source,
+        size_t depth) const;
+
+    std::vector<std::filesystem::path> searchPaths_;
+    std::unordered_map<std::string, std::string> files_;
+};
+}
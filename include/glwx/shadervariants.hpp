@@ -0,0 +1,91 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "glw/shader.hpp"
+#include "glwx/shaderpreprocessor.hpp"
+
+namespace glwx {
+// Builds shader permutations (the same stage files with different sets of defines) lazily and
+// keeps them around. A program is only compiled and linked the first time it's requested.
+// Stages are shared too: if two variants end up with identical sources for a stage (e.g. the
+// defines only matter in the fragment shader), that stage is compiled only once.
+// The order of the defines does not matter, {A, B} and {B, A} are the same variant.
+class ShaderVariantCache {
+public:
+    using Defines = ShaderPreprocessor::Defines;
+    using Stage = std::pair<glw::Shader::Type, std::filesystem::path>;
+
+    struct Statistics {
+        size_t programsLinked = 0;
+        size_t stagesCompiled = 0;
+        // Stages that were already compiled for a different variant
+        size_t stagesShared = 0;
+        // Variants that could not be built (preprocessing, compile or link errors)
+        size_t failures = 0;
+    };
+
+    explicit ShaderVariantCache(ShaderPreprocessor preprocessor = {});
+
+    ShaderVariantCache(const ShaderVariantCache&) = delete;
+    ShaderVariantCache& operator=(const ShaderVariantCache&) = delete;
+
+    ShaderVariantCache(ShaderVariantCache&&) = default;
+    ShaderVariantCache& operator=(ShaderVariantCache&&) = default;
+
+    // Returns nullptr if the variant could not be built. Failures are cached as well, so they are
+    // only logged once. The pointer stays valid until clear() is called.
+    const glw::ShaderProgram* get(const std::vector<Stage>& stages, const Defines& defines = {});
+    const glw::ShaderProgram* get(const std::filesystem::path& vert,
+        const std::filesystem::path& frag, const Defines& defines = {});
+
+    // Deletes all programs and stages, e.g. after the files changed
+    void clear();
+
+    ShaderPreprocessor& getPreprocessor();
+    size_t getVariantCount() const;
+    const Statistics& getStatistics() const;
+
+private:
+    struct Variant {
+        std::vector<Stage> stages;
+        // Sorted by name
+        Defines defines;
+        std::optional<glw::ShaderProgram> program;
+    };
+
+    struct StageKey {
+        glw::Shader::Type type;
+        std::string source;
+
+        bool operator==(const StageKey&) const = default;
+    };
+
+    struct StageKeyHash {
+        size_t operator()(const StageKey& key) const;
+    };
+
+    static size_t hash(const std::vector<Stage>& stages, const Defines& defines);
+    static bool matches(
+        const Variant& variant, const std::vector<Stage>& stages, const Defines& defines);
+
+    std::optional<glw::ShaderProgram> build(
+        const std::vector<Stage>& stages, const Defines& defines);
+    const glw::Shader* getStage(glw::Shader::Type type, std::string source);
+
+    ShaderPreprocessor preprocessor_;
+    // Multiple variants per hash, in case of collisions. The Variants are allocated separately, so
+    // the pointers to their programs stay valid.
+    std::unordered_map<size_t, std::vector<std::unique_ptr<Variant>>> variants_;
+    // Failed compiles are stored as nullopt
+    std::unordered_map<StageKey, std::optional<glw::Shader>, StageKeyHash> stages_;
+    size_t variantCount_ = 0;
+    Statistics statistics_;
+};
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "glw/shader.hpp"
+#include "glwx/asyncshader.hpp"
+#include "glwx/shaderpreprocessor.hpp"
+
+namespace glwx {
+// Hot reloading for shaders that are loaded from files. The watcher knows every file a program
+// depends on (including everything it #includes) and when one of them changes, only the affected
+// programs are rebuilt. The rebuilds go through an AsyncShaderCompiler, so with
+// KHR_parallel_shader_compile they don't stall the frame. If a rebuild succeeds, the new program
+// is moved into the old ShaderProgram object (after copying the uniform values over), so the
+// pointers returned by add() stay valid. If it fails, the old program is kept and the errors are
+// logged.
+// Changes are detected with inotify, so this only does something on Linux.
+// Everything here must be called on the GL thread.
+class ShaderWatcher {
+public:
+    using Stage = std::pair<glw::Shader::Type, std::filesystem::path>;
+    using Defines = ShaderPreprocessor::Defines;
+
+    explicit ShaderWatcher(ShaderPreprocessor preprocessor = {});
+    ~ShaderWatcher();
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+    ShaderWatcher(ShaderWatcher&&) = delete;
+    ShaderWatcher& operator=(ShaderWatcher&&) = delete;
+
+    // Builds the program right away (blocking). Returns nullptr if that fails.
+    // The program is owned by the watcher and stays valid as long as the watcher lives.
+    glw::ShaderProgram* add(const std::vector<Stage>& stages, const Defines& defines = {});
+    glw::ShaderProgram* add(const std::filesystem::path& vert, const std::filesystem::path& frag,
+        const Defines& defines = {});
+
+    // Checks for changed files, starts the rebuilds and swaps in the programs that finished
+    // rebuilding. Call this regularly (e.g. once per frame). Returns the number of programs that
+    // were swapped.
+    size_t poll();
+
+    // Waits for all running rebuilds
+    void finish();
+
+    // Whether file changes can be detected at all
+    bool isWatching() const;
+
+private:
+    struct Program {
+        std::vector<Stage> stages;
+        Defines defines;
+        // Absolute paths of all files the program depends on
+        std::vector<std::filesystem::path> files;
+        glw::ShaderProgram program;
+
+        struct Rebuild {
+            ShaderProgramFuture future;
+            std::vector<std::filesystem::path> files;
+        };
+        std::optional<Rebuild> rebuild;
+    };
+
+    // Preprocesses all stages and starts compiling them
+    std::optional<Program::Rebuild> startBuild(
+        const std::vector<Stage>& stages, const Defines& defines);
+    void watch(const std::vector<std::filesystem::path>& files);
+    // Returns the absolute paths of the files that changed since the last call
+    std::vector<std::filesystem::path> readChanges();
+    size_t swapFinished();
+
+    ShaderPreprocessor preprocessor_;
+    AsyncShaderCompiler compiler_;
+    std::vector<std::unique_ptr<Program>> programs_;
+    int inotifyFd_ = -1;
+    // Directories are watched instead of files, because many editors save by writing a new file
+    // and renaming it over the old one.
+    std::unordered_map<int, std::filesystem::path> watchDirs_;
+};
+}
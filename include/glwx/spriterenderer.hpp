@@ -1,21 +1,18 @@
 #pragma once
 
+#include <string>
 #include <vector>
 
 #include "glw/shader.hpp"
 #include "glw/texture.hpp"
 #include "glwx/buffers.hpp"
 #include "glwx/primitive.hpp"
+#include "glwx/streambuffer.hpp"
+#include "glwx/textureatlas.hpp"
 #include "glwx/transform2d.hpp"
 
 namespace glwx {
 
-struct TextureRegion {
-    // These are all in [0, 1] (uv coordinates)
-    glm::vec2 position = glm::vec2(0.0f, 0.0f);
-    glm::vec2 size = glm::vec2(1.0f, 1.0f);
-};
-
 class SpriteBatch {
 public:
     using IndexType = uint16_t;
@@ -26,6 +23,11 @@ public:
         static constexpr size_t Color = 2;
     };
 
+    // The batch data is streamed into ring buffers of this size, which should be able to hold a
+    // couple of frames worth of sprites.
+    static constexpr size_t vertexStreamSize = 4 * 1024 * 1024;
+    static constexpr size_t indexStreamSize = 1024 * 1024;
+
     SpriteBatch(size_t vertexCount = 0, size_t indexCount = 0);
 
     IndexType addVertex(
@@ -52,8 +54,8 @@ private:
     std::vector<Vertex> vertices_;
     std::vector<IndexType> indices_;
     Primitive primitive_;
-    DefaultBuffer vertexBuffer_;
-    DefaultBuffer indexBuffer_;
+    StreamBuffer vertexBuffer_;
+    StreamBuffer indexBuffer_;
 };
 
 class SpriteRenderer {
@@ -99,9 +101,18 @@ public:
 
     void setCurrentTexture(const glw::Texture* texture);
 
+    // The textures are bound to this sampler of the program (which is bound in flush), so they get
+    // their units from glw::State::allocateTextureUnit. If no program is set, the textures are
+    // bound to unit 0 and you have to bind the program yourself.
+    void setShaderProgram(const glw::ShaderProgram* program, const std::string& sampler = "base");
+
     void draw(const glw::Texture& texture, const Transform2D& transform,
         const TextureRegion& region = TextureRegion {});
 
+    // Like above, but the sprite has the size of the region instead of the whole texture. Sprites
+    // from the same atlas page end up in the same batch.
+    void draw(const TextureAtlas::Region& region, const Transform2D& transform);
+
     void draw(const glw::Texture& texture, const std::vector<glm::vec2>& points,
         const Transform2D& transform = Transform2D {},
         const TextureRegion& region = TextureRegion {});
@@ -119,7 +130,12 @@ public:
     void flush();
 
 private:
+    void drawQuad(const glw::Texture& texture, const Transform2D& transform,
+        const glm::vec2& size, const TextureRegion& region);
+
     const glw::Texture* currentTexture_ = nullptr;
+    const glw::ShaderProgram* shaderProgram_ = nullptr;
+    glw::ShaderProgram::UniformLocation samplerLocation_ = glw::ShaderProgram::invalidLocation;
     SpriteBatch batch_;
 };
 
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include "glw/buffer.hpp"
+#include "glw/fence.hpp"
+
+namespace glwx {
+// A ring buffer for data that changes every frame. It hands out sub-allocations and uses fences to
+// make sure it never overwrites a region the GPU might still be reading from.
+// If ARB_buffer_storage is available, the buffer is mapped persistently once. Otherwise every
+// allocation is mapped separately with GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT.
+// The buffer can be bound to any target, e.g. passed to Primitive::addVertexBuffer or
+// Primitive::setIndexBuffer. Use Allocation::offset for the vertex/index offset when drawing.
+class StreamBuffer {
+public:
+    struct Allocation {
+        uint8_t* data = nullptr;
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    explicit StreamBuffer(size_t size);
+    ~StreamBuffer() = default;
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    StreamBuffer(StreamBuffer&&) = default;
+    StreamBuffer& operator=(StreamBuffer&&) = default;
+
+    // Allocations are not allowed to be larger than the buffer. If you allocate more than the
+    // size of the buffer between two calls to fence(), this will stall.
+    // Only a single allocation may be mapped at a time. Call unmap() before any draw call that
+    // sources its data.
+    Allocation map(size_t size, size_t alignment = 4);
+
+    // This is a no-op, if the buffer is mapped persistently.
+    void unmap();
+
+    // Call this after the draw calls that use the data allocated since the last call have been
+    // issued (e.g. once per frame or after each draw). Does nothing if nothing was allocated.
+    void fence();
+
+    const glw::Buffer& getBuffer() const;
+    size_t getSize() const;
+    bool isPersistent() const;
+
+private:
+    struct Region {
+        // Everything before this position (in bytes ever allocated) is free once the fence is
+        // signaled.
+        size_t end;
+        glw::Fence fence;
+    };
+
+    // The buffer is never bound to an actual vertex/index target for mapping, so we don't
+    // accidentally change the element array binding of a vertex array.
+    static constexpr auto mapTarget = glw::Buffer::Target::CopyWrite;
+
+    void waitUntilFree(size_t position);
+
+    glw::Buffer buffer_;
+    size_t size_;
+    uint8_t* persistentData_ = nullptr;
+    // Total number of bytes ever allocated, including padding. The ring offset is position_ % size_
+    size_t position_ = 0;
+    size_t fencedPosition_ = 0;
+    std::deque<Region> regions_;
+    bool mapped_ = false;
+};
+}
@@ -6,10 +6,17 @@
 #include <glm/glm.hpp>
 
 #include "glw/texture.hpp"
+#include "glwx/blockcompressor.hpp"
+#include "glwx/mipmaps.hpp"
 
 namespace glwx {
 glw::Texture makeTexture2D(
     const uint8_t* buffer, size_t width, size_t height, size_t channels, bool mipmaps = true);
+// Like above, but the mip levels are generated on the CPU by generator instead of with
+// glGenerateMipmap. If options.srgb is set, a 3 or 4 channel texture gets an sRGB format. 1 and 2
+// channel textures ignore it (there are no sRGB formats for them) and are filtered as linear.
+glw::Texture makeTexture2D(const uint8_t* buffer, size_t width, size_t height, size_t channels,
+    const MipmapGenerator& generator, const MipmapGenerator::Options& options = {});
 glw::Texture makeTexture2D(
     const glm::vec4& color, size_t width = 1, size_t height = 1, bool mipmaps = false);
 glw::Texture makeTexture2D(size_t width, size_t height, size_t checkerSize,
@@ -18,6 +25,11 @@ glw::Texture makeTexture2D(size_t width, size_t height, size_t checkerSize,
 std::optional<glw::Texture> makeTexture2D(
     const uint8_t* encodedBuffer, size_t size, bool mipmaps = true);
 std::optional<glw::Texture> makeTexture2D(const std::filesystem::path& path, bool mipmaps = true);
+// Compresses the image with compressor. If a cache is passed, it is keyed by the contents of the
+// file, so the image is only decoded and compressed if it's not in the cache.
+std::optional<glw::Texture> makeTexture2D(const std::filesystem::path& path,
+    const BlockCompressor& compressor, const BlockCompressor::Options& options,
+    CompressedTextureCache* cache = nullptr);
 std::optional<glw::Texture> makeCubeTexture(const std::filesystem::path& posX,
     const std::filesystem::path& negX, const std::filesystem::path& posY,
     const std::filesystem::path& negY, const std::filesystem::path& posZ,
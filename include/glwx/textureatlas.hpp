@@ -0,0 +1,143 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "glw/texture.hpp"
+
+namespace glwx {
+
+struct TextureRegion {
+    // These are all in [0, 1] (uv coordinates)
+    glm::vec2 position = glm::vec2(0.0f, 0.0f);
+    glm::vec2 size = glm::vec2(1.0f, 1.0f);
+};
+
+// Packs rectangles into a fixed area one at a time (the rectangles are not known in advance).
+// Skyline is faster and good for rectangles of similar height (e.g. glyphs), MaxRects wastes less
+// space for mixed sizes, but insertion is O(n^2) in the number of free rectangles.
+// Rectangles are never rotated, because a rotated TextureRegion can't be expressed.
+class RectPacker {
+public:
+    enum class Method {
+        Skyline, // Bottom-left
+        MaxRects, // Best short side fit
+    };
+
+    struct Rect {
+        size_t x;
+        size_t y;
+        size_t width;
+        size_t height;
+    };
+
+    RectPacker(size_t width, size_t height, Method method = Method::Skyline);
+
+    // Returns nullopt if there is no space left for a rectangle of this size
+    std::optional<Rect> insert(size_t width, size_t height);
+
+    void clear();
+
+    size_t getWidth() const;
+    size_t getHeight() const;
+    // The fraction of the area that is covered by rectangles
+    float getOccupancy() const;
+
+private:
+    struct SkylineNode {
+        size_t x;
+        size_t y;
+        size_t width;
+    };
+
+    std::optional<Rect> insertSkyline(size_t width, size_t height);
+    // Returns the y coordinate a rectangle at skyline_[index] would be placed at
+    std::optional<size_t> fitSkyline(size_t index, size_t width, size_t height) const;
+    std::optional<Rect> insertMaxRects(size_t width, size_t height);
+    void splitFreeRects(const Rect& used);
+    void pruneFreeRects();
+
+    size_t width_;
+    size_t height_;
+    Method method_;
+    size_t usedArea_ = 0;
+    std::vector<SkylineNode> skyline_;
+    std::vector<Rect> freeRects_;
+};
+
+// Packs many small images into a few large RGBA textures (pages), so sprites using them can be
+// drawn by SpriteRenderer in one batch per page instead of one per image. Images can be added at
+// any time; they are uploaded right away into the first page with space left and a new page is
+// created if none has.
+class TextureAtlas {
+public:
+    struct Options {
+        size_t pageWidth = 2048;
+        size_t pageHeight = 2048;
+        RectPacker::Method method = RectPacker::Method::Skyline;
+        // Texels around every image that are filled by repeating its edge texels, so linear
+        // filtering does not pick up the neighbouring images.
+        size_t padding = 1;
+        // If > 1, the pages get this many levels. Images are then placed on multiples of
+        // 2^(mipLevels - 1) texels and the padding is scaled by the same factor, so images don't
+        // bleed into each other on any level. Call generateMipmaps after adding images.
+        // Must be at least 1 and small enough that 2^(mipLevels - 1) fits into a page.
+        size_t mipLevels = 1;
+        bool srgb = false;
+    };
+
+    struct Region {
+        const glw::Texture* texture = nullptr;
+        size_t page = 0;
+        // The image in texels (without padding)
+        size_t x = 0;
+        size_t y = 0;
+        size_t width = 0;
+        size_t height = 0;
+        TextureRegion region;
+
+        glm::vec2 getSize() const;
+    };
+
+    TextureAtlas();
+    explicit TextureAtlas(const Options& options);
+
+    // data are tightly packed rows like stb_image returns them. The channels are interpreted like
+    // readTexelRgba (glwx/utility.hpp) does: 1 channel is gray, 2 channels are red and green.
+    // Returns nullopt if the image is empty or (with padding) larger than a page.
+    std::optional<Region> add(const uint8_t* data, size_t width, size_t height, size_t channels);
+    // Files are always loaded as RGBA, so gray + alpha images work as expected
+    std::optional<Region> add(const std::filesystem::path& path);
+
+    // Regenerates the mip levels of the pages that had images added since the last call
+    void generateMipmaps();
+
+    // Forgets all images, but keeps the pages. Regions returned before are invalid afterwards.
+    void clear();
+
+    size_t getPageCount() const;
+    const glw::Texture& getTexture(size_t page) const;
+    // The fraction of the area of all pages that is used (including padding)
+    float getOccupancy() const;
+
+private:
+    struct Page {
+        glw::Texture texture;
+        // Works in units of alignment_ texels
+        RectPacker packer;
+        bool dirty = false;
+    };
+
+    Page& addPage();
+
+    Options options_;
+    size_t alignment_;
+    size_t padding_;
+    // unique_ptr, so the textures don't move and Region::texture stays valid
+    std::vector<std::unique_ptr<Page>> pages_;
+};
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "glw/buffer.hpp"
+#include "glw/fence.hpp"
+#include "glw/texture.hpp"
+
+namespace glwx {
+// Uploads texture data through a pool of PixelUnpack buffers, so glTexSubImage2D sources its
+// data from a buffer object instead of client memory and does not have to copy synchronously.
+// The copy into the mapped staging buffer happens on a worker thread (if enabled), the GL calls
+// all happen in update(), which has to be called regularly (e.g. once per frame) on the GL thread.
+// Each upload uses a whole staging buffer, which grows to fit the largest upload, and a buffer is
+// reused only after the fence inserted after its glTexSubImage2D is signaled.
+// The textures must stay alive (and must not be moved) until their uploads are done.
+class TextureUploader {
+public:
+    using Ticket = uint64_t;
+
+    // Receives the mapped staging memory. Rows have to be rowPitch bytes apart.
+    using FillFunc = std::function<void(uint8_t* dst, size_t rowPitch)>;
+
+    static constexpr size_t defaultPoolSize = 4;
+
+    explicit TextureUploader(size_t poolSize = defaultPoolSize, bool workerThread = true);
+    ~TextureUploader();
+
+    TextureUploader(const TextureUploader&) = delete;
+    TextureUploader& operator=(const TextureUploader&) = delete;
+
+    TextureUploader(TextureUploader&&) = delete;
+    TextureUploader& operator=(TextureUploader&&) = delete;
+
+    // pixels are tightly packed rows (no row alignment)
+    Ticket upload(const glw::Texture& texture, glw::Texture::Target target, size_t level, size_t x,
+        size_t y, size_t width, size_t height, glw::Texture::DataFormat dataFormat,
+        glw::Texture::DataType dataType, std::vector<uint8_t> pixels);
+    // Uploads the whole first level of the texture
+    Ticket upload(const glw::Texture& texture, glw::Texture::DataFormat dataFormat,
+        glw::Texture::DataType dataType, std::vector<uint8_t> pixels);
+
+    // fill is called on the worker thread (or in update() if there is none)
+    Ticket upload(const glw::Texture& texture, glw::Texture::Target target, size_t level, size_t x,
+        size_t y, size_t width, size_t height, glw::Texture::DataFormat dataFormat,
+        glw::Texture::DataType dataType, FillFunc fill);
+
+    // Must be called on the GL thread. Recycles staging buffers, issues glTexSubImage2D for
+    // finished copies and starts copies for queued uploads.
+    void update();
+
+    // Blocks until all uploads are done
+    void finish();
+
+    // Done means glTexSubImage2D has been issued, so you can use the texture (e.g. generate
+    // mipmaps), but the staging buffer might still be in use.
+    bool isDone(Ticket ticket) const;
+    size_t getPendingCount() const;
+
+private:
+    struct Upload {
+        Ticket ticket;
+        const glw::Texture* texture;
+        glw::Texture::Target target;
+        size_t level;
+        size_t x;
+        size_t y;
+        size_t width;
+        size_t height;
+        glw::Texture::DataFormat dataFormat;
+        glw::Texture::DataType dataType;
+        size_t rowPitch;
+        size_t size;
+        FillFunc fill;
+    };
+
+    struct Slot {
+        enum class Status { Free, Copying, Copied, InFlight };
+
+        glw::Buffer buffer;
+        glw::Fence fence;
+        Status status = Status::Free;
+        Upload upload;
+        uint8_t* mapped = nullptr;
+    };
+
+    // GL_UNPACK_ALIGNMENT, which we set before every upload (the default is 4, too)
+    static constexpr size_t unpackAlignment = 4;
+
+    void submit(Slot& slot);
+    // Fallback if a staging buffer can't be mapped
+    void uploadDirect(const Upload& upload);
+    void workerMain();
+
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::deque<Upload> queue_;
+    Ticket nextTicket_ = 1;
+
+    // Protects the slot status, queue_ and jobs_. Everything else is only touched on the GL thread
+    // (or by the worker for slots that are Copying).
+    mutable std::mutex mutex_;
+    std::condition_variable jobsCondition_;
+    std::deque<Slot*> jobs_;
+    bool stop_ = false;
+    std::thread worker_;
+};
+}
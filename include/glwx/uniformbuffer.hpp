@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "glw/uniforminfo.hpp"
+#include "glwx/streambuffer.hpp"
+
+namespace glwx {
+// bools are 4 bytes in a uniform block, so pass them as uint32_t
+template <typename T>
+concept Std140Scalar = std::same_as<T, float> || std::same_as<T, int32_t>
+    || std::same_as<T, uint32_t>;
+
+template <typename T>
+struct Std140Layout {
+    static constexpr bool valid = false;
+};
+
+template <Std140Scalar T>
+struct Std140Layout<T> {
+    static constexpr bool valid = true;
+    static constexpr size_t alignment = 4;
+    static constexpr size_t columns = 1;
+    static constexpr size_t columnSize = 4;
+};
+
+template <glm::length_t L, Std140Scalar T, glm::qualifier Q>
+struct Std140Layout<glm::vec<L, T, Q>> {
+    static constexpr bool valid = true;
+    // vec3 is aligned like a vec4
+    static constexpr size_t alignment = L == 2 ? 8 : 16;
+    static constexpr size_t columns = 1;
+    static constexpr size_t columnSize = L * 4;
+};
+
+// A matrix is laid out like an array of its column vectors, so every column is aligned to 16
+template <glm::length_t C, glm::length_t R, glm::qualifier Q>
+struct Std140Layout<glm::mat<C, R, float, Q>> {
+    static constexpr bool valid = true;
+    static constexpr size_t alignment = 16;
+    static constexpr size_t columns = C;
+    static constexpr size_t columnSize = R * 4;
+};
+
+template <typename T>
+concept Std140Type = Std140Layout<T>::valid;
+
+// Packs values into a byte buffer according to the std140 rules, so you can fill a
+// "layout(std140) uniform" block by adding its members in declaration order, without querying any
+// offsets. Alternatively set() writes at the offsets from UniformBlockInfo, which also works for
+// blocks with the shared or packed layout.
+class Std140Writer {
+public:
+    // Starts with size zero-initialized bytes (e.g. UniformBlockInfo::size)
+    explicit Std140Writer(size_t size = 0);
+
+    // Returns the offset the value was written at
+    template <Std140Type T>
+    size_t add(const T& value)
+    {
+        using L = Std140Layout<T>;
+        const auto offset = alignTo(L::alignment);
+        write(offset, value, 16);
+        // Like an array, a matrix takes all of its columns padded to 16 (write only resizes up to
+        // the end of the last column), so the next member starts behind the padding.
+        if constexpr (L::columns > 1)
+            resize(offset + L::columns * 16);
+        return offset;
+    }
+
+    // Array elements are aligned to 16, so e.g. a float[4] takes 64 bytes
+    template <Std140Type T>
+    size_t add(const T* values, size_t count)
+    {
+        const auto offset = alignTo(16);
+        const auto stride = arrayStride<T>();
+        resize(offset + stride * count);
+        for (size_t i = 0; i < count; ++i)
+            write(offset + stride * i, values[i], 16);
+        return offset;
+    }
+
+    // Call these around the members of a struct (or each element of an array of structs)
+    void beginStruct();
+    void endStruct();
+
+    template <Std140Type T>
+    void set(size_t offset, const T& value)
+    {
+        write(offset, value, 16);
+    }
+
+    template <Std140Type T>
+    void set(const glw::UniformBlockInfo::Member& member, const T& value, size_t arrayIndex = 0)
+    {
+        // Writing rows instead of columns is not implemented
+        assert(!member.rowMajor || Std140Layout<T>::columns == 1);
+        assert(arrayIndex < static_cast<size_t>(member.size));
+        write(member.offset + member.arrayStride * arrayIndex, value, member.matrixStride);
+    }
+
+    template <Std140Type T>
+    static constexpr size_t arrayStride()
+    {
+        using L = Std140Layout<T>;
+        return L::columns > 1 ? L::columns * 16 : 16;
+    }
+
+    // The size is always rounded up to 16, like the size of a block would be
+    const uint8_t* getData() const;
+    size_t getSize() const;
+
+    void clear();
+
+private:
+    size_t alignTo(size_t alignment);
+    void resize(size_t size);
+
+    template <typename T>
+    void write(size_t offset, const T& value, size_t matrixStride)
+    {
+        using L = Std140Layout<T>;
+        const auto size = L::columns > 1 ? matrixStride * (L::columns - 1) + L::columnSize
+                                         : L::columnSize;
+        resize(offset + size);
+        if constexpr (L::columns > 1) {
+            for (size_t c = 0; c < L::columns; ++c)
+                std::memcpy(data_.data() + offset + matrixStride * c, &value[c], L::columnSize);
+        } else {
+            std::memcpy(data_.data() + offset, &value, L::columnSize);
+        }
+    }
+
+    std::vector<uint8_t> data_;
+    // Where the next add() starts (before alignment)
+    size_t end_ = 0;
+};
+
+// Sub-allocates uniform blocks from one large uniform buffer (a StreamBuffer) and binds them with
+// glBindBufferRange. So a draw that needs a few dozen uniforms costs a memcpy and a single range
+// bind instead of a glUniform* call per value.
+// Allocations are aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT. Call fence() after the draws that
+// use the blocks (e.g. once per frame), so the ring knows when it may overwrite them.
+class UniformBufferRing {
+public:
+    explicit UniformBufferRing(size_t size = 4 * 1024 * 1024);
+
+    // Copies the data into the ring and binds it to the uniform buffer binding point.
+    // Returns the offset of the copy in the buffer or nullopt if the ring could not be mapped, in
+    // which case nothing is bound.
+    std::optional<size_t> bind(unsigned int binding, const void* data, size_t size);
+    std::optional<size_t> bind(unsigned int binding, const Std140Writer& writer);
+
+    void fence();
+
+    const StreamBuffer& getStreamBuffer() const;
+    size_t getOffsetAlignment() const;
+
+private:
+    StreamBuffer buffer_;
+    size_t offsetAlignment_;
+};
+}
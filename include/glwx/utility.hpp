@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <filesystem>
 #include <istream>
 #include <optional>
@@ -36,5 +38,33 @@ std::string toHexStream(const uint8_t* data, size_t size);
 
 std::optional<std::string> readFile(const std::filesystem::path& filename);
 
+// path with a random suffix, to write to before renaming it to path. The suffix is unique per call,
+// so processes (or threads) writing the same file at the same time don't write into each other's
+// temporary file.
+std::filesystem::path getTempPath(const std::filesystem::path& path);
+
+// For hashes that need to be stable across runs (and builds), e.g. keys of on-disk caches, so
+// std::hash is out.
+constexpr uint64_t fnv1aOffsetBasis = 0xcbf29ce484222325;
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size);
+
 uint32_t colorToInt(const glm::vec4& col);
+
+// Reads a texel of a tightly packed 8 bit image with 1-4 channels as RGBA. 1 channel is gray,
+// 2 channels are red and green (like makeTexture2D uploads them, not gray and alpha like
+// stb_image means them), missing color channels are 0 and missing alpha is 255.
+// Inline, because it's called per texel in tight loops.
+inline std::array<uint8_t, 4> readTexelRgba(const uint8_t* texel, size_t channels)
+{
+    switch (channels) {
+    case 1:
+        return { texel[0], texel[0], texel[0], 255 };
+    case 2:
+        return { texel[0], texel[1], 0, 255 };
+    case 3:
+        return { texel[0], texel[1], texel[2], 255 };
+    default:
+        return { texel[0], texel[1], texel[2], texel[3] };
+    }
+}
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <utility>
+
 #include <glm/glm.hpp>
 
 #include "glw/log.hpp"
@@ -20,9 +22,11 @@ class VertexAccessor {
     static_assert(numComponents == 2 || numComponents == 3 || numComponents == 4);
 
 public:
+    // Writes through a Proxy mark the attribute dirty in the buffer, reads don't
     struct Proxy {
         T operator=(const T& v)
         {
+            const auto data = buffer->getData(offset, size).data();
             for (size_t i = 0; i < numComponents; ++i)
                 detail::assign(dataType, normalized, data, i, v[i]);
             return v;
@@ -35,13 +39,16 @@ public:
 
         T get() const
         {
+            const auto data = std::as_const(*buffer).getData().data() + offset;
             T v {};
             for (size_t i = 0; i < numComponents; ++i)
                 v[i] = detail::convert(dataType, normalized, data, i);
             return v;
         }
 
-        uint8_t* data;
+        VertexBuffer* buffer;
+        size_t offset;
+        size_t size;
         glw::AttributeType dataType;
         bool normalized;
     };
@@ -55,15 +62,14 @@ public:
 
     Proxy operator[](size_t index)
     {
-        return Proxy { getElementPointer(index), attribute_.dataType, attribute_.normalized };
+        return Proxy { &buffer_, getElementOffset(index), attribute_.getAlignedSize(),
+            attribute_.dataType, attribute_.normalized };
     }
 
 private:
-    uint8_t* getElementPointer(size_t index)
+    size_t getElementOffset(size_t index) const
     {
-        const auto& format = buffer_.getVertexFormat();
-        const auto vertex = buffer_.getData().data() + index * format.getStride();
-        return vertex + attribute_.offset;
+        return index * buffer_.getVertexFormat().getStride() + attribute_.offset;
     }
 
     VertexBuffer& buffer_;
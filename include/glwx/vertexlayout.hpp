@@ -0,0 +1,40 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "glw/shader.hpp"
+#include "glw/vertexformat.hpp"
+
+namespace glwx {
+// Checks a vertex format against the active attributes of a program and logs every problem.
+// Errors (returns false):
+// - An active attribute is not provided by the format. GL would use the current generic
+//   attribute value, which is almost never intended and makes some drivers patch the shader.
+// - An integer or double attribute is fed by the format. VertexFormat::set uses
+//   glVertexAttribPointer, so the shader would get floats reinterpreted as integers.
+// Warnings:
+// - The format provides a location that the program doesn't use.
+// - The format provides more components than the attribute has.
+// Both are wasted bandwidth, so the format could be packed tighter.
+bool validateVertexFormat(const glw::VertexFormat& vfmt, const glw::ShaderProgram& program);
+
+// Like VertexFormat::Attribute, but the location is looked up by name in the program
+struct NamedAttribute {
+    std::string name;
+    size_t components;
+    glw::AttributeType dataType;
+    bool normalized = false;
+    size_t divisor = 0;
+    size_t offset = static_cast<size_t>(-1);
+};
+
+// Builds a vertex format for the buffer layout described by attrs (offsets and stride are
+// computed like VertexFormat::add does), with the locations the program assigned to the
+// attributes. Attributes that are not active in the program are left out of the format, but
+// still take up space in the vertex, so the format matches the buffer.
+// Returns nullopt if the result does not pass validateVertexFormat.
+std::optional<glw::VertexFormat> makeVertexFormat(
+    const glw::ShaderProgram& program, const std::vector<NamedAttribute>& attrs);
+}
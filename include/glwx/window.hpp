@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
@@ -8,6 +9,8 @@
 #include <SDL.h>
 #include <glm/glm.hpp>
 
+#include "glw/state.hpp"
+
 namespace glwx {
 class Sdl {
 public:
@@ -25,6 +28,35 @@ private:
     int result_ = 1;
 };
 
+// A context that shares objects (buffers, textures, shaders) with the context of a Window, e.g.
+// for loading resources on another thread. Container objects (vertex arrays, framebuffers) and
+// bindings are not shared. Call makeCurrent on the thread that uses it.
+class SharedContext {
+public:
+    ~SharedContext();
+    SharedContext(const SharedContext&) = delete;
+    SharedContext& operator=(const SharedContext&) = delete;
+    SharedContext(SharedContext&& other);
+    SharedContext& operator=(SharedContext&& other) = delete;
+
+    // Makes the context and its State current on the calling thread
+    bool makeCurrent() const;
+    // Makes no context current on the calling thread, so it can be made current on another one
+    void release() const;
+
+    glw::State& getState() const;
+    SDL_GLContext getSdlGlContext() const;
+
+private:
+    friend class Window;
+
+    SharedContext(SDL_Window* window, SDL_GLContext glContext);
+
+    SDL_Window* window_ = nullptr;
+    SDL_GLContext glContext_ = nullptr;
+    std::unique_ptr<glw::State> state_;
+};
+
 class Window {
 public:
     struct Properties {
@@ -65,9 +97,19 @@ public:
     SDL_Window* getSdlWindow() const;
     SDL_GLContext getSdlGlContext() const;
 
+    // Makes the context and its State current on the calling thread. init() does this too.
+    bool makeCurrent() const;
+    glw::State& getState() const;
+
+    // Must be called on the thread the context of this window is current on. It will still be
+    // current afterwards.
+    std::optional<SharedContext> createSharedContext() const;
+
 private:
     SDL_Window* window_ = nullptr;
     SDL_GLContext glContext_ = nullptr;
+    // Heap-allocated so it doesn't move with the window (State::setCurrent takes a pointer)
+    std::unique_ptr<glw::State> state_;
 };
 
 float getTime();
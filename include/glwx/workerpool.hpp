@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace glwx {
+// A fixed set of threads for data parallel work on the CPU (e.g. MipmapGenerator and
+// BlockCompressor). The thread that calls parallelFor works on the chunks too, so a pool with
+// 0 threads runs everything on the calling thread.
+// parallelFor may be called from multiple threads at once, the calls share the workers.
+class WorkerPool {
+public:
+    using RangeFunc = std::function<void(size_t begin, size_t end)>;
+
+    // One less than the number of hardware threads, because the calling thread works too
+    static size_t getDefaultThreadCount();
+
+    explicit WorkerPool(size_t threads = getDefaultThreadCount());
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    WorkerPool(WorkerPool&&) = delete;
+    WorkerPool& operator=(WorkerPool&&) = delete;
+
+    // Calls func for chunks of [0, count) on all threads and returns when all of them are done
+    void parallelFor(size_t count, size_t chunkSize, const RangeFunc& func);
+
+    size_t getThreadCount() const;
+
+private:
+    struct Batch {
+        const RangeFunc* func;
+        size_t count;
+        size_t chunkSize;
+        size_t chunks;
+        std::atomic<size_t> next = 0;
+        // These are protected by mutex_
+        size_t finished = 0;
+        size_t users = 0;
+    };
+
+    bool runChunk(Batch& batch);
+    void workerMain();
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable batchCondition_;
+    std::condition_variable doneCondition_;
+    std::deque<Batch*> batches_;
+    bool stop_ = false;
+};
+}
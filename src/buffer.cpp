@@ -1,5 +1,7 @@
 #include "glw/buffer.hpp"
 
+#include <cassert>
+
 namespace glw {
 void Buffer::unbind(Target target)
 {
@@ -8,7 +10,10 @@ void Buffer::unbind(Target target)
 
 Buffer::Buffer()
 {
-    glGenBuffers(1, &buffer_);
+    if (State::instance().getDirectStateAccess())
+        glCreateBuffers(1, &buffer_);
+    else
+        glGenBuffers(1, &buffer_);
 }
 
 Buffer::~Buffer()
@@ -36,19 +41,108 @@ Buffer& Buffer::operator=(Buffer&& other)
 
 void Buffer::free()
 {
-    if (buffer_)
+    if (buffer_) {
+        State::instance().bufferDeleted(buffer_);
         glDeleteBuffers(1, &buffer_);
+    }
     buffer_ = 0;
 }
 
-// http://hacksoflife.blogspot.de/2015/06/glmapbuffer-no-longer-cool.html
-// => Don't implement map()?
+bool Buffer::storageSupported()
+{
+    return GLAD_GL_ARB_buffer_storage;
+}
 
 void Buffer::bind(Target target) const
 {
     State::instance().bindBuffer(static_cast<GLenum>(target), buffer_);
 }
 
+void Buffer::bindBase(Target target, unsigned int index) const
+{
+    State::instance().bindBufferBase(static_cast<GLenum>(target), index, buffer_);
+}
+
+void Buffer::bindRange(Target target, unsigned int index, size_t offset, size_t size) const
+{
+    State::instance().bindBufferRange(static_cast<GLenum>(target), index, buffer_, offset, size);
+}
+
+void Buffer::storage(Target target, size_t size, GLbitfield flags, const void* data)
+{
+    assert(storageSupported());
+    size_ = size;
+    if (State::instance().getDirectStateAccess()) {
+        glNamedBufferStorage(buffer_, static_cast<GLsizeiptr>(size), data, flags);
+        return;
+    }
+    bind(target);
+    glBufferStorage(static_cast<GLenum>(target), static_cast<GLsizeiptr>(size), data, flags);
+    unbind(target);
+}
+
+void* Buffer::map(Target target, size_t offset, size_t size, GLbitfield access) const
+{
+    if (State::instance().getDirectStateAccess())
+        return glMapNamedBufferRange(buffer_, static_cast<GLintptr>(offset),
+            static_cast<GLsizeiptr>(size), access);
+    // The mapping stays valid after the buffer is unbound
+    bind(target);
+    void* ptr = glMapBufferRange(static_cast<GLenum>(target), static_cast<GLintptr>(offset),
+        static_cast<GLsizeiptr>(size), access);
+    unbind(target);
+    return ptr;
+}
+
+void Buffer::flushMappedRange(Target target, size_t offset, size_t size) const
+{
+    if (State::instance().getDirectStateAccess()) {
+        glFlushMappedNamedBufferRange(
+            buffer_, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+        return;
+    }
+    bind(target);
+    glFlushMappedBufferRange(static_cast<GLenum>(target), static_cast<GLintptr>(offset),
+        static_cast<GLsizeiptr>(size));
+    unbind(target);
+}
+
+bool Buffer::unmap(Target target) const
+{
+    if (State::instance().getDirectStateAccess())
+        return glUnmapNamedBuffer(buffer_) == GL_TRUE;
+    bind(target);
+    const auto res = glUnmapBuffer(static_cast<GLenum>(target));
+    unbind(target);
+    return res == GL_TRUE;
+}
+
+void Buffer::dataBytes(Target target, UsageHint usage, const void* data, size_t size)
+{
+    size_ = size;
+    if (State::instance().getDirectStateAccess()) {
+        glNamedBufferData(buffer_, static_cast<GLsizeiptr>(size), data, static_cast<GLenum>(usage));
+        return;
+    }
+    bind(target);
+    glBufferData(static_cast<GLenum>(target), static_cast<GLsizeiptr>(size), data,
+        static_cast<GLenum>(usage));
+    unbind(target);
+}
+
+void Buffer::subDataBytes(Target target, size_t offset, const void* data, size_t size) const
+{
+    if (State::instance().getDirectStateAccess()) {
+        glNamedBufferSubData(
+            buffer_, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+        return;
+    }
+    bind(target);
+    glBufferSubData(static_cast<GLenum>(target), static_cast<GLintptr>(offset),
+        static_cast<GLsizeiptr>(size), data);
+    unbind(target);
+}
+
 GLuint Buffer::getBuffer() const
 {
     return buffer_;
@@ -0,0 +1,74 @@
+#include "glw/fence.hpp"
+
+namespace glw {
+Fence::~Fence()
+{
+    free();
+}
+
+Fence::Fence(Fence&& other)
+    : sync_(other.sync_)
+{
+    other.sync_ = nullptr;
+}
+
+Fence& Fence::operator=(Fence&& other)
+{
+    free();
+    sync_ = other.sync_;
+    other.sync_ = nullptr;
+    return *this;
+}
+
+void Fence::free()
+{
+    if (sync_)
+        glDeleteSync(sync_);
+    sync_ = nullptr;
+}
+
+void Fence::insert()
+{
+    free();
+    sync_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool Fence::isSignaled() const
+{
+    if (!sync_)
+        return true;
+    GLint status = GL_UNSIGNALED;
+    glGetSynciv(sync_, GL_SYNC_STATUS, 1, nullptr, &status);
+    return status == GL_SIGNALED;
+}
+
+Fence::WaitResult Fence::clientWait(uint64_t timeoutNs) const
+{
+    if (!sync_)
+        return WaitResult::AlreadySignaled;
+    return static_cast<WaitResult>(
+        glClientWaitSync(sync_, GL_SYNC_FLUSH_COMMANDS_BIT, static_cast<GLuint64>(timeoutNs)));
+}
+
+bool Fence::wait() const
+{
+    // GL_TIMEOUT_IGNORED is only allowed for glWaitSync, so we have to loop
+    constexpr uint64_t timeout = 1000 * 1000 * 1000; // 1s
+    while (true) {
+        switch (clientWait(timeout)) {
+        case WaitResult::AlreadySignaled:
+        case WaitResult::ConditionSatisfied:
+            return true;
+        case WaitResult::WaitFailed:
+            return false;
+        case WaitResult::TimeoutExpired:
+            break;
+        }
+    }
+}
+
+GLsync Fence::getSync() const
+{
+    return sync_;
+}
+}
@@ -86,6 +86,19 @@ void Framebuffer::detach(Attachment attachment)
     detach(Target::Both, attachment);
 }
 
+void Framebuffer::readBuffer(Attachment attachment) const
+{
+    bind(Target::Read);
+    glReadBuffer(static_cast<GLenum>(attachment));
+}
+
+void Framebuffer::readPixels(int x, int y, size_t width, size_t height,
+    Texture::DataFormat dataFormat, Texture::DataType dataType, void* data)
+{
+    glReadPixels(x, y, static_cast<GLsizei>(width), static_cast<GLsizei>(height),
+        static_cast<GLenum>(dataFormat), static_cast<GLenum>(dataType), data);
+}
+
 Framebuffer::Status Framebuffer::getStatus(Target target) const
 {
     bind(target);
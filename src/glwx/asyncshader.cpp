@@ -0,0 +1,104 @@
+#include "glwx/asyncshader.hpp"
+
+#include <algorithm>
+#include <thread>
+
+using namespace glw;
+
+namespace glwx {
+ShaderProgramFuture::ShaderProgramFuture(std::shared_ptr<Shared> shared)
+    : shared_(std::move(shared))
+{
+}
+
+bool ShaderProgramFuture::isReady() const
+{
+    return shared_ && shared_->ready;
+}
+
+bool ShaderProgramFuture::isSuccessful() const
+{
+    return isReady() && shared_->program.has_value();
+}
+
+std::optional<ShaderProgram> ShaderProgramFuture::get()
+{
+    if (!isReady())
+        return std::nullopt;
+    return std::exchange(shared_->program, std::nullopt);
+}
+
+AsyncShaderCompiler::AsyncShaderCompiler(unsigned int maxThreads)
+{
+    if (getParallelCompileSupported())
+        glMaxShaderCompilerThreadsKHR(maxThreads);
+}
+
+ShaderProgramFuture AsyncShaderCompiler::add(const std::vector<Stage>& stages)
+{
+    Job job;
+    for (const auto& [type, source] : stages) {
+        auto& shader = job.shaders.emplace_back(type);
+        shader.setSource(source);
+        shader.startCompile();
+        job.program.attach(shader);
+    }
+    // We don't wait for the compiles, if one of them fails, the link fails too
+    job.program.startLink();
+    job.shared = std::make_shared<ShaderProgramFuture::Shared>();
+    auto future = ShaderProgramFuture(job.shared);
+    jobs_.push_back(std::move(job));
+    return future;
+}
+
+ShaderProgramFuture AsyncShaderCompiler::add(
+    std::string_view vertSource, std::string_view fragSource)
+{
+    return add({ { Shader::Type::Vertex, vertSource }, { Shader::Type::Fragment, fragSource } });
+}
+
+void AsyncShaderCompiler::update()
+{
+    for (auto& job : jobs_) {
+        if (job.program.isLinkFinished())
+            resolve(job);
+    }
+    jobs_.erase(std::remove_if(jobs_.begin(), jobs_.end(),
+                    [](const Job& job) { return job.shared->ready; }),
+        jobs_.end());
+}
+
+void AsyncShaderCompiler::finish()
+{
+    while (!jobs_.empty()) {
+        update();
+        if (!jobs_.empty())
+            std::this_thread::yield();
+    }
+}
+
+size_t AsyncShaderCompiler::getPendingCount() const
+{
+    return jobs_.size();
+}
+
+void AsyncShaderCompiler::resolve(Job& job)
+{
+    const auto linkRes = job.program.getLinkResult();
+    if (!linkRes.log.empty())
+        LOG_WARNING("Link log: {}", linkRes.log);
+    if (!linkRes) {
+        // Only now it's worth asking the shaders what went wrong
+        for (const auto& shader : job.shaders) {
+            const auto compileRes = shader.getCompileResult();
+            if (!compileRes.log.empty())
+                LOG_WARNING("Shader log: {}", compileRes.log);
+        }
+        LOG_ERROR("Could not build shader program");
+    } else {
+        job.program.detach();
+        job.shared->program = std::move(job.program);
+    }
+    job.shared->ready = true;
+}
+}
@@ -0,0 +1,775 @@
+#include "glwx/blockcompressor.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include <fmt/format.h>
+#include <fmt/std.h>
+
+#include "glw/log.hpp"
+#include "glwx/utility.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define GLWX_BLOCKCOMPRESSOR_SSE2
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define GLWX_BLOCKCOMPRESSOR_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace glw;
+
+namespace glwx {
+namespace {
+    // The number of block rows in a chunk is chosen, so every chunk is about this many blocks
+    constexpr size_t chunkBlocks = 256;
+
+    // Part of the cache key, so old cache files are ignored when the output of the encoder changes
+    constexpr uint32_t encoderVersion = 1;
+
+    // A palette entry that is never the closest one
+    constexpr float unusedPaletteValue = 1e9f;
+
+    // The 16 texels of a block in row order as separate channels, so 4 texels can be processed at
+    // once.
+    struct ColorBlock {
+        alignas(16) std::array<float, 16> r;
+        alignas(16) std::array<float, 16> g;
+        alignas(16) std::array<float, 16> b;
+        // Texels that are encoded with the transparent index in 3 color mode
+        std::array<bool, 16> transparent;
+    };
+
+    struct Color {
+        float r, g, b;
+    };
+
+    struct Palette {
+        alignas(16) std::array<float, 4> r;
+        alignas(16) std::array<float, 4> g;
+        alignas(16) std::array<float, 4> b;
+    };
+
+    struct ColorResult {
+        uint16_t c0;
+        uint16_t c1;
+        std::array<uint8_t, 16> indices;
+        float error;
+    };
+
+    uint16_t toRgb565(const Color& c)
+    {
+        const auto q = [](float v, float max) {
+            return static_cast<uint16_t>(std::clamp(v, 0.0f, 255.0f) * max / 255.0f + 0.5f);
+        };
+        return static_cast<uint16_t>((q(c.r, 31.0f) << 11) | (q(c.g, 63.0f) << 5) | q(c.b, 31.0f));
+    }
+
+    Color fromRgb565(uint16_t c)
+    {
+        const auto r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+        return {
+            static_cast<float>((r << 3) | (r >> 2)),
+            static_cast<float>((g << 2) | (g >> 4)),
+            static_cast<float>((b << 3) | (b >> 2)),
+        };
+    }
+
+    Color lerp(const Color& a, const Color& b, float t)
+    {
+        return { a.r + (b.r - a.r) * t, a.g + (b.g - a.g) * t, a.b + (b.b - a.b) * t };
+    }
+
+    Palette makePalette(uint16_t c0, uint16_t c1, bool threeColor)
+    {
+        const auto e0 = fromRgb565(c0), e1 = fromRgb565(c1);
+        // In 3 color mode index 3 is black (or transparent), which is only used for the
+        // transparent texels, so it's made unreachable for the others.
+        const auto e2 = threeColor ? lerp(e0, e1, 0.5f) : lerp(e0, e1, 1.0f / 3.0f);
+        const auto e3 = threeColor ? Color { unusedPaletteValue, unusedPaletteValue, 0.0f }
+                                   : lerp(e0, e1, 2.0f / 3.0f);
+        return {
+            { e0.r, e1.r, e2.r, e3.r },
+            { e0.g, e1.g, e2.g, e3.g },
+            { e0.b, e1.b, e2.b, e3.b },
+        };
+    }
+
+    // Finds the closest palette entry for every texel and returns the sum of the squared
+    // distances of the texels that are not transparent.
+    float findIndices(
+        const ColorBlock& block, const Palette& palette, std::array<uint8_t, 16>& indices)
+    {
+        alignas(16) std::array<float, 16> dist;
+#if defined(GLWX_BLOCKCOMPRESSOR_SSE2)
+        for (size_t i = 0; i < 16; i += 4) {
+            const auto r = _mm_load_ps(block.r.data() + i);
+            const auto g = _mm_load_ps(block.g.data() + i);
+            const auto b = _mm_load_ps(block.b.data() + i);
+            auto best = _mm_set1_ps(std::numeric_limits<float>::max());
+            auto bestIndex = _mm_setzero_si128();
+            for (int p = 0; p < 4; ++p) {
+                const auto dr = _mm_sub_ps(r, _mm_set1_ps(palette.r[p]));
+                const auto dg = _mm_sub_ps(g, _mm_set1_ps(palette.g[p]));
+                const auto db = _mm_sub_ps(b, _mm_set1_ps(palette.b[p]));
+                const auto d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)),
+                    _mm_mul_ps(db, db));
+                const auto closer = _mm_cmplt_ps(d, best);
+                best = _mm_min_ps(d, best);
+                // No blendv in SSE2
+                const auto mask = _mm_castps_si128(closer);
+                bestIndex = _mm_or_si128(_mm_andnot_si128(mask, bestIndex),
+                    _mm_and_si128(mask, _mm_set1_epi32(p)));
+            }
+            _mm_store_ps(dist.data() + i, best);
+            alignas(16) std::array<int32_t, 4> idx;
+            _mm_store_si128(reinterpret_cast<__m128i*>(idx.data()), bestIndex);
+            for (size_t j = 0; j < 4; ++j)
+                indices[i + j] = static_cast<uint8_t>(idx[j]);
+        }
+#elif defined(GLWX_BLOCKCOMPRESSOR_NEON)
+        for (size_t i = 0; i < 16; i += 4) {
+            const auto r = vld1q_f32(block.r.data() + i);
+            const auto g = vld1q_f32(block.g.data() + i);
+            const auto b = vld1q_f32(block.b.data() + i);
+            auto best = vdupq_n_f32(std::numeric_limits<float>::max());
+            auto bestIndex = vdupq_n_u32(0);
+            for (uint32_t p = 0; p < 4; ++p) {
+                const auto dr = vsubq_f32(r, vdupq_n_f32(palette.r[p]));
+                const auto dg = vsubq_f32(g, vdupq_n_f32(palette.g[p]));
+                const auto db = vsubq_f32(b, vdupq_n_f32(palette.b[p]));
+                const auto d = vmlaq_f32(vmlaq_f32(vmulq_f32(dr, dr), dg, dg), db, db);
+                const auto closer = vcltq_f32(d, best);
+                best = vminq_f32(d, best);
+                bestIndex = vbslq_u32(closer, vdupq_n_u32(p), bestIndex);
+            }
+            vst1q_f32(dist.data() + i, best);
+            std::array<uint32_t, 4> idx;
+            vst1q_u32(idx.data(), bestIndex);
+            for (size_t j = 0; j < 4; ++j)
+                indices[i + j] = static_cast<uint8_t>(idx[j]);
+        }
+#else
+        for (size_t i = 0; i < 16; ++i) {
+            dist[i] = std::numeric_limits<float>::max();
+            for (uint8_t p = 0; p < 4; ++p) {
+                const auto dr = block.r[i] - palette.r[p];
+                const auto dg = block.g[i] - palette.g[p];
+                const auto db = block.b[i] - palette.b[p];
+                const auto d = dr * dr + dg * dg + db * db;
+                if (d < dist[i]) {
+                    dist[i] = d;
+                    indices[i] = p;
+                }
+            }
+        }
+#endif
+        float error = 0.0f;
+        for (size_t i = 0; i < 16; ++i) {
+            if (block.transparent[i])
+                indices[i] = 3;
+            else
+                error += dist[i];
+        }
+        return error;
+    }
+
+    ColorResult evaluate(const ColorBlock& block, uint16_t c0, uint16_t c1, bool threeColor)
+    {
+        ColorResult res { c0, c1, {}, 0.0f };
+        res.error = findIndices(block, makePalette(c0, c1, threeColor), res.indices);
+        return res;
+    }
+
+    // Solves for the endpoints that minimize the squared error for fixed indices
+    // (Castaño, "High Quality DXT Compression using CUDA"). Returns false if the system is
+    // singular, i.e. all texels use the same weights.
+    bool fitEndpoints(const ColorBlock& block, const std::array<uint8_t, 16>& indices,
+        bool threeColor, Color& e0, Color& e1)
+    {
+        static constexpr std::array<float, 4> fourColorWeights { 1.0f, 0.0f, 2.0f / 3.0f,
+            1.0f / 3.0f };
+        static constexpr std::array<float, 4> threeColorWeights { 1.0f, 0.0f, 0.5f, 0.0f };
+        const auto& weights = threeColor ? threeColorWeights : fourColorWeights;
+        float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+        Color ax { 0.0f, 0.0f, 0.0f }, bx { 0.0f, 0.0f, 0.0f };
+        for (size_t i = 0; i < 16; ++i) {
+            if (block.transparent[i])
+                continue;
+            const auto a = weights[indices[i]], b = 1.0f - a;
+            aa += a * a;
+            bb += b * b;
+            ab += a * b;
+            ax = { ax.r + a * block.r[i], ax.g + a * block.g[i], ax.b + a * block.b[i] };
+            bx = { bx.r + b * block.r[i], bx.g + b * block.g[i], bx.b + b * block.b[i] };
+        }
+        const auto det = aa * bb - ab * ab;
+        if (std::abs(det) < 1e-6f)
+            return false;
+        const auto f = 1.0f / det;
+        e0 = { (ax.r * bb - bx.r * ab) * f, (ax.g * bb - bx.g * ab) * f,
+            (ax.b * bb - bx.b * ab) * f };
+        e1 = { (bx.r * aa - ax.r * ab) * f, (bx.g * aa - ax.g * ab) * f,
+            (bx.b * aa - ax.b * ab) * f };
+        return true;
+    }
+
+    // The bounding box of the colors with the diagonal flipped according to the sign of the
+    // covariances, like stb_dxt and squish do for their fast modes
+    void boundingBoxEndpoints(const ColorBlock& block, Color& e0, Color& e1)
+    {
+        Color min { 255.0f, 255.0f, 255.0f }, max { 0.0f, 0.0f, 0.0f }, mean { 0.0f, 0.0f, 0.0f };
+        float n = 0.0f;
+        for (size_t i = 0; i < 16; ++i) {
+            if (block.transparent[i])
+                continue;
+            min = { std::min(min.r, block.r[i]), std::min(min.g, block.g[i]),
+                std::min(min.b, block.b[i]) };
+            max = { std::max(max.r, block.r[i]), std::max(max.g, block.g[i]),
+                std::max(max.b, block.b[i]) };
+            mean = { mean.r + block.r[i], mean.g + block.g[i], mean.b + block.b[i] };
+            n += 1.0f;
+        }
+        mean = { mean.r / n, mean.g / n, mean.b / n };
+        float covRg = 0.0f, covRb = 0.0f, covGb = 0.0f;
+        for (size_t i = 0; i < 16; ++i) {
+            if (block.transparent[i])
+                continue;
+            const auto r = block.r[i] - mean.r, g = block.g[i] - mean.g, b = block.b[i] - mean.b;
+            covRg += r * g;
+            covRb += r * b;
+            covGb += g * b;
+        }
+        // Pull the endpoints in a little, because the extremes are rarely hit by the
+        // interpolated colors anyway (this is what stb_dxt does too)
+        const auto inset = [](float& lo, float& hi) {
+            const auto d = (hi - lo) / 16.0f;
+            lo += d;
+            hi -= d;
+        };
+        inset(min.r, max.r);
+        inset(min.g, max.g);
+        inset(min.b, max.b);
+        // If red is constant, green is the reference for blue
+        const auto flipG = covRg < 0.0f;
+        const auto flipB = (max.r > min.r ? covRb : (flipG ? -covGb : covGb)) < 0.0f;
+        e0 = { max.r, flipG ? min.g : max.g, flipB ? min.b : max.b };
+        e1 = { min.r, flipG ? max.g : min.g, flipB ? max.b : min.b };
+    }
+
+    // The extent of the colors along their principal axis, which is found with a few power
+    // iterations on the covariance matrix
+    void principalAxisEndpoints(const ColorBlock& block, Color& e0, Color& e1)
+    {
+        Color mean { 0.0f, 0.0f, 0.0f };
+        float n = 0.0f;
+        for (size_t i = 0; i < 16; ++i) {
+            if (block.transparent[i])
+                continue;
+            mean = { mean.r + block.r[i], mean.g + block.g[i], mean.b + block.b[i] };
+            n += 1.0f;
+        }
+        mean = { mean.r / n, mean.g / n, mean.b / n };
+
+        std::array<float, 6> cov {}; // rr, rg, rb, gg, gb, bb
+        for (size_t i = 0; i < 16; ++i) {
+            if (block.transparent[i])
+                continue;
+            const auto r = block.r[i] - mean.r, g = block.g[i] - mean.g, b = block.b[i] - mean.b;
+            cov[0] += r * r;
+            cov[1] += r * g;
+            cov[2] += r * b;
+            cov[3] += g * g;
+            cov[4] += g * b;
+            cov[5] += b * b;
+        }
+
+        // Start with the bounding box diagonal, which is usually close already
+        Color bb0, bb1;
+        boundingBoxEndpoints(block, bb0, bb1);
+        Color axis { bb0.r - bb1.r, bb0.g - bb1.g, bb0.b - bb1.b };
+        if (axis.r == 0.0f && axis.g == 0.0f && axis.b == 0.0f)
+            axis = { 1.0f, 1.0f, 1.0f };
+        for (int it = 0; it < 4; ++it) {
+            const Color next {
+                cov[0] * axis.r + cov[1] * axis.g + cov[2] * axis.b,
+                cov[1] * axis.r + cov[3] * axis.g + cov[4] * axis.b,
+                cov[2] * axis.r + cov[4] * axis.g + cov[5] * axis.b,
+            };
+            const auto len = std::max({ std::abs(next.r), std::abs(next.g), std::abs(next.b) });
+            if (len < 1e-6f)
+                break;
+            axis = { next.r / len, next.g / len, next.b / len };
+        }
+
+        float minT = std::numeric_limits<float>::max();
+        float maxT = std::numeric_limits<float>::lowest();
+        for (size_t i = 0; i < 16; ++i) {
+            if (block.transparent[i])
+                continue;
+            const auto t = (block.r[i] - mean.r) * axis.r + (block.g[i] - mean.g) * axis.g
+                + (block.b[i] - mean.b) * axis.b;
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+        const auto len2 = axis.r * axis.r + axis.g * axis.g + axis.b * axis.b;
+        minT /= len2;
+        maxT /= len2;
+        e0 = { mean.r + axis.r * maxT, mean.g + axis.g * maxT, mean.b + axis.b * maxT };
+        e1 = { mean.r + axis.r * minT, mean.g + axis.g * minT, mean.b + axis.b * minT };
+    }
+
+    ColorResult refine(
+        const ColorBlock& block, ColorResult best, bool threeColor, int maxIterations)
+    {
+        for (int it = 0; it < maxIterations; ++it) {
+            Color e0, e1;
+            if (!fitEndpoints(block, best.indices, threeColor, e0, e1))
+                break;
+            const auto res = evaluate(block, toRgb565(e0), toRgb565(e1), threeColor);
+            if (res.error >= best.error)
+                break;
+            best = res;
+        }
+        return best;
+    }
+
+    // Fixes the order of the endpoints, which selects the mode, and packs the block
+    uint64_t packColorBlock(ColorResult res, bool threeColor)
+    {
+        if (threeColor) {
+            // Requires c0 <= c1
+            if (res.c0 > res.c1) {
+                std::swap(res.c0, res.c1);
+                for (auto& idx : res.indices) {
+                    if (idx < 2)
+                        idx ^= 1;
+                }
+            }
+        } else {
+            // Requires c0 > c1
+            if (res.c0 < res.c1) {
+                std::swap(res.c0, res.c1);
+                for (auto& idx : res.indices)
+                    idx ^= 1; // 0 <-> 1, 2 <-> 3
+            } else if (res.c0 == res.c1) {
+                // This would be 3 color mode, so only use index 0
+                res.indices.fill(0);
+            }
+        }
+        uint32_t indices = 0;
+        for (size_t i = 0; i < 16; ++i)
+            indices |= static_cast<uint32_t>(res.indices[i]) << (2 * i);
+        return static_cast<uint64_t>(res.c0) | (static_cast<uint64_t>(res.c1) << 16)
+            | (static_cast<uint64_t>(indices) << 32);
+    }
+
+    // allowThreeColor is only true for BC1, because BC2/BC3 always use 4 color mode
+    uint64_t encodeColorBlock(
+        const ColorBlock& block, BlockCompressor::Quality quality, bool allowThreeColor)
+    {
+        using Quality = BlockCompressor::Quality;
+        const auto transparent
+            = std::count(block.transparent.begin(), block.transparent.end(), true);
+        assert(allowThreeColor || transparent == 0);
+        if (transparent == 16)
+            return 0xffffffff00000000ull; // Both endpoints black, all indices 3
+        const auto threeColor = transparent > 0;
+
+        Color e0, e1;
+        if (quality == Quality::Fast) {
+            boundingBoxEndpoints(block, e0, e1);
+            return packColorBlock(
+                evaluate(block, toRgb565(e0), toRgb565(e1), threeColor), threeColor);
+        }
+
+        principalAxisEndpoints(block, e0, e1);
+        auto best = evaluate(block, toRgb565(e0), toRgb565(e1), threeColor);
+        if (quality == Quality::Normal)
+            return packColorBlock(refine(block, best, threeColor, 1), threeColor);
+
+        constexpr int highIterations = 8;
+        best = refine(block, best, threeColor, highIterations);
+        boundingBoxEndpoints(block, e0, e1);
+        const auto bbox = refine(block, evaluate(block, toRgb565(e0), toRgb565(e1), threeColor),
+            threeColor, highIterations);
+        if (bbox.error < best.error)
+            best = bbox;
+        return packColorBlock(best, threeColor);
+    }
+
+    struct AlphaResult {
+        uint8_t a0;
+        uint8_t a1;
+        std::array<uint8_t, 16> indices;
+        uint32_t error;
+    };
+
+    AlphaResult evaluateAlpha(const std::array<uint8_t, 16>& values, uint8_t a0, uint8_t a1)
+    {
+        // a0 > a1 selects 8 interpolated values, otherwise 6 and 0 and 255
+        const auto eightValues = a0 > a1;
+        const auto steps = eightValues ? 7 : 5;
+        std::array<int, 8> palette { a0, a1 };
+        for (int i = 1; i < steps; ++i)
+            palette[i + 1] = ((steps - i) * a0 + i * a1 + steps / 2) / steps;
+        if (!eightValues) {
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+        // The indices in order from a0 to a1
+        static constexpr std::array<uint8_t, 8> eightOrder { 0, 2, 3, 4, 5, 6, 7, 1 };
+        static constexpr std::array<uint8_t, 6> sixOrder { 0, 2, 3, 4, 5, 1 };
+        const auto order = eightValues ? eightOrder.data() : sixOrder.data();
+
+        AlphaResult res { a0, a1, {}, 0 };
+        const auto scale = a0 != a1 ? static_cast<float>(steps) / (a1 - a0) : 0.0f;
+        for (size_t i = 0; i < 16; ++i) {
+            const auto v = static_cast<int>(values[i]);
+            // The palette is (almost) evenly spaced, so the closest entry is the rounded position
+            // along it or one of its neighbours, because of the rounding of the palette.
+            const auto t = std::clamp(static_cast<float>(v - a0) * scale, 0.0f, float(steps));
+            const auto pos = static_cast<int>(t + 0.5f);
+            auto best = std::numeric_limits<uint32_t>::max();
+            uint8_t bestIndex = 0;
+            // Written so it compiles to conditional moves, because the branches would be random
+            const auto consider = [&](uint8_t index) {
+                const auto d = v - palette[index];
+                const auto e = static_cast<uint32_t>(d * d);
+                const auto closer = e < best;
+                best = closer ? e : best;
+                bestIndex = closer ? index : bestIndex;
+            };
+            consider(order[std::max(pos - 1, 0)]);
+            consider(order[pos]);
+            consider(order[std::min(pos + 1, steps)]);
+            if (!eightValues) {
+                consider(6);
+                consider(7);
+            }
+            res.indices[i] = bestIndex;
+            res.error += best;
+        }
+        return res;
+    }
+
+    uint64_t packAlphaBlock(const AlphaResult& res)
+    {
+        uint64_t block = static_cast<uint64_t>(res.a0) | (static_cast<uint64_t>(res.a1) << 8);
+        for (size_t i = 0; i < 16; ++i)
+            block |= static_cast<uint64_t>(res.indices[i]) << (16 + 3 * i);
+        return block;
+    }
+
+    uint64_t encodeAlphaBlock(
+        const std::array<uint8_t, 16>& values, BlockCompressor::Quality quality)
+    {
+        using Quality = BlockCompressor::Quality;
+        const auto [minIt, maxIt] = std::minmax_element(values.begin(), values.end());
+        const int min = *minIt, max = *maxIt;
+        const auto eight
+            = evaluateAlpha(values, static_cast<uint8_t>(max), static_cast<uint8_t>(min));
+        if (quality == Quality::Fast || eight.error == 0)
+            return packAlphaBlock(eight);
+
+        // 0 and 255 are exact in the 6 value mode, so the interpolated values only have to
+        // cover the rest.
+        int innerMin = 255, innerMax = 0;
+        for (const auto v : values) {
+            if (v != 0 && v != 255) {
+                innerMin = std::min(innerMin, static_cast<int>(v));
+                innerMax = std::max(innerMax, static_cast<int>(v));
+            }
+        }
+        if (innerMin > innerMax)
+            innerMin = innerMax = 0; // Only 0 and 255
+        const auto six = evaluateAlpha(
+            values, static_cast<uint8_t>(innerMin), static_cast<uint8_t>(innerMax));
+        if (quality == Quality::Normal)
+            return packAlphaBlock(six.error < eight.error ? six : eight);
+
+        // Move one endpoint at a time by one step as long as that decreases the error, without
+        // switching the mode. Pulling the endpoints in a little is usually what helps.
+        const auto descend = [&values](AlphaResult best) {
+            static constexpr std::array<std::array<int, 2>, 4> moves {
+                { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } }
+            };
+            constexpr int maxSteps = 16;
+            const auto eightValues = best.a0 > best.a1;
+            for (int step = 0; step < maxSteps && best.error > 0; ++step) {
+                auto improved = false;
+                for (const auto& [d0, d1] : moves) {
+                    const auto a0 = std::clamp(best.a0 + d0, 0, 255);
+                    const auto a1 = std::clamp(best.a1 + d1, 0, 255);
+                    if ((a0 > a1) != eightValues)
+                        continue;
+                    const auto res
+                        = evaluateAlpha(values, static_cast<uint8_t>(a0), static_cast<uint8_t>(a1));
+                    if (res.error < best.error) {
+                        best = res;
+                        improved = true;
+                    }
+                }
+                if (!improved)
+                    break;
+            }
+            return best;
+        };
+        const auto bestEight = descend(eight);
+        const auto bestSix = descend(six);
+        return packAlphaBlock(bestSix.error < bestEight.error ? bestSix : bestEight);
+    }
+
+    void writeBlock(uint8_t* dst, uint64_t block)
+    {
+        // Blocks are little endian
+        for (size_t i = 0; i < 8; ++i)
+            dst[i] = static_cast<uint8_t>(block >> (8 * i));
+    }
+}
+
+glw::ImageFormat BlockCompressor::getImageFormat(Format format, size_t channels, bool srgb)
+{
+    switch (format) {
+    case Format::Bc1:
+        if (channels == 4)
+            return srgb ? ImageFormat::CompressedSrgbAlphaS3tcDxt1
+                        : ImageFormat::CompressedRgbaS3tcDxt1;
+        return srgb ? ImageFormat::CompressedSrgbS3tcDxt1 : ImageFormat::CompressedRgbS3tcDxt1;
+    case Format::Bc3:
+        return srgb ? ImageFormat::CompressedSrgbAlphaS3tcDxt5
+                    : ImageFormat::CompressedRgbaS3tcDxt5;
+    case Format::Bc4:
+        return ImageFormat::CompressedRedRgtc1;
+    case Format::Bc5:
+        return ImageFormat::CompressedRgRgtc2;
+    default:
+        assert(false && "Invalid block format");
+        return ImageFormat::Invalid;
+    }
+}
+
+BlockCompressor::BlockCompressor(size_t threads)
+    : BlockCompressor(std::make_shared<WorkerPool>(threads))
+{
+}
+
+BlockCompressor::BlockCompressor(std::shared_ptr<WorkerPool> pool)
+    : pool_(std::move(pool))
+    , mipmaps_(pool_)
+{
+}
+
+CompressedTextureData BlockCompressor::compress(const uint8_t* data, size_t width, size_t height,
+    size_t channels, const Options& options) const
+{
+    assert(channels >= 1 && channels <= 4);
+    const auto srgb
+        = options.srgb && (options.format == Format::Bc1 || options.format == Format::Bc3);
+    std::vector<MipmapGenerator::Level> mips;
+    if (options.mipmaps && (width > 1 || height > 1))
+        mips = mipmaps_.generate(
+            data, width, height, channels, { options.mipmapFilter, srgb, options.alphaCutoff });
+
+    CompressedTextureData tex;
+    tex.format = getImageFormat(options.format, channels, srgb);
+    tex.width = width;
+    tex.height = height;
+    tex.levels = mips.size() + 1;
+    size_t offset = 0;
+    for (size_t level = 0; level < tex.levels; ++level) {
+        const auto w = level == 0 ? width : mips[level - 1].width;
+        const auto h = level == 0 ? height : mips[level - 1].height;
+        const auto size = getCompressedImageSize(tex.format, w, h);
+        tex.images.push_back({ w, h, offset, size });
+        offset += size;
+    }
+    tex.data.resize(offset);
+
+    compressImage(data, width, height, channels, width * channels, options.format,
+        options.quality, tex.data.data());
+    for (size_t i = 0; i < mips.size(); ++i) {
+        const auto& mip = mips[i];
+        compressImage(mip.data.data(), mip.width, mip.height, channels, mip.rowPitch,
+            options.format, options.quality, tex.data.data() + tex.images[i + 1].offset);
+    }
+    return tex;
+}
+
+void BlockCompressor::compressImage(const uint8_t* data, size_t width, size_t height,
+    size_t channels, size_t rowPitch, Format format, Quality quality, uint8_t* dst) const
+{
+    assert(channels >= 1 && channels <= 4);
+    const auto blocksX = (width + 3) / 4;
+    const auto blocksY = (height + 3) / 4;
+    const auto blockSize = format == Format::Bc1 || format == Format::Bc4 ? 8 : 16;
+    const auto chunkRows = std::max(size_t(1), chunkBlocks / blocksX);
+    pool_->parallelFor(blocksY, chunkRows, [&](size_t begin, size_t end) {
+        std::array<std::array<uint8_t, 4>, 16> texels;
+        ColorBlock color;
+        std::array<uint8_t, 16> values;
+        for (size_t by = begin; by < end; ++by) {
+            auto out = dst + by * blocksX * blockSize;
+            for (size_t bx = 0; bx < blocksX; ++bx) {
+                // Blocks that stick out of the image repeat the last row/column
+                for (size_t i = 0; i < 16; ++i) {
+                    const auto x = std::min(bx * 4 + i % 4, width - 1);
+                    const auto y = std::min(by * 4 + i / 4, height - 1);
+                    texels[i] = readTexelRgba(data + y * rowPitch + x * channels, channels);
+                }
+
+                const auto loadColor = [&](bool transparency) {
+                    for (size_t i = 0; i < 16; ++i) {
+                        color.r[i] = texels[i][0];
+                        color.g[i] = texels[i][1];
+                        color.b[i] = texels[i][2];
+                        color.transparent[i] = transparency && texels[i][3] < 128;
+                    }
+                };
+                const auto loadChannel = [&](size_t c) {
+                    for (size_t i = 0; i < 16; ++i)
+                        values[i] = texels[i][c];
+                };
+
+                switch (format) {
+                case Format::Bc1:
+                    loadColor(channels == 4);
+                    writeBlock(out, encodeColorBlock(color, quality, true));
+                    break;
+                case Format::Bc3:
+                    loadChannel(3);
+                    writeBlock(out, encodeAlphaBlock(values, quality));
+                    loadColor(false);
+                    writeBlock(out + 8, encodeColorBlock(color, quality, false));
+                    break;
+                case Format::Bc4:
+                    loadChannel(0);
+                    writeBlock(out, encodeAlphaBlock(values, quality));
+                    break;
+                case Format::Bc5:
+                    loadChannel(0);
+                    writeBlock(out, encodeAlphaBlock(values, quality));
+                    // A single channel would be gray, but for BC5 the second channel should be 0
+                    if (channels == 1)
+                        values.fill(0);
+                    else
+                        loadChannel(1);
+                    writeBlock(out + 8, encodeAlphaBlock(values, quality));
+                    break;
+                }
+                out += blockSize;
+            }
+        }
+    });
+}
+
+CompressedTextureCache::CompressedTextureCache(std::filesystem::path directory)
+    : directory_(std::move(directory))
+{
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec)
+        LOG_ERROR(
+            "Could not create texture cache directory '{}': {}", directory_, ec.message());
+}
+
+uint64_t CompressedTextureCache::getKey(
+    const void* data, size_t size, const BlockCompressor::Options& options)
+{
+    // Hash the fields one by one, so padding does not end up in the key
+    const std::array<uint32_t, 6> fields {
+        encoderVersion,
+        static_cast<uint32_t>(options.format),
+        static_cast<uint32_t>(options.quality),
+        options.srgb,
+        options.mipmaps,
+        static_cast<uint32_t>(options.mipmapFilter),
+    };
+    auto hash = fnv1a(fnv1aOffsetBasis, fields.data(), sizeof(fields));
+    hash = fnv1a(hash, &options.alphaCutoff, sizeof(options.alphaCutoff));
+    return fnv1a(hash, data, size);
+}
+
+std::optional<CompressedTextureData> CompressedTextureCache::load(uint64_t key)
+{
+    const auto path = getPath(key);
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+        statistics_.misses++;
+        return std::nullopt;
+    }
+    auto data = loadCompressedTexture(path);
+    if (!data) {
+        statistics_.rejected++;
+        statistics_.misses++;
+        return std::nullopt;
+    }
+    statistics_.hits++;
+    return data;
+}
+
+void CompressedTextureCache::store(uint64_t key, const CompressedTextureData& data) const
+{
+    // Write to a temporary file and rename it, so other processes never read a partial file
+    const auto path = getPath(key);
+    const auto tmpPath = getTempPath(path);
+    {
+        const auto contents = writeKtx(data);
+        std::ofstream file(tmpPath, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(contents.data()),
+            static_cast<std::streamsize>(contents.size()));
+        if (!file) {
+            LOG_ERROR("Could not write texture cache file {}", tmpPath);
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(tmpPath, ec);
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        LOG_ERROR("Could not write texture cache file {}: {}", path, ec.message());
+        std::filesystem::remove(tmpPath, ec);
+    }
+}
+
+CompressedTextureData CompressedTextureCache::compress(const BlockCompressor& compressor,
+    const uint8_t* data, size_t width, size_t height, size_t channels,
+    const BlockCompressor::Options& options)
+{
+    // The same bytes could be a different image with different dimensions
+    const std::array<uint64_t, 3> dims { width, height, channels };
+    const auto key = fnv1a(getKey(data, width * height * channels, options), dims.data(),
+        sizeof(dims));
+    if (auto cached = load(key))
+        return std::move(*cached);
+    auto tex = compressor.compress(data, width, height, channels, options);
+    store(key, tex);
+    return tex;
+}
+
+void CompressedTextureCache::clear()
+{
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory_, ec)) {
+        if (entry.path().extension() == ".ktx")
+            std::filesystem::remove(entry.path(), ec);
+    }
+}
+
+const CompressedTextureCache::Statistics& CompressedTextureCache::getStatistics() const
+{
+    return statistics_;
+}
+
+std::filesystem::path CompressedTextureCache::getPath(uint64_t key) const
+{
+    return directory_ / fmt::format("{:016x}.ktx", key);
+}
+}
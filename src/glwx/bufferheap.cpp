@@ -0,0 +1,150 @@
+#include "glwx/bufferheap.hpp"
+
+#include <algorithm>
+
+using namespace glw;
+
+namespace glwx {
+BufferHeap::Allocation::operator bool() const
+{
+    return buffer != nullptr;
+}
+
+BufferHeap::BufferHeap(Buffer::UsageHint usage, size_t pageSize)
+    : usage_(usage)
+    , pageSize_(pageSize)
+{
+}
+
+BufferHeap::Allocation BufferHeap::allocate(size_t size, size_t alignment)
+{
+    assert(size > 0 && alignment > 0);
+
+    Page* page = nullptr;
+    size_t blockOffset = 0;
+    size_t blockSize = 0;
+    size_t offset = 0;
+    for (auto it = freeBlocksBySize_.lower_bound(size); it != freeBlocksBySize_.end(); ++it) {
+        const auto aligned = (it->second.offset + alignment - 1) / alignment * alignment;
+        if (aligned + size <= it->second.offset + it->first) {
+            page = it->second.page;
+            blockOffset = it->second.offset;
+            blockSize = it->first;
+            offset = aligned;
+            break;
+        }
+    }
+
+    if (!page) {
+        page = addPage(std::max(pageSize_, size));
+        blockOffset = 0;
+        blockSize = page->size;
+        offset = 0;
+    }
+
+    // Split off the padding in front and the rest of the block behind the allocation
+    eraseFreeBlock(page, blockOffset, blockSize);
+    if (offset > blockOffset)
+        insertFreeBlock(page, blockOffset, offset - blockOffset);
+    const auto blockEnd = blockOffset + blockSize;
+    if (offset + size < blockEnd)
+        insertFreeBlock(page, offset + size, blockEnd - (offset + size));
+
+    allocatedSize_ += size;
+    return Allocation { &page->buffer, offset, size };
+}
+
+void BufferHeap::free(const Allocation& allocation)
+{
+    if (!allocation)
+        return;
+
+    const auto pageIt = std::find_if(pages_.begin(), pages_.end(),
+        [&allocation](const auto& page) { return &page->buffer == allocation.buffer; });
+    assert(pageIt != pages_.end());
+    const auto page = pageIt->get();
+
+    auto offset = allocation.offset;
+    auto size = allocation.size;
+
+    // Merge with the following free block
+    const auto next = page->freeBlocks.find(offset + size);
+    if (next != page->freeBlocks.end()) {
+        const auto nextSize = next->second;
+        eraseFreeBlock(page, offset + size, nextSize);
+        size += nextSize;
+    }
+
+    // Merge with the preceding free block
+    const auto after = page->freeBlocks.lower_bound(offset);
+    if (after != page->freeBlocks.begin()) {
+        const auto [prevOffset, prevSize] = *std::prev(after);
+        if (prevOffset + prevSize == offset) {
+            eraseFreeBlock(page, prevOffset, prevSize);
+            offset = prevOffset;
+            size += prevSize;
+        }
+    }
+
+    insertFreeBlock(page, offset, size);
+    allocatedSize_ -= allocation.size;
+}
+
+void BufferHeap::writeBytes(
+    const Allocation& allocation, size_t offset, const void* data, size_t size) const
+{
+    assert(allocation && offset + size <= allocation.size);
+    allocation.buffer->subData(Buffer::Target::CopyWrite, allocation.offset + offset, data, size);
+}
+
+size_t BufferHeap::getPageCount() const
+{
+    return pages_.size();
+}
+
+const Buffer& BufferHeap::getBuffer(size_t page) const
+{
+    return pages_.at(page)->buffer;
+}
+
+size_t BufferHeap::getAllocatedSize() const
+{
+    return allocatedSize_;
+}
+
+size_t BufferHeap::getCapacity() const
+{
+    size_t capacity = 0;
+    for (const auto& page : pages_)
+        capacity += page->size;
+    return capacity;
+}
+
+void BufferHeap::insertFreeBlock(Page* page, size_t offset, size_t size)
+{
+    page->freeBlocks.emplace(offset, size);
+    freeBlocksBySize_.emplace(size, BlockRef { page, offset });
+}
+
+void BufferHeap::eraseFreeBlock(Page* page, size_t offset, size_t size)
+{
+    page->freeBlocks.erase(offset);
+    const auto [begin, end] = freeBlocksBySize_.equal_range(size);
+    for (auto it = begin; it != end; ++it) {
+        if (it->second.page == page && it->second.offset == offset) {
+            freeBlocksBySize_.erase(it);
+            return;
+        }
+    }
+    assert(false && "Free block not found");
+}
+
+BufferHeap::Page* BufferHeap::addPage(size_t size)
+{
+    auto& page = pages_.emplace_back(std::make_unique<Page>(Page { Buffer {}, size, {} }));
+    // CopyWrite, so we don't disturb any vertex array's element array binding
+    page->buffer.data(Buffer::Target::CopyWrite, usage_, static_cast<const void*>(nullptr), size);
+    insertFreeBlock(page.get(), 0, size);
+    return page.get();
+}
+}
@@ -1,5 +1,7 @@
 #include "glwx/buffers.hpp"
 
+#include <algorithm>
+
 namespace glwx {
 
 DefaultBuffer::DefaultBuffer(Target target)
@@ -33,6 +35,7 @@ void DefaultBuffer::unbind() const
 void BufferData::setData()
 {
     data(data_.data(), data_.size());
+    dirtyRanges_.clear();
 }
 
 void BufferData::setSubData(size_t index, size_t len) const
@@ -50,17 +53,90 @@ void BufferData::setSubData() const
 
 void BufferData::update()
 {
-    if (getSize() < data_.size())
+    if (getSize() < data_.size()) {
         setData();
-    else
-        setSubData();
+        return;
+    }
+
+    for (const auto& range : dirtyRanges_) {
+        // The data might have shrunk since the range was marked
+        if (range.offset >= data_.size())
+            break;
+        setSubData(range.offset, std::min(range.size, data_.size() - range.offset));
+    }
+    dirtyRanges_.clear();
+}
+
+void BufferData::markDirty(size_t offset, size_t size)
+{
+    if (size == 0)
+        return;
+
+    auto begin = offset;
+    auto end = offset + size;
+    // The first range that is not too far before the new one. Because the ranges are sorted and
+    // never closer than the threshold, all the ranges we have to merge with follow this one.
+    const auto first = std::lower_bound(dirtyRanges_.begin(), dirtyRanges_.end(), begin,
+        [this](const DirtyRange& range, size_t pos) {
+            return range.offset + range.size + coalesceThreshold_ < pos;
+        });
+    auto last = first;
+    while (last != dirtyRanges_.end() && last->offset <= end + coalesceThreshold_) {
+        begin = std::min(begin, last->offset);
+        end = std::max(end, last->offset + last->size);
+        ++last;
+    }
+
+    if (first == last) {
+        dirtyRanges_.insert(first, DirtyRange { begin, end - begin });
+    } else {
+        *first = DirtyRange { begin, end - begin };
+        dirtyRanges_.erase(first + 1, last);
+    }
+}
+
+void BufferData::markDirty()
+{
+    dirtyRanges_.clear();
+    markDirty(0, data_.size());
+}
+
+const std::vector<BufferData::DirtyRange>& BufferData::getDirtyRanges() const
+{
+    return dirtyRanges_;
+}
+
+void BufferData::setCoalesceThreshold(size_t threshold)
+{
+    coalesceThreshold_ = threshold;
+}
+
+size_t BufferData::getCoalesceThreshold() const
+{
+    return coalesceThreshold_;
 }
 
 std::vector<uint8_t>& BufferData::getData()
 {
+    markDirty();
     return data_;
 }
 
+std::span<uint8_t> BufferData::getData(size_t offset, size_t size)
+{
+    assert(offset + size <= data_.size());
+    markDirty(offset, size);
+    return std::span<uint8_t>(data_.data() + offset, size);
+}
+
+void BufferData::resizeData(size_t size)
+{
+    const auto oldSize = data_.size();
+    data_.resize(size);
+    if (size > oldSize)
+        markDirty(oldSize, size - oldSize);
+}
+
 const std::vector<uint8_t>& BufferData::getData() const
 {
     return data_;
@@ -68,7 +144,7 @@ const std::vector<uint8_t>& BufferData::getData() const
 
 void VertexBuffer::resize(size_t vertexCount)
 {
-    getData().resize(vertexFormat_.getStride() * vertexCount);
+    resizeData(vertexFormat_.getStride() * vertexCount);
 }
 
 const glw::VertexFormat& VertexBuffer::getVertexFormat() const
@@ -84,7 +160,7 @@ size_t VertexBuffer::getCount() const
 
 void IndexBuffer::resize(size_t indexCount)
 {
-    getData().resize(getElementSize() * indexCount);
+    resizeData(getElementSize() * indexCount);
 }
 
 glw::IndexType IndexBuffer::getIndexType() const
@@ -0,0 +1,229 @@
+#include "glwx/commandbuffer.hpp"
+
+#include <cassert>
+
+using namespace glw;
+
+namespace glwx {
+CommandBuffer::CommandBuffer(size_t capacity)
+{
+    data_.reserve(capacity);
+}
+
+void CommandBuffer::bindShader(const ShaderProgram& program)
+{
+    push(CommandType::BindShader, BindShaderCmd { &program });
+}
+
+void CommandBuffer::setUniform(UniformLocation loc, const Texture& tex)
+{
+    push(CommandType::UniformTexture, UniformTextureCmd { loc, &tex, -1 });
+}
+
+void CommandBuffer::setUniform(UniformLocation loc, const Texture& tex, unsigned int unit)
+{
+    assert(unit < State::maxTextureUnits);
+    push(CommandType::UniformTexture, UniformTextureCmd { loc, &tex, static_cast<int>(unit) });
+}
+
+void CommandBuffer::bindTexture(unsigned int unit, const Texture& tex)
+{
+    assert(unit < State::maxTextureUnits);
+    push(CommandType::BindTexture, BindTextureCmd { unit, &tex });
+}
+
+void CommandBuffer::apply(const PipelineState& pipelineState)
+{
+    // Consecutive applies of the same state (e.g. one per object) only need to be stored once
+    if (pipelineStates_.empty() || pipelineStates_.back() != pipelineState)
+        pipelineStates_.push_back(pipelineState);
+    push(CommandType::ApplyPipelineState, ApplyPipelineStateCmd { pipelineStates_.size() - 1 });
+}
+
+void CommandBuffer::setViewport(int x, int y, size_t width, size_t height)
+{
+    push(CommandType::Viewport, ViewportCmd { x, y, width, height });
+}
+
+void CommandBuffer::draw(const Primitive& primitive)
+{
+    const auto& range = primitive.getDrawRange();
+    recordDraw(primitive, range.offset, range.count, std::nullopt);
+}
+
+void CommandBuffer::draw(const Primitive& primitive, size_t offset, size_t count)
+{
+    recordDraw(primitive, offset, count, std::nullopt);
+}
+
+void CommandBuffer::draw(const Primitive& primitive, size_t instanceCount)
+{
+    const auto& range = primitive.getDrawRange();
+    recordDraw(primitive, range.offset, range.count, instanceCount);
+}
+
+void CommandBuffer::draw(
+    const Primitive& primitive, size_t offset, size_t count, size_t instanceCount)
+{
+    recordDraw(primitive, offset, count, instanceCount);
+}
+
+void CommandBuffer::submit() const
+{
+    auto& state = State::instance();
+    const ShaderProgram* program = nullptr;
+    bool drawn = false;
+
+    size_t pos = 0;
+    while (pos < data_.size()) {
+        Header header;
+        std::memcpy(&header, data_.data() + pos, sizeof(Header));
+        const auto payload = data_.data() + pos + sizeof(Header);
+        pos += header.size;
+
+        switch (header.type) {
+        case CommandType::BindShader: {
+            BindShaderCmd cmd;
+            std::memcpy(&cmd, payload, sizeof(cmd));
+            program = cmd.program;
+            program->bind();
+            break;
+        }
+        case CommandType::Uniform: {
+            UniformCmd cmd;
+            std::memcpy(&cmd, payload, sizeof(cmd));
+            assert(program && "setUniform recorded before bindShader");
+            submitUniform(*program, cmd, payload + sizeof(UniformCmd));
+            break;
+        }
+        case CommandType::UniformTexture: {
+            UniformTextureCmd cmd;
+            std::memcpy(&cmd, payload, sizeof(cmd));
+            assert(program && "setUniform recorded before bindShader");
+            if (cmd.unit < 0)
+                program->setUniform(cmd.loc, *cmd.texture);
+            else
+                program->setUniform(cmd.loc, *cmd.texture, static_cast<unsigned int>(cmd.unit));
+            break;
+        }
+        case CommandType::BindTexture: {
+            BindTextureCmd cmd;
+            std::memcpy(&cmd, payload, sizeof(cmd));
+            cmd.texture->bind(cmd.unit);
+            break;
+        }
+        case CommandType::ApplyPipelineState: {
+            ApplyPipelineStateCmd cmd;
+            std::memcpy(&cmd, payload, sizeof(cmd));
+            state.apply(pipelineStates_[cmd.index]);
+            break;
+        }
+        case CommandType::Viewport: {
+            ViewportCmd cmd;
+            std::memcpy(&cmd, payload, sizeof(cmd));
+            const auto viewport = std::tuple(cmd.x, cmd.y, cmd.width, cmd.height);
+            if (state.getViewport() != viewport)
+                state.setViewport(viewport);
+            break;
+        }
+        case CommandType::Draw: {
+            DrawCmd cmd;
+            std::memcpy(&cmd, payload, sizeof(cmd));
+            // Primitive::draw unbinds the vertex array after every draw, which we don't have to
+            // do between our own commands, because none of them touch the element array binding.
+            const auto vao = cmd.primitive->vertexArray.getVertexArray();
+            if (state.getCurrentVao() != vao)
+                state.bindVao(vao);
+            cmd.primitive->drawBound(cmd.offset, cmd.count, cmd.baseVertex,
+                cmd.instanced ? std::optional(cmd.instanceCount) : std::nullopt);
+            drawn = true;
+            break;
+        }
+        }
+    }
+
+    // Leave the vertex array unbound like Primitive::draw does
+    if (drawn)
+        state.unbindVao();
+}
+
+void CommandBuffer::clear()
+{
+    data_.clear();
+    pipelineStates_.clear();
+    commandCount_ = 0;
+}
+
+size_t CommandBuffer::getCommandCount() const
+{
+    return commandCount_;
+}
+
+size_t CommandBuffer::getSize() const
+{
+    return data_.size();
+}
+
+uint8_t* CommandBuffer::push(CommandType type, size_t payloadSize)
+{
+    static_assert(sizeof(Header) % commandAlignment == 0);
+    const auto unaligned = sizeof(Header) + payloadSize;
+    const auto size = (unaligned + commandAlignment - 1) / commandAlignment * commandAlignment;
+    const auto pos = data_.size();
+    data_.resize(pos + size);
+    const auto header = Header { type, static_cast<uint32_t>(size) };
+    std::memcpy(data_.data() + pos, &header, sizeof(Header));
+    commandCount_++;
+    return data_.data() + pos + sizeof(Header);
+}
+
+void CommandBuffer::recordUniform(
+    UniformType type, UniformLocation loc, const void* data, size_t size, size_t count)
+{
+    // The values follow the command, which is a multiple of 8 bytes, so they are aligned
+    static_assert(sizeof(UniformCmd) % commandAlignment == 0);
+    const auto cmd = UniformCmd { type, loc, count };
+    const auto payload = push(CommandType::Uniform, sizeof(UniformCmd) + size);
+    std::memcpy(payload, &cmd, sizeof(UniformCmd));
+    std::memcpy(payload + sizeof(UniformCmd), data, size);
+}
+
+void CommandBuffer::recordDraw(
+    const Primitive& primitive, size_t offset, size_t count, std::optional<size_t> instanceCount)
+{
+    push(CommandType::Draw,
+        DrawCmd { &primitive, offset, count, primitive.vertexRange.offset,
+            instanceCount.value_or(0), instanceCount.has_value() });
+}
+
+void CommandBuffer::submitUniform(
+    const ShaderProgram& program, const UniformCmd& cmd, const uint8_t* data)
+{
+    switch (cmd.type) {
+    case UniformType::Int:
+        program.setUniform(cmd.loc, reinterpret_cast<const int*>(data), cmd.count);
+        break;
+    case UniformType::Float:
+        program.setUniform(cmd.loc, reinterpret_cast<const float*>(data), cmd.count);
+        break;
+    case UniformType::Vec2:
+        program.setUniform(cmd.loc, reinterpret_cast<const glm::vec2*>(data), cmd.count);
+        break;
+    case UniformType::Vec3:
+        program.setUniform(cmd.loc, reinterpret_cast<const glm::vec3*>(data), cmd.count);
+        break;
+    case UniformType::Vec4:
+        program.setUniform(cmd.loc, reinterpret_cast<const glm::vec4*>(data), cmd.count);
+        break;
+    case UniformType::Mat2:
+        program.setUniform(cmd.loc, reinterpret_cast<const glm::mat2*>(data), cmd.count);
+        break;
+    case UniformType::Mat3:
+        program.setUniform(cmd.loc, reinterpret_cast<const glm::mat3*>(data), cmd.count);
+        break;
+    case UniformType::Mat4:
+        program.setUniform(cmd.loc, reinterpret_cast<const glm::mat4*>(data), cmd.count);
+        break;
+    }
+}
+}
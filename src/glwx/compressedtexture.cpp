@@ -0,0 +1,404 @@
+#include "glwx/compressedtexture.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <fmt/std.h>
+
+#include "glw/log.hpp"
+
+using namespace glw;
+
+namespace glwx {
+namespace {
+    constexpr std::array<uint8_t, 12> ktxIdentifier
+        = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+    constexpr uint32_t ktxEndianness = 0x04030201;
+    constexpr size_t ktxHeaderSize = 64;
+
+    constexpr uint32_t makeFourCC(char a, char b, char c, char d)
+    {
+        return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8)
+            | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+    }
+
+    constexpr uint32_t ddsMagic = makeFourCC('D', 'D', 'S', ' ');
+    constexpr size_t ddsHeaderSize = 124;
+    constexpr size_t ddsDx10HeaderSize = 20;
+    // Offsets into the header (after the magic)
+    constexpr size_t ddsHeight = 8;
+    constexpr size_t ddsWidth = 12;
+    constexpr size_t ddsMipMapCount = 24;
+    constexpr size_t ddsPixelFormatFlags = 76;
+    constexpr size_t ddsFourCC = 80;
+    constexpr size_t ddsCaps2 = 108;
+    constexpr uint32_t ddsdMipMapCount = 0x20000;
+    constexpr uint32_t ddpfAlphaPixels = 0x1;
+    constexpr uint32_t ddpfFourCC = 0x4;
+    constexpr uint32_t ddsCaps2CubeMap = 0x200;
+    constexpr uint32_t ddsCaps2AllFaces = 0xFC00;
+    constexpr uint32_t ddsCaps2Volume = 0x200000;
+    constexpr uint32_t dx10ResourceDimensionTexture2D = 3;
+    constexpr uint32_t dx10MiscTextureCube = 0x4;
+
+    uint32_t readU32(const uint8_t* ptr, bool swap = false)
+    {
+        uint32_t v;
+        std::memcpy(&v, ptr, sizeof(v));
+        if (swap)
+            v = (v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24);
+        return v;
+    }
+
+    // Whether `count` bytes at `offset` are within a buffer of `size` bytes, without overflowing
+    bool inBounds(size_t offset, size_t count, size_t size)
+    {
+        return offset <= size && count <= size - offset;
+    }
+
+    size_t getLevelCount(size_t width, size_t height)
+    {
+        size_t levels = 1;
+        while (width > 1 || height > 1) {
+            width = std::max(size_t(1), width / 2);
+            height = std::max(size_t(1), height / 2);
+            levels++;
+        }
+        return levels;
+    }
+
+    std::optional<ImageFormat> getDdsFormat(uint32_t fourCC, uint32_t pixelFormatFlags)
+    {
+        switch (fourCC) {
+        case makeFourCC('D', 'X', 'T', '1'):
+            return pixelFormatFlags & ddpfAlphaPixels ? ImageFormat::CompressedRgbaS3tcDxt1
+                                                      : ImageFormat::CompressedRgbS3tcDxt1;
+        // DXT2 and DXT4 are premultiplied, which is just a convention for the shader
+        case makeFourCC('D', 'X', 'T', '2'):
+        case makeFourCC('D', 'X', 'T', '3'):
+            return ImageFormat::CompressedRgbaS3tcDxt3;
+        case makeFourCC('D', 'X', 'T', '4'):
+        case makeFourCC('D', 'X', 'T', '5'):
+            return ImageFormat::CompressedRgbaS3tcDxt5;
+        case makeFourCC('A', 'T', 'I', '1'):
+        case makeFourCC('B', 'C', '4', 'U'):
+            return ImageFormat::CompressedRedRgtc1;
+        case makeFourCC('B', 'C', '4', 'S'):
+            return ImageFormat::CompressedSignedRedRgtc1;
+        case makeFourCC('A', 'T', 'I', '2'):
+        case makeFourCC('B', 'C', '5', 'U'):
+            return ImageFormat::CompressedRgRgtc2;
+        case makeFourCC('B', 'C', '5', 'S'):
+            return ImageFormat::CompressedSignedRgRgtc2;
+        default:
+            return std::nullopt;
+        }
+    }
+
+    std::optional<ImageFormat> getDxgiFormat(uint32_t dxgiFormat)
+    {
+        // Only the BC1-5 formats, the typeless ones are treated as UNORM
+        switch (dxgiFormat) {
+        case 70: // BC1_TYPELESS
+        case 71: // BC1_UNORM
+            return ImageFormat::CompressedRgbaS3tcDxt1;
+        case 72: // BC1_UNORM_SRGB
+            return ImageFormat::CompressedSrgbAlphaS3tcDxt1;
+        case 73: // BC2_TYPELESS
+        case 74: // BC2_UNORM
+            return ImageFormat::CompressedRgbaS3tcDxt3;
+        case 75: // BC2_UNORM_SRGB
+            return ImageFormat::CompressedSrgbAlphaS3tcDxt3;
+        case 76: // BC3_TYPELESS
+        case 77: // BC3_UNORM
+            return ImageFormat::CompressedRgbaS3tcDxt5;
+        case 78: // BC3_UNORM_SRGB
+            return ImageFormat::CompressedSrgbAlphaS3tcDxt5;
+        case 79: // BC4_TYPELESS
+        case 80: // BC4_UNORM
+            return ImageFormat::CompressedRedRgtc1;
+        case 81: // BC4_SNORM
+            return ImageFormat::CompressedSignedRedRgtc1;
+        case 82: // BC5_TYPELESS
+        case 83: // BC5_UNORM
+            return ImageFormat::CompressedRgRgtc2;
+        case 84: // BC5_SNORM
+            return ImageFormat::CompressedSignedRgRgtc2;
+        default:
+            return std::nullopt;
+        }
+    }
+}
+
+const CompressedTextureData::Image& CompressedTextureData::getImage(size_t level, size_t face) const
+{
+    assert(level < levels && face < faces);
+    return images[level * faces + face];
+}
+
+const uint8_t* CompressedTextureData::getImageData(size_t level, size_t face) const
+{
+    return data.data() + getImage(level, face).offset;
+}
+
+// https://registry.khronos.org/KTX/specs/1.0/ktxspec.v1.html
+std::optional<CompressedTextureData> parseKtx(const uint8_t* data, size_t size)
+{
+    if (size < ktxHeaderSize
+        || std::memcmp(data, ktxIdentifier.data(), ktxIdentifier.size()) != 0) {
+        LOG_ERROR("Not a KTX file");
+        return std::nullopt;
+    }
+    const auto endianness = readU32(data + 12);
+    if (endianness != ktxEndianness && readU32(data + 12, true) != ktxEndianness) {
+        LOG_ERROR("Invalid KTX endianness");
+        return std::nullopt;
+    }
+    // Compressed data consists of bytes, so only the header has to be swapped
+    const auto swap = endianness != ktxEndianness;
+    const auto field = [&](size_t index) { return readU32(data + 16 + index * 4, swap); };
+    const auto glType = field(0);
+    const auto glInternalFormat = field(3);
+    const auto pixelWidth = field(5);
+    const auto pixelHeight = field(6);
+    const auto pixelDepth = field(7);
+    const auto arrayElements = field(8);
+    const auto faces = field(9);
+    const auto mipLevels = field(10);
+    const auto keyValueBytes = field(11);
+
+    CompressedTextureData tex;
+    tex.format = static_cast<ImageFormat>(glInternalFormat);
+    if (glType != 0 || getCompressedBlockSize(tex.format) == 0) {
+        LOG_ERROR("Unsupported KTX format {:#x} (only S3TC and RGTC are supported)",
+            glInternalFormat);
+        return std::nullopt;
+    }
+    if (pixelWidth == 0 || pixelHeight == 0 || pixelDepth != 0 || arrayElements != 0
+        || (faces != 1 && faces != 6)) {
+        LOG_ERROR("Unsupported KTX texture type (only 2D textures and cube maps are supported)");
+        return std::nullopt;
+    }
+    if (pixelWidth > maxCompressedTextureSize || pixelHeight > maxCompressedTextureSize) {
+        LOG_ERROR("KTX texture is too large ({}x{})", pixelWidth, pixelHeight);
+        return std::nullopt;
+    }
+    tex.target = faces == 6 ? Texture::Target::TextureCubeMap : Texture::Target::Texture2D;
+    tex.width = pixelWidth;
+    tex.height = pixelHeight;
+    tex.faces = faces;
+    // 0 means the mipmaps should be generated after loading, which we can't do for compressed
+    // textures, so there is just one level.
+    tex.levels = std::max(uint32_t(1), mipLevels);
+    if (tex.levels > getLevelCount(tex.width, tex.height)) {
+        LOG_ERROR("Invalid KTX mipmap level count {}", tex.levels);
+        return std::nullopt;
+    }
+
+    // tex.data is only the image data (and the imageSize fields in between)
+    if (!inBounds(ktxHeaderSize, keyValueBytes, size)) {
+        LOG_ERROR("KTX file is truncated");
+        return std::nullopt;
+    }
+    const auto begin = ktxHeaderSize + keyValueBytes;
+    auto offset = begin;
+    for (size_t level = 0; level < tex.levels; ++level) {
+        if (!inBounds(offset, 4, size)) {
+            LOG_ERROR("KTX file is truncated");
+            return std::nullopt;
+        }
+        const auto imageSize = readU32(data + offset, swap);
+        offset += 4;
+        const auto width = std::max(size_t(1), tex.width >> level);
+        const auto height = std::max(size_t(1), tex.height >> level);
+        if (imageSize != getCompressedImageSize(tex.format, width, height)) {
+            LOG_ERROR("Invalid KTX image size {} for level {}", imageSize, level);
+            return std::nullopt;
+        }
+        for (size_t face = 0; face < tex.faces; ++face) {
+            if (!inBounds(offset, imageSize, size)) {
+                LOG_ERROR("KTX file is truncated");
+                return std::nullopt;
+            }
+            tex.images.push_back(
+                CompressedTextureData::Image { width, height, offset - begin, imageSize });
+            // Images are padded to 4 bytes, which compressed images always are already
+            offset += imageSize;
+        }
+    }
+    tex.data.assign(data + begin, data + offset);
+    return tex;
+}
+
+std::vector<uint8_t> writeKtx(const CompressedTextureData& data)
+{
+    std::vector<uint8_t> file(ktxIdentifier.begin(), ktxIdentifier.end());
+    const auto write = [&file](uint32_t v) {
+        const auto ptr = reinterpret_cast<const uint8_t*>(&v);
+        file.insert(file.end(), ptr, ptr + sizeof(v));
+    };
+    write(ktxEndianness);
+    write(0); // glType
+    write(1); // glTypeSize
+    write(0); // glFormat
+    write(static_cast<uint32_t>(data.format));
+    write(0); // glBaseInternalFormat, which is not used by anyone
+    write(static_cast<uint32_t>(data.width));
+    write(static_cast<uint32_t>(data.height));
+    write(0); // pixelDepth
+    write(0); // numberOfArrayElements
+    write(static_cast<uint32_t>(data.faces));
+    write(static_cast<uint32_t>(data.levels));
+    write(0); // bytesOfKeyValueData
+    for (size_t level = 0; level < data.levels; ++level) {
+        write(static_cast<uint32_t>(data.getImage(level).size));
+        for (size_t face = 0; face < data.faces; ++face) {
+            const auto ptr = data.getImageData(level, face);
+            file.insert(file.end(), ptr, ptr + data.getImage(level, face).size);
+        }
+    }
+    return file;
+}
+
+// https://learn.microsoft.com/en-us/windows/win32/direct3ddds/dx-graphics-dds-pguide
+std::optional<CompressedTextureData> parseDds(const uint8_t* data, size_t size)
+{
+    if (size < 4 + ddsHeaderSize || readU32(data) != ddsMagic
+        || readU32(data + 4) != ddsHeaderSize) {
+        LOG_ERROR("Not a DDS file");
+        return std::nullopt;
+    }
+    const auto header = data + 4;
+    const auto flags = readU32(header + 4);
+    const auto pixelFormatFlags = readU32(header + ddsPixelFormatFlags);
+    const auto fourCC = readU32(header + ddsFourCC);
+    const auto caps2 = readU32(header + ddsCaps2);
+    if (!(pixelFormatFlags & ddpfFourCC)) {
+        LOG_ERROR("Unsupported DDS format (only S3TC and RGTC are supported)");
+        return std::nullopt;
+    }
+
+    CompressedTextureData tex;
+    tex.width = readU32(header + ddsWidth);
+    tex.height = readU32(header + ddsHeight);
+    tex.levels = flags & ddsdMipMapCount ? std::max(uint32_t(1), readU32(header + ddsMipMapCount))
+                                         : 1;
+    auto cubeMap = (caps2 & ddsCaps2CubeMap) != 0;
+    auto offset = 4 + ddsHeaderSize;
+    std::optional<ImageFormat> format;
+    if (fourCC == makeFourCC('D', 'X', '1', '0')) {
+        if (size < offset + ddsDx10HeaderSize) {
+            LOG_ERROR("DDS file is truncated");
+            return std::nullopt;
+        }
+        const auto dx10 = data + offset;
+        format = getDxgiFormat(readU32(dx10));
+        if (readU32(dx10 + 4) != dx10ResourceDimensionTexture2D || readU32(dx10 + 12) > 1) {
+            LOG_ERROR("Unsupported DDS texture type (only 2D textures and cube maps are "
+                      "supported)");
+            return std::nullopt;
+        }
+        cubeMap = (readU32(dx10 + 8) & dx10MiscTextureCube) != 0;
+        offset += ddsDx10HeaderSize;
+    } else {
+        format = getDdsFormat(fourCC, pixelFormatFlags);
+    }
+    if (!format) {
+        LOG_ERROR("Unsupported DDS format (only S3TC and RGTC are supported)");
+        return std::nullopt;
+    }
+    if ((caps2 & ddsCaps2Volume) || (cubeMap && (caps2 & ddsCaps2AllFaces) != ddsCaps2AllFaces)) {
+        LOG_ERROR("Unsupported DDS texture type (only 2D textures and complete cube maps are "
+                  "supported)");
+        return std::nullopt;
+    }
+    if (tex.width == 0 || tex.height == 0 || tex.width > maxCompressedTextureSize
+        || tex.height > maxCompressedTextureSize
+        || tex.levels > getLevelCount(tex.width, tex.height)) {
+        LOG_ERROR("Invalid DDS size {}x{} with {} levels", tex.width, tex.height, tex.levels);
+        return std::nullopt;
+    }
+    tex.format = *format;
+    tex.target = cubeMap ? Texture::Target::TextureCubeMap : Texture::Target::Texture2D;
+    tex.faces = cubeMap ? 6 : 1;
+
+    // DDS stores all levels of a face before the next face, we store all faces of a level together
+    tex.images.resize(tex.levels * tex.faces);
+    size_t dataOffset = 0;
+    for (size_t face = 0; face < tex.faces; ++face) {
+        for (size_t level = 0; level < tex.levels; ++level) {
+            const auto width = std::max(size_t(1), tex.width >> level);
+            const auto height = std::max(size_t(1), tex.height >> level);
+            const auto imageSize = getCompressedImageSize(tex.format, width, height);
+            tex.images[level * tex.faces + face]
+                = CompressedTextureData::Image { width, height, dataOffset, imageSize };
+            dataOffset += imageSize;
+        }
+    }
+    // With the size limit above, dataOffset can't overflow (a full cube map is less than 2 GB)
+    if (!inBounds(offset, dataOffset, size)) {
+        LOG_ERROR("DDS file is truncated");
+        return std::nullopt;
+    }
+    tex.data.assign(data + offset, data + offset + dataOffset);
+    return tex;
+}
+
+std::optional<CompressedTextureData> loadCompressedTexture(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        LOG_ERROR("Could not open '{}'", path);
+        return std::nullopt;
+    }
+    const std::vector<uint8_t> contents(
+        (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (contents.size() >= ktxIdentifier.size()
+        && std::memcmp(contents.data(), ktxIdentifier.data(), ktxIdentifier.size()) == 0)
+        return parseKtx(contents.data(), contents.size());
+    if (contents.size() >= 4 && readU32(contents.data()) == ddsMagic)
+        return parseDds(contents.data(), contents.size());
+    LOG_ERROR("'{}' is neither a KTX nor a DDS file", path);
+    return std::nullopt;
+}
+
+std::optional<glw::Texture> makeCompressedTexture(const CompressedTextureData& data)
+{
+    if (!isCompressedFormatSupported(data.format)) {
+        LOG_ERROR("Compressed format {:#x} is not supported", static_cast<GLenum>(data.format));
+        return std::nullopt;
+    }
+    Texture texture(data.target);
+    texture.storage(data.target, data.levels, data.format, data.width, data.height);
+    for (size_t level = 0; level < data.levels; ++level) {
+        for (size_t face = 0; face < data.faces; ++face) {
+            const auto target = data.faces == 6
+                ? static_cast<Texture::Target>(
+                    static_cast<GLenum>(Texture::Target::TextureCubeMapPosX) + face)
+                : data.target;
+            const auto& image = data.getImage(level, face);
+            texture.compressedSubImage(target, level, 0, 0, image.width, image.height,
+                image.size, data.getImageData(level, face));
+        }
+    }
+    if (data.levels > 1)
+        texture.setFilter(Texture::MinFilter::LinearMipmapNearest, Texture::MagFilter::Linear);
+    else
+        texture.setFilter(Texture::MinFilter::Linear, Texture::MagFilter::Linear);
+    if (data.faces == 6)
+        texture.setWrap(Texture::WrapMode::ClampToEdge);
+    return texture;
+}
+
+std::optional<glw::Texture> makeCompressedTexture(const std::filesystem::path& path)
+{
+    const auto data = loadCompressedTexture(path);
+    if (!data)
+        return std::nullopt;
+    return makeCompressedTexture(*data);
+}
+}
@@ -1,6 +1,7 @@
 #include "glwx/indexaccessor.hpp"
 
 #include <cassert>
+#include <utility>
 
 #include "glw/log.hpp"
 
@@ -8,6 +9,7 @@ namespace glwx {
 size_t IndexAccessor::Proxy::operator=(size_t index)
 {
     assert(elementSize == 1 || elementSize == 2 || elementSize == 4);
+    const auto data = buffer->getData(offset, elementSize).data();
     switch (elementSize) {
     case 1:
         assert(index <= std::numeric_limits<uint8_t>::max());
@@ -33,6 +35,7 @@ IndexAccessor::Proxy::operator size_t() const
 size_t IndexAccessor::Proxy::get() const
 {
     assert(elementSize == 1 || elementSize == 2 || elementSize == 4);
+    const auto data = std::as_const(*buffer).getData().data() + offset;
     switch (elementSize) {
     case 1:
         return *reinterpret_cast<const uint8_t*>(data);
@@ -51,7 +54,6 @@ IndexAccessor::IndexAccessor(IndexBuffer& buffer)
 
 IndexAccessor::Proxy IndexAccessor::operator[](size_t index)
 {
-    return Proxy { buffer_.getData().data() + index * buffer_.getElementSize(),
-        buffer_.getElementSize() };
+    return Proxy { &buffer_, index * buffer_.getElementSize(), buffer_.getElementSize() };
 }
 }
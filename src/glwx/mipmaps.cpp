@@ -0,0 +1,379 @@
+#include "glwx/mipmaps.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <numbers>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define GLWX_MIPMAPS_SSE2
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define GLWX_MIPMAPS_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace glw;
+
+namespace glwx {
+namespace {
+    // The number of rows in a chunk is chosen, so every chunk is about this many texels
+    constexpr size_t chunkTexels = 16 * 1024;
+
+    // Half the width of the Kaiser filter in texels of the destination level
+    constexpr float kaiserRadius = 2.0f;
+    constexpr float kaiserAlpha = 4.0f;
+    // The taps for destination texel x are at source texels 2x - 3 to 2x + 4
+    constexpr int kaiserTaps = 8;
+    constexpr int kaiserFirstTap = -3;
+
+    // Resolution of the table that gives the first guess for the sRGB encoding
+    constexpr size_t srgbGuessSize = 4096;
+
+    struct SrgbTables {
+        std::array<float, 256> toLinear;
+        // toLinear of the midpoints between two consecutive 8 bit values (and one past the end),
+        // so the number of thresholds <= a linear value is its correctly rounded sRGB encoding
+        std::array<float, 256> thresholds;
+        // The encoding of i / (srgbGuessSize - 1), rounded down. The sRGB curve is at most 12.92
+        // times steeper than linear, so this is never off by more than one or two.
+        std::array<uint8_t, srgbGuessSize> guess;
+    };
+
+    float srgbToLinear(float v)
+    {
+        return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+    }
+
+    const SrgbTables& getSrgbTables()
+    {
+        static const auto tables = [] {
+            SrgbTables t;
+            for (size_t i = 0; i < 256; ++i)
+                t.toLinear[i] = srgbToLinear(static_cast<float>(i) / 255.0f);
+            for (size_t i = 0; i < 255; ++i)
+                t.thresholds[i] = srgbToLinear((static_cast<float>(i) + 0.5f) / 255.0f);
+            t.thresholds[255] = 2.0f;
+            for (size_t i = 0; i < srgbGuessSize; ++i) {
+                const auto v = static_cast<float>(i) / static_cast<float>(srgbGuessSize - 1);
+                t.guess[i] = static_cast<uint8_t>(
+                    std::upper_bound(t.thresholds.begin(), t.thresholds.end(), v)
+                    - t.thresholds.begin());
+            }
+            return t;
+        }();
+        return tables;
+    }
+
+    uint8_t linearToSrgb8(const SrgbTables& tables, float v)
+    {
+        v = std::clamp(v, 0.0f, 1.0f);
+        auto code = tables.guess[static_cast<size_t>(v * (srgbGuessSize - 1))];
+        while (v >= tables.thresholds[code])
+            code++;
+        return code;
+    }
+
+    uint8_t toUnorm8(float v)
+    {
+        return static_cast<uint8_t>(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    // Zeroth order modified Bessel function of the first kind
+    float besselI0(float x)
+    {
+        float sum = 1.0f;
+        float term = 1.0f;
+        for (int k = 1; k < 32; ++k) {
+            term *= (x / (2.0f * static_cast<float>(k))) * (x / (2.0f * static_cast<float>(k)));
+            sum += term;
+            if (term < sum * 1e-7f)
+                break;
+        }
+        return sum;
+    }
+
+    const std::array<float, kaiserTaps>& getKaiserWeights()
+    {
+        static const auto weights = [] {
+            std::array<float, kaiserTaps> w;
+            float sum = 0.0f;
+            for (int i = 0; i < kaiserTaps; ++i) {
+                // Distance from the center of the destination texel in destination texels
+                const auto t = (static_cast<float>(kaiserFirstTap + i) - 0.5f) / 2.0f;
+                const auto x = std::numbers::pi_v<float> * t;
+                const auto sinc = std::sin(x) / x;
+                const auto r = t / kaiserRadius;
+                const auto window
+                    = besselI0(kaiserAlpha * std::sqrt(std::max(0.0f, 1.0f - r * r)))
+                    / besselI0(kaiserAlpha);
+                w[static_cast<size_t>(i)] = sinc * window;
+                sum += w[static_cast<size_t>(i)];
+            }
+            for (auto& v : w)
+                v /= sum;
+            return w;
+        }();
+        return weights;
+    }
+
+    size_t clampIndex(ptrdiff_t i, size_t size)
+    {
+        return static_cast<size_t>(std::clamp<ptrdiff_t>(i, 0, static_cast<ptrdiff_t>(size) - 1));
+    }
+
+    // For odd sizes the last row/column of the source is dropped, like glGenerateMipmap usually
+    // does, so every destination texel covers exactly 2x2 source texels.
+    void boxRow(const float* row0, const float* row1, float* dst, size_t srcWidth,
+        size_t dstWidth, size_t channels)
+    {
+        size_t x = 0;
+        if (channels == 4 && srcWidth > 1) {
+#if defined(__AVX__)
+            // Two destination texels at once
+            const auto quarter8 = _mm256_set1_ps(0.25f);
+            for (; x + 2 <= dstWidth; x += 2) {
+                const auto a = _mm256_add_ps(
+                    _mm256_loadu_ps(row0 + 8 * x), _mm256_loadu_ps(row1 + 8 * x));
+                const auto b = _mm256_add_ps(
+                    _mm256_loadu_ps(row0 + 8 * x + 8), _mm256_loadu_ps(row1 + 8 * x + 8));
+                // Add the left and right texel of every pair
+                const auto sum = _mm256_add_ps(_mm256_permute2f128_ps(a, b, 0x20),
+                    _mm256_permute2f128_ps(a, b, 0x31));
+                _mm256_storeu_ps(dst + 4 * x, _mm256_mul_ps(sum, quarter8));
+            }
+#endif
+#if defined(GLWX_MIPMAPS_SSE2)
+            const auto quarter = _mm_set1_ps(0.25f);
+            for (; x < dstWidth; ++x) {
+                const auto a
+                    = _mm_add_ps(_mm_loadu_ps(row0 + 8 * x), _mm_loadu_ps(row0 + 8 * x + 4));
+                const auto b
+                    = _mm_add_ps(_mm_loadu_ps(row1 + 8 * x), _mm_loadu_ps(row1 + 8 * x + 4));
+                _mm_storeu_ps(dst + 4 * x, _mm_mul_ps(_mm_add_ps(a, b), quarter));
+            }
+#elif defined(GLWX_MIPMAPS_NEON)
+            for (; x < dstWidth; ++x) {
+                const auto a = vaddq_f32(vld1q_f32(row0 + 8 * x), vld1q_f32(row0 + 8 * x + 4));
+                const auto b = vaddq_f32(vld1q_f32(row1 + 8 * x), vld1q_f32(row1 + 8 * x + 4));
+                vst1q_f32(dst + 4 * x, vmulq_n_f32(vaddq_f32(a, b), 0.25f));
+            }
+#endif
+        }
+        for (; x < dstWidth; ++x) {
+            const auto x0 = 2 * x * channels;
+            const auto x1 = std::min(2 * x + 1, srcWidth - 1) * channels;
+            for (size_t c = 0; c < channels; ++c)
+                dst[x * channels + c]
+                    = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]) * 0.25f;
+        }
+    }
+
+    void kaiserRowHorizontal(
+        const float* src, float* dst, size_t srcWidth, size_t dstWidth, size_t channels)
+    {
+        const auto& weights = getKaiserWeights();
+        size_t x = 0;
+#if defined(GLWX_MIPMAPS_SSE2) || defined(GLWX_MIPMAPS_NEON)
+        if (channels == 4) {
+            for (; x < dstWidth; ++x) {
+                const auto first = static_cast<ptrdiff_t>(2 * x) + kaiserFirstTap;
+#if defined(GLWX_MIPMAPS_SSE2)
+                auto sum = _mm_setzero_ps();
+                for (int i = 0; i < kaiserTaps; ++i) {
+                    const auto texel = _mm_loadu_ps(src + clampIndex(first + i, srcWidth) * 4);
+                    sum = _mm_add_ps(
+                        sum, _mm_mul_ps(_mm_set1_ps(weights[static_cast<size_t>(i)]), texel));
+                }
+                _mm_storeu_ps(dst + x * 4, sum);
+#else
+                auto sum = vdupq_n_f32(0.0f);
+                for (int i = 0; i < kaiserTaps; ++i) {
+                    const auto texel = vld1q_f32(src + clampIndex(first + i, srcWidth) * 4);
+                    sum = vmlaq_n_f32(sum, texel, weights[static_cast<size_t>(i)]);
+                }
+                vst1q_f32(dst + x * 4, sum);
+#endif
+            }
+        }
+#endif
+        for (; x < dstWidth; ++x) {
+            const auto first = static_cast<ptrdiff_t>(2 * x) + kaiserFirstTap;
+            const auto inside
+                = first >= 0 && first + kaiserTaps <= static_cast<ptrdiff_t>(srcWidth);
+            std::array<float, 4> sum = {};
+            for (int i = 0; i < kaiserTaps; ++i) {
+                const auto sx
+                    = inside ? static_cast<size_t>(first + i) : clampIndex(first + i, srcWidth);
+                const auto w = weights[static_cast<size_t>(i)];
+                for (size_t c = 0; c < channels; ++c)
+                    sum[c] += w * src[sx * channels + c];
+            }
+            for (size_t c = 0; c < channels; ++c)
+                dst[x * channels + c] = sum[c];
+        }
+    }
+
+    // rows are the kaiserTaps source rows for this destination row
+    void kaiserRowVertical(const std::array<const float*, kaiserTaps>& rows, float* dst, size_t n)
+    {
+        const auto& weights = getKaiserWeights();
+        // The loop over n is the inner one, so the compiler can vectorize it
+        std::fill(dst, dst + n, 0.0f);
+        for (size_t i = 0; i < kaiserTaps; ++i) {
+            const auto w = weights[i];
+            const auto row = rows[i];
+            for (size_t j = 0; j < n; ++j)
+                dst[j] += w * row[j];
+        }
+    }
+
+    // Finds the scale for alpha, so that the fraction of texels with alpha * scale > cutoff is
+    // coverage. This is the approach from "Signed Distance Fields" by Ignacio Castaño, but instead
+    // of searching for the scale, the alpha value at that percentile is looked up directly.
+    float getAlphaScale(const std::vector<float>& level, float cutoff, float coverage)
+    {
+        std::vector<float> alpha(level.size() / 4);
+        for (size_t i = 0; i < alpha.size(); ++i)
+            alpha[i] = level[i * 4 + 3];
+        const auto count = static_cast<size_t>(std::round(coverage * alpha.size()));
+        if (count == 0)
+            return 1.0f;
+        const auto nth = alpha.begin() + static_cast<ptrdiff_t>(count - 1);
+        std::nth_element(alpha.begin(), nth, alpha.end(), std::greater<float>());
+        if (*nth <= 0.0f)
+            return 1.0f;
+        // The texel at the percentile has to end up above the cutoff after quantization too
+        return (cutoff + 0.5f / 255.0f) / *nth;
+    }
+}
+
+MipmapGenerator::MipmapGenerator(size_t threads)
+    : pool_(std::make_shared<WorkerPool>(threads))
+{
+}
+
+MipmapGenerator::MipmapGenerator(std::shared_ptr<WorkerPool> pool)
+    : pool_(std::move(pool))
+{
+    assert(pool_);
+}
+
+std::vector<MipmapGenerator::Level> MipmapGenerator::generate(const uint8_t* data, size_t width,
+    size_t height, size_t channels, const Options& options) const
+{
+    assert(width > 0 && height > 0);
+    assert(channels >= 1 && channels <= 4);
+    const auto& srgb = getSrgbTables();
+    // With 4 channels the last one is alpha, which is always linear
+    const auto colorChannels = options.srgb ? (channels == 4 ? 3 : channels) : 0;
+    const auto coverageEnabled = options.alphaCutoff > 0.0f && channels == 4;
+
+    // Everything is filtered in linear space with floats, so the error does not accumulate
+    // from level to level.
+    std::vector<float> src(width * height * channels);
+    size_t coveredTexels = 0;
+    std::array<std::array<float, 256>, 4> toLinear;
+    for (size_t c = 0; c < channels; ++c) {
+        for (size_t v = 0; v < 256; ++v)
+            toLinear[c][v] = c < colorChannels ? srgb.toLinear[v] : static_cast<float>(v) / 255.0f;
+    }
+    const auto linearRows = std::max(size_t(1), chunkTexels / width);
+    pool_->parallelFor(height, linearRows, [&](size_t begin, size_t end) {
+        for (size_t t = begin * width; t < end * width; ++t) {
+            for (size_t c = 0; c < channels; ++c)
+                src[t * channels + c] = toLinear[c][data[t * channels + c]];
+        }
+    });
+    if (coverageEnabled) {
+        for (size_t i = 3; i < src.size(); i += 4)
+            coveredTexels += src[i] > options.alphaCutoff;
+    }
+    const auto coverage = static_cast<float>(coveredTexels) / static_cast<float>(width * height);
+
+    std::vector<Level> levels;
+    std::vector<float> dst;
+    std::vector<float> tmp;
+    while (width > 1 || height > 1) {
+        const auto dstWidth = std::max(size_t(1), width / 2);
+        const auto dstHeight = std::max(size_t(1), height / 2);
+        const auto srcPitch = width * channels;
+        const auto dstPitch = dstWidth * channels;
+        dst.resize(dstWidth * dstHeight * channels);
+        const auto chunkRows = std::max(size_t(1), chunkTexels / dstWidth);
+
+        if (options.filter == Filter::Box) {
+            pool_->parallelFor(dstHeight, chunkRows, [&](size_t begin, size_t end) {
+                for (size_t y = begin; y < end; ++y) {
+                    const auto y1 = std::min(2 * y + 1, height - 1);
+                    boxRow(src.data() + 2 * y * srcPitch, src.data() + y1 * srcPitch,
+                        dst.data() + y * dstPitch, width, dstWidth, channels);
+                }
+            });
+        } else {
+            // Separable, first horizontally into tmp (all source rows), then vertically
+            tmp.resize(height * dstPitch);
+            pool_->parallelFor(height, chunkRows, [&](size_t begin, size_t end) {
+                for (size_t y = begin; y < end; ++y)
+                    kaiserRowHorizontal(src.data() + y * srcPitch, tmp.data() + y * dstPitch,
+                        width, dstWidth, channels);
+            });
+            pool_->parallelFor(dstHeight, chunkRows, [&](size_t begin, size_t end) {
+                std::array<const float*, kaiserTaps> rows;
+                for (size_t y = begin; y < end; ++y) {
+                    const auto first = static_cast<ptrdiff_t>(2 * y) + kaiserFirstTap;
+                    for (int i = 0; i < kaiserTaps; ++i)
+                        rows[static_cast<size_t>(i)]
+                            = tmp.data() + clampIndex(first + i, height) * dstPitch;
+                    kaiserRowVertical(rows, dst.data() + y * dstPitch, dstPitch);
+                }
+            });
+        }
+
+        const auto alphaScale
+            = coverageEnabled ? getAlphaScale(dst, options.alphaCutoff, coverage) : 1.0f;
+        auto& level = levels.emplace_back();
+        level.width = dstWidth;
+        level.height = dstHeight;
+        level.rowPitch = (dstPitch + 3) / 4 * 4;
+        level.data.resize(level.rowPitch * dstHeight);
+        pool_->parallelFor(dstHeight, chunkRows, [&](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; ++y) {
+                const auto srcRow = dst.data() + y * dstPitch;
+                const auto dstRow = level.data.data() + y * level.rowPitch;
+                for (size_t x = 0; x < dstWidth; ++x) {
+                    const auto i = x * channels;
+                    size_t c = 0;
+                    for (; c < colorChannels; ++c)
+                        dstRow[i + c] = linearToSrgb8(srgb, srcRow[i + c]);
+                    for (; c < channels; ++c)
+                        dstRow[i + c] = toUnorm8(srcRow[i + c] * (c == 3 ? alphaScale : 1.0f));
+                }
+            }
+        });
+
+        // The unscaled alpha is passed on to the next level, because the scale is computed
+        // relative to level 0 anyways.
+        std::swap(src, dst);
+        width = dstWidth;
+        height = dstHeight;
+    }
+    return levels;
+}
+
+void MipmapGenerator::upload(
+    Texture& texture, const std::vector<Level>& levels, Texture::DataFormat dataFormat)
+{
+    assert(texture.getLevels() == 0 || texture.getLevels() >= levels.size() + 1);
+    for (size_t i = 0; i < levels.size(); ++i) {
+        assert(levels[i].width == std::max(size_t(1), texture.getWidth() >> (i + 1)));
+        texture.subImage(i + 1, dataFormat, Texture::DataType::U8, levels[i].data.data());
+    }
+}
+
+const WorkerPool& MipmapGenerator::getWorkerPool() const
+{
+    return *pool_;
+}
+}
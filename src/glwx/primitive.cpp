@@ -8,6 +8,12 @@ Primitive::Primitive(DrawMode mode)
 {
 }
 
+Primitive::Range Primitive::getRange(const BufferHeap::Allocation& allocation, size_t elementSize)
+{
+    assert(allocation.offset % elementSize == 0);
+    return Range { allocation.offset / elementSize, allocation.size / elementSize };
+}
+
 void Primitive::addVertexBuffer(const Buffer& buffer, const VertexFormat& vfmt)
 {
     // Assert that all locations used in vfmt are not already in use
@@ -29,6 +35,13 @@ void Primitive::addVertexBuffer(const VertexBuffer& buffer)
         vertexRange = Range { 0, buffer.getCount() };
 }
 
+void Primitive::addVertexBuffer(const BufferHeap::Allocation& allocation, const VertexFormat& vfmt)
+{
+    assert(allocation);
+    addVertexBuffer(*allocation.buffer, vfmt);
+    vertexRange = getRange(allocation, vfmt.getStride());
+}
+
 void Primitive::setIndexBuffer(const Buffer& buffer, IndexType indexType)
 {
     vertexArray.bind();
@@ -45,51 +58,70 @@ void Primitive::setIndexBuffer(const IndexBuffer& buffer)
     indexRange = Range { 0, buffer.getCount() };
 }
 
-void Primitive::draw(size_t offset, size_t count) const
+void Primitive::setIndexBuffer(const BufferHeap::Allocation& allocation, IndexType indexType)
+{
+    assert(allocation);
+    setIndexBuffer(*allocation.buffer, indexType);
+    indexRange = getRange(allocation, glw::getIndexTypeSize(indexType));
+}
+
+const Primitive::Range& Primitive::getDrawRange() const
+{
+    return indexType_ ? indexRange : vertexRange;
+}
+
+void Primitive::drawBound(
+    size_t offset, size_t count, size_t baseVertex, std::optional<size_t> instanceCount) const
 {
-    vertexArray.bind();
     const auto m = static_cast<GLenum>(mode);
     if (indexType_) {
-        glDrawElements(m, static_cast<GLsizei>(count), static_cast<GLenum>(*indexType_),
-            reinterpret_cast<const void*>(glw::getIndexTypeSize(*indexType_) * offset));
+        const auto type = static_cast<GLenum>(*indexType_);
+        const auto indices
+            = reinterpret_cast<const void*>(glw::getIndexTypeSize(*indexType_) * offset);
+        if (instanceCount && baseVertex > 0) {
+            glDrawElementsInstancedBaseVertex(m, static_cast<GLsizei>(count), type, indices,
+                static_cast<GLsizei>(*instanceCount), static_cast<GLint>(baseVertex));
+        } else if (instanceCount) {
+            glDrawElementsInstanced(m, static_cast<GLsizei>(count), type, indices,
+                static_cast<GLsizei>(*instanceCount));
+        } else if (baseVertex > 0) {
+            glDrawElementsBaseVertex(m, static_cast<GLsizei>(count), type, indices,
+                static_cast<GLint>(baseVertex));
+        } else {
+            glDrawElements(m, static_cast<GLsizei>(count), type, indices);
+        }
+    } else if (instanceCount) {
+        glDrawArraysInstanced(m, static_cast<GLint>(offset), static_cast<GLsizei>(count),
+            static_cast<GLsizei>(*instanceCount));
     } else {
-        glDrawArrays(m, static_cast<GLsizei>(offset), static_cast<GLsizei>(count));
+        glDrawArrays(m, static_cast<GLint>(offset), static_cast<GLsizei>(count));
     }
-    vertexArray.unbind();
     State::instance().getStatistics().drawCalls++;
 }
 
+void Primitive::draw(size_t offset, size_t count) const
+{
+    vertexArray.bind();
+    drawBound(offset, count, vertexRange.offset, std::nullopt);
+    vertexArray.unbind();
+}
+
 void Primitive::draw() const
 {
-    if (indexType_) {
-        draw(indexRange.offset, indexRange.count);
-    } else {
-        draw(vertexRange.offset, vertexRange.count);
-    }
+    const auto& range = getDrawRange();
+    draw(range.offset, range.count);
 }
 
 void Primitive::draw(size_t offset, size_t count, size_t instanceCount) const
 {
     vertexArray.bind();
-    const auto m = static_cast<GLenum>(mode);
-    if (indexType_) {
-        glDrawElementsInstanced(m, static_cast<GLsizei>(count), static_cast<GLenum>(*indexType_),
-            reinterpret_cast<const void*>(glw::getIndexTypeSize(*indexType_) * offset),
-            static_cast<GLsizei>(instanceCount));
-    } else {
-        glDrawArraysInstanced(m, static_cast<GLint>(offset), static_cast<GLsizei>(count),
-            static_cast<GLsizei>(instanceCount));
-    }
+    drawBound(offset, count, vertexRange.offset, instanceCount);
     vertexArray.unbind();
-    State::instance().getStatistics().drawCalls++;
 }
 
 void Primitive::draw(size_t instanceCount) const
 {
-    if (indexType_) {
-        draw(indexRange.offset, indexRange.count, instanceCount);
-    } else {
-        draw(vertexRange.offset, vertexRange.count, instanceCount);
-    }
+    const auto& range = getDrawRange();
+    draw(range.offset, range.count, instanceCount);
 }
 }
@@ -0,0 +1,161 @@
+#include "glwx/readback.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "glw/log.hpp"
+
+using namespace glw;
+
+namespace glwx {
+AsyncReadback::AsyncReadback(size_t poolSize)
+    : slots_(poolSize)
+{
+    assert(poolSize > 0);
+}
+
+std::optional<AsyncReadback::Ticket> AsyncReadback::read(int x, int y, size_t width,
+    size_t height, Texture::DataFormat dataFormat, Texture::DataType dataType)
+{
+    const auto it = std::find_if(
+        slots_.begin(), slots_.end(), [](const Slot& slot) { return slot.ticket == 0; });
+    if (it == slots_.end())
+        return std::nullopt;
+    const auto slot = &*it;
+
+    const auto rowSize = width * Texture::getPixelSize(dataFormat, dataType);
+    const auto rowPitch = (rowSize + packAlignment - 1) / packAlignment * packAlignment;
+    const auto size = rowPitch * height;
+
+    // Only ever grow the buffers, so reading the same region every frame never reallocates
+    if (slot->buffer.getSize() < size)
+        slot->buffer.data(Buffer::Target::PixelPack, Buffer::UsageHint::StreamRead,
+            static_cast<const void*>(nullptr), size);
+
+    slot->buffer.bind(Buffer::Target::PixelPack);
+    // Someone else might have changed it and rowPitch depends on it
+    glPixelStorei(GL_PACK_ALIGNMENT, static_cast<GLint>(packAlignment));
+    Framebuffer::readPixels(x, y, width, height, dataFormat, dataType, nullptr);
+    // Unbind, so later glReadPixels calls into client memory work as expected
+    Buffer::unbind(Buffer::Target::PixelPack);
+    slot->fence.insert();
+
+    slot->ticket = nextTicket_++;
+    slot->width = width;
+    slot->height = height;
+    slot->rowPitch = rowPitch;
+    slot->size = size;
+    return slot->ticket;
+}
+
+std::optional<AsyncReadback::Ticket> AsyncReadback::read(const Framebuffer& framebuffer,
+    Framebuffer::Attachment attachment, int x, int y, size_t width, size_t height,
+    Texture::DataFormat dataFormat, Texture::DataType dataType)
+{
+    // glReadBuffer only accepts color attachments (GL_INVALID_ENUM otherwise). For the others
+    // the data format selects what is read.
+    switch (attachment) {
+    case Framebuffer::Attachment::Depth:
+        framebuffer.bind(Framebuffer::Target::Read);
+        dataFormat = Texture::DataFormat::Depth;
+        break;
+    case Framebuffer::Attachment::Stencil:
+        framebuffer.bind(Framebuffer::Target::Read);
+        dataFormat = Texture::DataFormat::Stencil;
+        break;
+    case Framebuffer::Attachment::DepthStencil:
+        framebuffer.bind(Framebuffer::Target::Read);
+        if (dataFormat != Texture::DataFormat::Stencil
+            && dataFormat != Texture::DataFormat::DepthStencil)
+            dataFormat = Texture::DataFormat::Depth;
+        break;
+    default:
+        framebuffer.readBuffer(attachment);
+        break;
+    }
+    return read(x, y, width, height, dataFormat, dataType);
+}
+
+std::optional<AsyncReadback::Ticket> AsyncReadback::read(RenderTarget& renderTarget,
+    RenderTarget::Attachment attachment, Texture::DataFormat dataFormat,
+    Texture::DataType dataType)
+{
+    return read(renderTarget.getFramebuffer(), attachment, 0, 0, renderTarget.getWidth(),
+        renderTarget.getHeight(), dataFormat, dataType);
+}
+
+bool AsyncReadback::isReady(Ticket ticket) const
+{
+    const auto slot = findSlot(ticket);
+    return slot && slot->fence.isSignaled();
+}
+
+bool AsyncReadback::wait(Ticket ticket) const
+{
+    const auto slot = findSlot(ticket);
+    return slot && slot->fence.wait();
+}
+
+std::optional<AsyncReadback::View> AsyncReadback::map(Ticket ticket)
+{
+    const auto slot = findSlot(ticket);
+    if (!slot)
+        return std::nullopt;
+
+    if (!slot->mapped) {
+        if (!slot->fence.wait()) {
+            LOG_ERROR("Waiting for readback failed");
+            return std::nullopt;
+        }
+        slot->mapped = static_cast<const uint8_t*>(
+            slot->buffer.map(Buffer::Target::PixelPack, 0, slot->size, GL_MAP_READ_BIT));
+        if (!slot->mapped) {
+            LOG_ERROR("Could not map readback buffer");
+            return std::nullopt;
+        }
+    }
+
+    return View { slot->mapped, slot->width, slot->height, slot->rowPitch, slot->size };
+}
+
+void AsyncReadback::release(Ticket ticket)
+{
+    const auto slot = findSlot(ticket);
+    if (!slot)
+        return;
+    if (slot->mapped)
+        slot->buffer.unmap(Buffer::Target::PixelPack);
+    slot->mapped = nullptr;
+    slot->fence.free();
+    slot->ticket = 0;
+}
+
+size_t AsyncReadback::getPoolSize() const
+{
+    return slots_.size();
+}
+
+size_t AsyncReadback::getFreeCount() const
+{
+    return static_cast<size_t>(std::count_if(
+        slots_.begin(), slots_.end(), [](const Slot& slot) { return slot.ticket == 0; }));
+}
+
+AsyncReadback::Slot* AsyncReadback::findSlot(Ticket ticket)
+{
+    if (ticket == 0)
+        return nullptr;
+    const auto it = std::find_if(slots_.begin(), slots_.end(),
+        [ticket](const Slot& slot) { return slot.ticket == ticket; });
+    return it != slots_.end() ? &*it : nullptr;
+}
+
+const AsyncReadback::Slot* AsyncReadback::findSlot(Ticket ticket) const
+{
+    if (ticket == 0)
+        return nullptr;
+    const auto it = std::find_if(slots_.begin(), slots_.end(),
+        [ticket](const Slot& slot) { return slot.ticket == ticket; });
+    return it != slots_.end() ? &*it : nullptr;
+}
+}
@@ -0,0 +1,191 @@
+#include "glwx/shadercache.hpp"
+
+#include <cstring>
+#include <fstream>
+
+#include <fmt/format.h>
+#include <fmt/std.h>
+
+#include "glw/fmt.hpp"
+#include "glwx/shader.hpp"
+#include "glwx/utility.hpp"
+
+using namespace glw;
+
+namespace glwx {
+namespace {
+    uint64_t fnv1a(uint64_t hash, std::string_view str)
+    {
+        // Hash the size too, so moving characters between strings changes the hash
+        const auto size = static_cast<uint64_t>(str.size());
+        hash = glwx::fnv1a(hash, &size, sizeof(size));
+        return glwx::fnv1a(hash, str.data(), str.size());
+    }
+
+    std::string_view getString(GLenum name)
+    {
+        const auto str = reinterpret_cast<const char*>(glGetString(name));
+        return str ? std::string_view(str) : std::string_view();
+    }
+
+    struct FileHeader {
+        char magic[4] = { 'G', 'L', 'W', 'B' };
+        uint32_t version = 1;
+        uint64_t key = 0;
+        uint32_t format = 0;
+        uint32_t size = 0;
+    };
+}
+
+ShaderProgramCache::ShaderProgramCache(std::filesystem::path directory)
+    : directory_(std::move(directory))
+    , supported_(ShaderProgram::getBinarySupported())
+{
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec)
+        LOG_ERROR("Could not create shader cache directory '{}': {}", directory_, ec.message());
+    if (!supported_)
+        LOG_WARNING("Program binaries are not supported. Shader cache is disabled.");
+}
+
+std::optional<ShaderProgram> ShaderProgramCache::get(const std::vector<Stage>& stages)
+{
+    const auto key = getKey(stages);
+
+    if (supported_) {
+        if (const auto binary = load(key)) {
+            ShaderProgram prog;
+            if (prog.loadBinary(*binary)) {
+                statistics_.hits++;
+                return prog;
+            }
+            statistics_.rejected++;
+            LOG_DEBUG("Cached program binary {} was rejected, recompiling", getPath(key));
+        }
+    }
+    statistics_.misses++;
+
+    std::vector<Shader> shaders;
+    for (const auto& [type, source] : stages) {
+        auto shader = makeShader(type, source);
+        if (!shader)
+            return std::nullopt;
+        shaders.push_back(std::move(*shader));
+    }
+
+    ShaderProgram prog;
+    if (supported_)
+        prog.setBinaryRetrievable(true);
+    for (const auto& shader : shaders)
+        prog.attach(shader);
+    const auto linkRes = prog.link();
+    if (!linkRes.log.empty())
+        LOG_WARNING("Link log: {}", linkRes.log);
+    if (!linkRes)
+        return std::nullopt;
+    prog.detach();
+
+    if (supported_) {
+        if (const auto binary = prog.getBinary())
+            store(key, *binary);
+    }
+    return prog;
+}
+
+std::optional<ShaderProgram> ShaderProgramCache::get(
+    std::string_view vertSource, std::string_view fragSource)
+{
+    return get({ { Shader::Type::Vertex, vertSource }, { Shader::Type::Fragment, fragSource } });
+}
+
+void ShaderProgramCache::clear()
+{
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory_, ec)) {
+        if (entry.path().extension() == ".glwb")
+            std::filesystem::remove(entry.path(), ec);
+    }
+}
+
+const ShaderProgramCache::Statistics& ShaderProgramCache::getStatistics() const
+{
+    return statistics_;
+}
+
+uint64_t ShaderProgramCache::getKey(const std::vector<Stage>& stages)
+{
+    uint64_t hash = fnv1aOffsetBasis;
+    hash = fnv1a(hash, getString(GL_VENDOR));
+    hash = fnv1a(hash, getString(GL_RENDERER));
+    hash = fnv1a(hash, getString(GL_VERSION));
+    for (const auto& [type, source] : stages) {
+        const auto t = static_cast<GLenum>(type);
+        hash = fnv1a(hash, &t, sizeof(t));
+        hash = fnv1a(hash, source);
+    }
+    return hash;
+}
+
+std::filesystem::path ShaderProgramCache::getPath(uint64_t key) const
+{
+    return directory_ / fmt::format("{:016x}.glwb", key);
+}
+
+std::optional<ShaderProgram::Binary> ShaderProgramCache::load(uint64_t key) const
+{
+    std::ifstream file(getPath(key), std::ios::binary);
+    if (!file)
+        return std::nullopt;
+    std::error_code ec;
+    const auto fileSize = std::filesystem::file_size(getPath(key), ec);
+
+    FileHeader header;
+    const auto expected = FileHeader {};
+    // Check the size before allocating, so a corrupt header can't make us allocate gigabytes
+    if (ec || !file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader))
+        || std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0
+        || header.version != expected.version || header.key != key
+        || header.size > fileSize - sizeof(FileHeader)) {
+        LOG_WARNING("Invalid shader cache file {}", getPath(key));
+        return std::nullopt;
+    }
+
+    ShaderProgram::Binary binary { header.format, std::vector<uint8_t>(header.size) };
+    if (!file.read(reinterpret_cast<char*>(binary.data.data()), header.size)) {
+        LOG_WARNING("Truncated shader cache file {}", getPath(key));
+        return std::nullopt;
+    }
+    return binary;
+}
+
+void ShaderProgramCache::store(uint64_t key, const ShaderProgram::Binary& binary) const
+{
+    // Write to a temporary file and rename it, so other processes never read a partial file
+    const auto path = getPath(key);
+    const auto tmpPath = getTempPath(path);
+    {
+        std::ofstream file(tmpPath, std::ios::binary);
+        FileHeader header;
+        header.key = key;
+        header.format = binary.format;
+        header.size = static_cast<uint32_t>(binary.data.size());
+        file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+        file.write(reinterpret_cast<const char*>(binary.data.data()),
+            static_cast<std::streamsize>(binary.data.size()));
+        if (!file) {
+            LOG_ERROR("Could not write shader cache file {}", tmpPath);
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(tmpPath, ec);
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        LOG_ERROR("Could not write shader cache file {}: {}", path, ec.message());
+        std::filesystem::remove(tmpPath, ec);
+    }
+}
+}
@@ -0,0 +1,245 @@
+#include "glwx/shaderpreprocessor.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include <fmt/format.h>
+#include <fmt/std.h>
+
+#include "glw/log.hpp"
+#include "glwx/utility.hpp"
+
+namespace glwx {
+namespace {
+    std::string_view trimLeft(std::string_view str)
+    {
+        const auto start = str.find_first_not_of(" \t");
+        return start == std::string_view::npos ? std::string_view() : str.substr(start);
+    }
+
+    std::string_view trim(std::string_view str)
+    {
+        str = trimLeft(str);
+        const auto end = str.find_last_not_of(" \t\r");
+        return end == std::string_view::npos ? std::string_view() : str.substr(0, end + 1);
+    }
+
+    // Returns the directive name and the rest of the line, e.g. {"include", " \"foo.glsl\""}
+    std::pair<std::string_view, std::string_view> parseDirective(std::string_view line)
+    {
+        line = trimLeft(line);
+        if (line.empty() || line[0] != '#')
+            return {};
+        line = trimLeft(line.substr(1));
+        const auto end = std::min(line.find_first_of(" \t\r"), line.size());
+        return { line.substr(0, end), line.substr(end) };
+    }
+
+    std::optional<std::string_view> parseIncludeName(std::string_view args)
+    {
+        args = trim(args);
+        if (args.size() < 2)
+            return std::nullopt;
+        const auto close = args[0] == '"' ? '"' : args[0] == '<' ? '>' : '\0';
+        if (!close || args.back() != close)
+            return std::nullopt;
+        return args.substr(1, args.size() - 2);
+    }
+
+    bool hasVersionDirective(std::string_view source)
+    {
+        size_t pos = 0;
+        while (pos < source.size()) {
+            const auto end = std::min(source.find('\n', pos), source.size());
+            if (parseDirective(source.substr(pos, end - pos)).first == "version")
+                return true;
+            pos = end + 1;
+        }
+        return false;
+    }
+
+    size_t getFileIndex(
+        std::vector<std::filesystem::path>& files, const std::filesystem::path& path)
+    {
+        const auto it = std::find(files.begin(), files.end(), path);
+        if (it != files.end())
+            return static_cast<size_t>(it - files.begin());
+        files.push_back(path);
+        return files.size() - 1;
+    }
+}
+
+struct ShaderPreprocessor::Context {
+    explicit Context(const Defines& defines)
+        : defines(defines)
+    {
+    }
+
+    Result result;
+    const Defines& defines;
+    bool definesInjected = false;
+    // For detecting recursive includes
+    std::vector<std::filesystem::path> includeStack;
+    std::unordered_set<std::string> onceFiles;
+
+    void injectDefines()
+    {
+        for (const auto& [name, value] : defines) {
+            if (value.empty())
+                result.source.append(fmt::format("#define {}\n", name));
+            else
+                result.source.append(fmt::format("#define {} {}\n", name, value));
+        }
+        definesInjected = true;
+    }
+};
+
+void ShaderPreprocessor::addSearchPath(std::filesystem::path path)
+{
+    searchPaths_.push_back(std::move(path));
+}
+
+void ShaderPreprocessor::addFile(std::filesystem::path name, std::string source)
+{
+    files_.insert_or_assign(name.lexically_normal().string(), std::move(source));
+}
+
+std::optional<ShaderPreprocessor::Result> ShaderPreprocessor::process(
+    const std::filesystem::path& path, const Defines& defines) const
+{
+    const auto normalized = path.lexically_normal();
+    const auto source = loadFile(normalized);
+    if (!source) {
+        LOG_ERROR("Could not read file '{}'", path);
+        return std::nullopt;
+    }
+    return run(normalized, *source, defines);
+}
+
+std::optional<ShaderPreprocessor::Result> ShaderPreprocessor::processSource(
+    std::string_view source, const Defines& defines) const
+{
+    return run(std::filesystem::path(), source, defines);
+}
+
+std::optional<ShaderPreprocessor::Result> ShaderPreprocessor::run(
+    const std::filesystem::path& path, std::string_view source, const Defines& defines) const
+{
+    Context ctx(defines);
+    ctx.result.source.reserve(source.size());
+    if (!hasVersionDirective(source)) {
+        // Without a #version directive the defines can just go first
+        ctx.injectDefines();
+        if (!defines.empty())
+            ctx.result.source.append("#line 1 0\n");
+    }
+    ctx.includeStack.push_back(path);
+    if (!processFile(ctx, path, source, 0))
+        return std::nullopt;
+    return std::move(ctx.result);
+}
+
+std::optional<std::string> ShaderPreprocessor::loadFile(const std::filesystem::path& path) const
+{
+    const auto it = files_.find(path.string());
+    if (it != files_.end())
+        return it->second;
+    return readFile(path);
+}
+
+std::optional<std::filesystem::path> ShaderPreprocessor::resolveInclude(
+    const std::filesystem::path& includingFile, const std::filesystem::path& name) const
+{
+    std::vector<std::filesystem::path> candidates;
+    if (!includingFile.empty())
+        candidates.push_back(includingFile.parent_path() / name);
+    for (const auto& searchPath : searchPaths_)
+        candidates.push_back(searchPath / name);
+    // In-memory files might have been registered without a directory
+    candidates.push_back(name);
+
+    for (const auto& candidate : candidates) {
+        const auto normalized = candidate.lexically_normal();
+        if (files_.count(normalized.string()))
+            return normalized;
+        std::error_code ec;
+        if (std::filesystem::is_regular_file(normalized, ec))
+            return normalized;
+    }
+    return std::nullopt;
+}
+
+bool ShaderPreprocessor::processFile(
+    Context& ctx, const std::filesystem::path& path, std::string_view source, size_t depth) const
+{
+    const auto fileIndex = getFileIndex(ctx.result.files, path);
+    auto& out = ctx.result.source;
+    if (depth > 0)
+        out.append(fmt::format("#line 1 {}\n", fileIndex));
+
+    size_t lineNumber = 0;
+    size_t pos = 0;
+    while (pos < source.size()) {
+        const auto end = std::min(source.find('\n', pos), source.size());
+        const auto line = source.substr(pos, end - pos);
+        pos = end + 1;
+        lineNumber++;
+
+        const auto [directive, args] = parseDirective(line);
+        if (directive == "include") {
+            const auto name = parseIncludeName(args);
+            if (!name) {
+                LOG_ERROR("Malformed #include in '{}' (line {})", path, lineNumber);
+                return false;
+            }
+            const auto includePath = resolveInclude(path, *name);
+            if (!includePath) {
+                LOG_ERROR("Could not find '{}' included from '{}' (line {})", *name, path,
+                    lineNumber);
+                return false;
+            }
+            if (ctx.onceFiles.count(includePath->string())) {
+                out.push_back('\n');
+                continue;
+            }
+            const auto& stack = ctx.includeStack;
+            if (std::find(stack.begin(), stack.end(), *includePath) != stack.end()) {
+                LOG_ERROR("Recursive include of '{}' in '{}' (line {})", *includePath, path,
+                    lineNumber);
+                return false;
+            }
+            if (depth + 1 > maxIncludeDepth) {
+                LOG_ERROR("Maximum include depth exceeded in '{}' (line {})", path, lineNumber);
+                return false;
+            }
+            const auto includeSource = loadFile(*includePath);
+            if (!includeSource) {
+                LOG_ERROR("Could not read file '{}'", *includePath);
+                return false;
+            }
+            ctx.includeStack.push_back(*includePath);
+            if (!processFile(ctx, *includePath, *includeSource, depth + 1))
+                return false;
+            ctx.includeStack.pop_back();
+            out.append(fmt::format("#line {} {}\n", lineNumber + 1, fileIndex));
+            continue;
+        }
+
+        if (directive == "pragma" && trim(args) == "once") {
+            ctx.onceFiles.insert(path.string());
+            out.push_back('\n');
+            continue;
+        }
+
+        out.append(line);
+        out.push_back('\n');
+
+        if (directive == "version" && depth == 0 && !ctx.definesInjected) {
+            ctx.injectDefines();
+            if (!ctx.defines.empty())
+                out.append(fmt::format("#line {} {}\n", lineNumber + 1, fileIndex));
+        }
+    }
+    return true;
+}
+}
@@ -0,0 +1,169 @@
+#include "glwx/shadervariants.hpp"
+
+#include <algorithm>
+
+#include <fmt/format.h>
+#include <fmt/std.h>
+
+#include "glw/fmt.hpp"
+#include "glw/utility.hpp"
+
+using namespace glw;
+
+namespace glwx {
+namespace {
+    std::string formatFiles(const std::vector<std::filesystem::path>& files)
+    {
+        std::string str;
+        for (size_t i = 0; i < files.size(); ++i)
+            str.append(fmt::format("\n  {}: {}", i, files[i]));
+        return str;
+    }
+}
+
+size_t ShaderVariantCache::StageKeyHash::operator()(const StageKey& key) const
+{
+    size_t seed = 0;
+    hashCombine(seed, static_cast<GLenum>(key.type));
+    hashCombine(seed, key.source);
+    return seed;
+}
+
+ShaderVariantCache::ShaderVariantCache(ShaderPreprocessor preprocessor)
+    : preprocessor_(std::move(preprocessor))
+{
+}
+
+const ShaderProgram* ShaderVariantCache::get(
+    const std::vector<Stage>& stages, const Defines& defines)
+{
+    auto& bucket = variants_[hash(stages, defines)];
+    for (const auto& variant : bucket) {
+        if (matches(*variant, stages, defines))
+            return variant->program ? &*variant->program : nullptr;
+    }
+
+    auto variant = std::make_unique<Variant>();
+    variant->stages = stages;
+    variant->defines = defines;
+    std::stable_sort(variant->defines.begin(), variant->defines.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+    variant->program = build(stages, variant->defines);
+    if (!variant->program)
+        statistics_.failures++;
+    const auto program = variant->program ? &*variant->program : nullptr;
+    bucket.push_back(std::move(variant));
+    variantCount_++;
+    return program;
+}
+
+const ShaderProgram* ShaderVariantCache::get(
+    const std::filesystem::path& vert, const std::filesystem::path& frag, const Defines& defines)
+{
+    return get({ { Shader::Type::Vertex, vert }, { Shader::Type::Fragment, frag } }, defines);
+}
+
+void ShaderVariantCache::clear()
+{
+    variants_.clear();
+    stages_.clear();
+    variantCount_ = 0;
+}
+
+ShaderPreprocessor& ShaderVariantCache::getPreprocessor()
+{
+    return preprocessor_;
+}
+
+size_t ShaderVariantCache::getVariantCount() const
+{
+    return variantCount_;
+}
+
+const ShaderVariantCache::Statistics& ShaderVariantCache::getStatistics() const
+{
+    return statistics_;
+}
+
+size_t ShaderVariantCache::hash(const std::vector<Stage>& stages, const Defines& defines)
+{
+    size_t seed = 0;
+    for (const auto& [type, path] : stages) {
+        hashCombine(seed, static_cast<GLenum>(type));
+        hashCombine(seed, path.native());
+    }
+    // Summing is commutative, so the order of the defines doesn't change the hash
+    size_t definesHash = 0;
+    for (const auto& [name, value] : defines) {
+        size_t defineHash = 0;
+        hashCombine(defineHash, name);
+        hashCombine(defineHash, value);
+        definesHash += defineHash;
+    }
+    hashCombine(seed, definesHash);
+    return seed;
+}
+
+bool ShaderVariantCache::matches(
+    const Variant& variant, const std::vector<Stage>& stages, const Defines& defines)
+{
+    if (variant.stages != stages || variant.defines.size() != defines.size())
+        return false;
+    // This is quadratic, but there are usually only a handful of defines and this way we don't
+    // have to sort (and copy) the defines on every lookup. Comparing the counts instead of just
+    // looking for every define makes sure duplicates don't match, e.g. {A, A} and {A, B}.
+    return std::all_of(defines.begin(), defines.end(), [&](const auto& define) {
+        return std::count(defines.begin(), defines.end(), define)
+            == std::count(variant.defines.begin(), variant.defines.end(), define);
+    });
+}
+
+std::optional<ShaderProgram> ShaderVariantCache::build(
+    const std::vector<Stage>& stages, const Defines& defines)
+{
+    ShaderProgram prog;
+    for (const auto& [type, path] : stages) {
+        auto res = preprocessor_.process(path, defines);
+        if (!res)
+            return std::nullopt;
+        const auto shader = getStage(type, std::move(res->source));
+        if (!shader) {
+            LOG_ERROR("Could not compile '{}'. Source string numbers:{}", path,
+                formatFiles(res->files));
+            return std::nullopt;
+        }
+        prog.attach(*shader);
+    }
+
+    const auto linkRes = prog.link();
+    if (!linkRes.log.empty())
+        LOG_WARNING("Link log: {}", linkRes.log);
+    if (!linkRes) {
+        LOG_ERROR("Could not link shader program");
+        return std::nullopt;
+    }
+    // The stages stay alive in stages_ for other variants
+    prog.detach();
+    statistics_.programsLinked++;
+    return prog;
+}
+
+const Shader* ShaderVariantCache::getStage(Shader::Type type, std::string source)
+{
+    auto [it, inserted] = stages_.try_emplace(StageKey { type, std::move(source) });
+    if (!inserted) {
+        statistics_.stagesShared++;
+        return it->second ? &*it->second : nullptr;
+    }
+
+    Shader shader(type);
+    shader.setSource(it->first.source);
+    const auto res = shader.compile();
+    if (!res.log.empty())
+        LOG_WARNING("Shader log: {}", res.log);
+    statistics_.stagesCompiled++;
+    if (res)
+        it->second = std::move(shader);
+    return it->second ? &*it->second : nullptr;
+}
+}
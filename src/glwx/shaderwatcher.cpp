@@ -0,0 +1,204 @@
+#include "glwx/shaderwatcher.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include <fmt/std.h>
+
+#include "glw/fmt.hpp"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace glw;
+
+namespace glwx {
+ShaderWatcher::ShaderWatcher(ShaderPreprocessor preprocessor)
+    : preprocessor_(std::move(preprocessor))
+{
+#ifdef __linux__
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0)
+        LOG_ERROR("Could not initialize inotify, shaders will not be reloaded");
+#else
+    LOG_WARNING("Shader hot reloading is only supported on Linux");
+#endif
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+#ifdef __linux__
+    // This removes all the watches as well
+    if (inotifyFd_ >= 0)
+        close(inotifyFd_);
+#endif
+}
+
+ShaderProgram* ShaderWatcher::add(const std::vector<Stage>& stages, const Defines& defines)
+{
+    assert(!stages.empty());
+    auto build = startBuild(stages, defines);
+    if (!build)
+        return nullptr;
+    compiler_.finish();
+    auto prog = build->future.get();
+    if (!prog)
+        return nullptr;
+
+    auto& program = programs_.emplace_back(std::make_unique<Program>(
+        Program { stages, defines, std::move(build->files), std::move(*prog), std::nullopt }));
+    watch(program->files);
+    return &program->program;
+}
+
+ShaderProgram* ShaderWatcher::add(
+    const std::filesystem::path& vert, const std::filesystem::path& frag, const Defines& defines)
+{
+    return add({ { Shader::Type::Vertex, vert }, { Shader::Type::Fragment, frag } }, defines);
+}
+
+size_t ShaderWatcher::poll()
+{
+    const auto changed = readChanges();
+    if (!changed.empty()) {
+        for (auto& program : programs_) {
+            const auto affected = std::any_of(program->files.begin(), program->files.end(),
+                [&changed](const std::filesystem::path& file) {
+                    return std::binary_search(changed.begin(), changed.end(), file);
+                });
+            if (!affected)
+                continue;
+            LOG_INFO("Rebuilding shader program ({})", program->stages.front().second);
+            // If it is already being rebuilt, the old rebuild is discarded, because its sources
+            // are outdated already.
+            if (auto rebuild = startBuild(program->stages, program->defines))
+                program->rebuild = std::move(*rebuild);
+        }
+    }
+    compiler_.update();
+    return swapFinished();
+}
+
+void ShaderWatcher::finish()
+{
+    compiler_.finish();
+    swapFinished();
+}
+
+bool ShaderWatcher::isWatching() const
+{
+    return inotifyFd_ >= 0;
+}
+
+std::optional<ShaderWatcher::Program::Rebuild> ShaderWatcher::startBuild(
+    const std::vector<Stage>& stages, const Defines& defines)
+{
+    std::vector<std::string> sources;
+    std::vector<std::filesystem::path> files;
+    for (const auto& [type, path] : stages) {
+        auto res = preprocessor_.process(path, defines);
+        if (!res)
+            return std::nullopt;
+        sources.push_back(std::move(res->source));
+        for (const auto& file : res->files) {
+            std::error_code ec;
+            const auto absolute = std::filesystem::absolute(file, ec).lexically_normal();
+            if (!ec && std::find(files.begin(), files.end(), absolute) == files.end())
+                files.push_back(absolute);
+        }
+    }
+
+    std::vector<AsyncShaderCompiler::Stage> asyncStages;
+    for (size_t i = 0; i < stages.size(); ++i)
+        asyncStages.emplace_back(stages[i].first, sources[i]);
+    return Program::Rebuild { compiler_.add(asyncStages), std::move(files) };
+}
+
+void ShaderWatcher::watch(const std::vector<std::filesystem::path>& files)
+{
+#ifdef __linux__
+    if (inotifyFd_ < 0)
+        return;
+    for (const auto& file : files) {
+        const auto dir = file.parent_path();
+        const auto watched = std::any_of(watchDirs_.begin(), watchDirs_.end(),
+            [&dir](const auto& entry) { return entry.second == dir; });
+        if (watched)
+            continue;
+        const auto wd = inotify_add_watch(
+            inotifyFd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd < 0)
+            LOG_WARNING("Could not watch directory '{}'", dir);
+        else
+            watchDirs_.emplace(wd, dir);
+    }
+#else
+    (void)files;
+#endif
+}
+
+std::vector<std::filesystem::path> ShaderWatcher::readChanges()
+{
+    std::vector<std::filesystem::path> changed;
+#ifdef __linux__
+    if (inotifyFd_ < 0)
+        return changed;
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        // The fd is non-blocking, so this fails with EAGAIN once all events have been read
+        const auto n = read(inotifyFd_, buffer, sizeof(buffer));
+        if (n <= 0)
+            break;
+        for (auto ptr = buffer; ptr < buffer + n;) {
+            const auto event = reinterpret_cast<const inotify_event*>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) {
+                // We lost events, so we have to assume everything changed
+                for (const auto& program : programs_)
+                    changed.insert(changed.end(), program->files.begin(), program->files.end());
+                continue;
+            }
+            const auto it = watchDirs_.find(event->wd);
+            if (it != watchDirs_.end() && event->len > 0)
+                changed.push_back(it->second / event->name);
+        }
+    }
+#endif
+    // Saving a file usually produces multiple events
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    return changed;
+}
+
+size_t ShaderWatcher::swapFinished()
+{
+    size_t swapped = 0;
+    for (auto& program : programs_) {
+        if (!program->rebuild || !program->rebuild->future.isReady())
+            continue;
+        auto rebuild = std::move(*program->rebuild);
+        program->rebuild.reset();
+        // A file that was newly included might be broken, we want to notice when it's fixed
+        watch(rebuild.files);
+
+        auto prog = rebuild.future.get();
+        if (!prog) {
+            LOG_ERROR("Could not rebuild shader program ({}), keeping the old one",
+                program->stages.front().second);
+            for (auto& file : rebuild.files) {
+                if (std::find(program->files.begin(), program->files.end(), file)
+                    == program->files.end())
+                    program->files.push_back(std::move(file));
+            }
+            continue;
+        }
+        prog->copyUniformValues(program->program);
+        program->program = std::move(*prog);
+        program->files = std::move(rebuild.files);
+        swapped++;
+    }
+    return swapped;
+}
+}
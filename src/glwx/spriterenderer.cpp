@@ -1,19 +1,21 @@
 #include "glwx/spriterenderer.hpp"
 
+#include <cstring>
+
 #include "glwx/shader.hpp"
 
 namespace glwx {
 
 SpriteBatch::SpriteBatch(size_t vertexCount, size_t indexCount)
     : primitive_(glw::DrawMode::Triangles)
-    , vertexBuffer_(glw::Buffer::Target::Array, glw::Buffer::UsageHint::StreamDraw)
-    , indexBuffer_(glw::Buffer::Target::ElementArray, glw::Buffer::UsageHint::StreamDraw)
+    , vertexBuffer_(vertexStreamSize)
+    , indexBuffer_(indexStreamSize)
 {
     vertices_.reserve(vertexCount);
     indices_.reserve(indexCount > 0 ? indexCount : vertexCount);
 
-    primitive_.addVertexBuffer(vertexBuffer_, getVertexFormat());
-    primitive_.setIndexBuffer(indexBuffer_, glw::IndexEnum<IndexType>);
+    primitive_.addVertexBuffer(vertexBuffer_.getBuffer(), getVertexFormat());
+    primitive_.setIndexBuffer(indexBuffer_.getBuffer(), glw::IndexEnum<IndexType>);
 }
 
 SpriteBatch::IndexType SpriteBatch::addVertex(
@@ -49,9 +51,23 @@ void SpriteBatch::clear()
 void SpriteBatch::flush()
 {
     if (!indices_.empty()) {
-        vertexBuffer_.update(vertices_);
-        indexBuffer_.update(indices_);
-        primitive_.draw(0, indices_.size());
+        // Align to the element size, so we can express the offsets in vertices/indices
+        const auto vertexSize = sizeof(Vertex) * vertices_.size();
+        const auto vertices = vertexBuffer_.map(vertexSize, sizeof(Vertex));
+        std::memcpy(vertices.data, vertices_.data(), vertexSize);
+        vertexBuffer_.unmap();
+
+        const auto indexSize = sizeof(IndexType) * indices_.size();
+        const auto indices = indexBuffer_.map(indexSize, sizeof(IndexType));
+        std::memcpy(indices.data, indices_.data(), indexSize);
+        indexBuffer_.unmap();
+
+        primitive_.vertexRange
+            = Primitive::Range { vertices.offset / sizeof(Vertex), vertices_.size() };
+        primitive_.draw(indices.offset / sizeof(IndexType), indices_.size());
+
+        vertexBuffer_.fence();
+        indexBuffer_.fence();
     }
     clear();
 }
@@ -73,6 +89,14 @@ glw::ShaderProgram& SpriteRenderer::getDefaultShaderProgram()
     return shader;
 }
 
+void SpriteRenderer::setShaderProgram(const glw::ShaderProgram* program, const std::string& sampler)
+{
+    flush();
+    shaderProgram_ = program;
+    samplerLocation_
+        = program ? program->getUniformLocation(sampler) : glw::ShaderProgram::invalidLocation;
+}
+
 void SpriteRenderer::setCurrentTexture(const glw::Texture* texture)
 {
     if (currentTexture_ != texture) {
@@ -85,14 +109,26 @@ void SpriteRenderer::setCurrentTexture(const glw::Texture* texture)
 
 void SpriteRenderer::draw(
     const glw::Texture& texture, const Transform2D& transform, const TextureRegion& region)
+{
+    const auto size = glm::vec2(
+        static_cast<float>(texture.getWidth()), static_cast<float>(texture.getHeight()));
+    drawQuad(texture, transform, size, region);
+}
+
+void SpriteRenderer::draw(const TextureAtlas::Region& region, const Transform2D& transform)
+{
+    assert(region.texture);
+    drawQuad(*region.texture, transform, region.getSize(), region.region);
+}
+
+void SpriteRenderer::drawQuad(const glw::Texture& texture, const Transform2D& transform,
+    const glm::vec2& size, const TextureRegion& region)
 {
     setCurrentTexture(&texture);
 
     const auto p = transform.transformPoint(glm::vec2(0.0f, 0.0f));
-    const auto sx
-        = transform.transformDirection(glm::vec2(static_cast<float>(texture.getWidth()), 0.0f));
-    const auto sy
-        = transform.transformDirection(glm::vec2(0.0f, static_cast<float>(texture.getHeight())));
+    const auto sx = transform.transformDirection(glm::vec2(size.x, 0.0f));
+    const auto sy = transform.transformDirection(glm::vec2(0.0f, size.y));
 
     const auto tl = addVertex(p, region.position);
     const auto tr = addVertex(p + sx, region.position + glm::vec2(region.size.x, 0.0f));
@@ -213,8 +249,12 @@ void SpriteRenderer::flush()
     // This was an assert(currentTexture_) before and it should not be nullptr, except if the
     // SpriteRenderer was not used yet.
     if (currentTexture_) {
-        // We could (should!) be cleverer with allocating texture units here
-        currentTexture_->bind(0);
+        if (shaderProgram_) {
+            shaderProgram_->bind();
+            shaderProgram_->setUniform(samplerLocation_, *currentTexture_);
+        } else {
+            currentTexture_->bind(0);
+        }
         batch_.flush();
     }
 }
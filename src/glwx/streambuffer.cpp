@@ -0,0 +1,113 @@
+#include "glwx/streambuffer.hpp"
+
+#include <cassert>
+
+#include "glw/log.hpp"
+
+using namespace glw;
+
+namespace glwx {
+StreamBuffer::StreamBuffer(size_t size)
+    : size_(size)
+{
+    assert(size > 0);
+    if (Buffer::storageSupported()) {
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        buffer_.storage(mapTarget, size_, flags);
+        persistentData_ = static_cast<uint8_t*>(buffer_.map(mapTarget, 0, size_, flags));
+        if (!persistentData_)
+            LOG_CRITICAL("Could not map stream buffer persistently");
+    } else {
+        buffer_.data(mapTarget, Buffer::UsageHint::StreamDraw, static_cast<const void*>(nullptr),
+            size_);
+    }
+}
+
+StreamBuffer::Allocation StreamBuffer::map(size_t size, size_t alignment)
+{
+    assert(!mapped_);
+    assert(size <= size_);
+    assert(alignment > 0);
+
+    auto offset = position_ % size_;
+    const auto aligned = (offset + alignment - 1) / alignment * alignment;
+    if (aligned + size > size_) {
+        // Skip the rest of the buffer and wrap around
+        position_ += size_ - offset;
+        offset = 0;
+    } else {
+        position_ += aligned - offset;
+        offset = aligned;
+    }
+
+    const auto end = position_ + size;
+    if (end > size_)
+        waitUntilFree(end - size_);
+    position_ = end;
+
+    if (persistentData_)
+        return Allocation { persistentData_ + offset, offset, size };
+
+    // We do our own synchronization, so we don't need the driver to do it
+    constexpr GLbitfield access
+        = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    const auto data = static_cast<uint8_t*>(buffer_.map(mapTarget, offset, size, access));
+    if (!data)
+        LOG_ERROR("Could not map stream buffer range");
+    mapped_ = data != nullptr;
+    return Allocation { data, offset, size };
+}
+
+void StreamBuffer::unmap()
+{
+    if (!mapped_)
+        return;
+    if (!buffer_.unmap(mapTarget))
+        LOG_ERROR("Stream buffer data store was corrupted while mapped");
+    mapped_ = false;
+}
+
+void StreamBuffer::fence()
+{
+    if (position_ == fencedPosition_)
+        return;
+    auto& region = regions_.emplace_back(Region { position_, Fence {} });
+    region.fence.insert();
+    fencedPosition_ = position_;
+}
+
+const Buffer& StreamBuffer::getBuffer() const
+{
+    return buffer_;
+}
+
+size_t StreamBuffer::getSize() const
+{
+    return size_;
+}
+
+bool StreamBuffer::isPersistent() const
+{
+    return persistentData_ != nullptr;
+}
+
+void StreamBuffer::waitUntilFree(size_t position)
+{
+    if (fencedPosition_ < position) {
+        // More than the whole buffer was allocated since the last fence. The data has been
+        // submitted already (otherwise it would be overwritten anyways), so we fence now.
+        fence();
+    }
+
+    // Fences are signaled in order, so we only have to wait for the first one that covers
+    // position and can drop all the ones before it.
+    while (!regions_.empty()) {
+        const auto end = regions_.front().end;
+        if (end >= position && !regions_.front().fence.wait())
+            LOG_ERROR("Waiting for stream buffer fence failed");
+        regions_.pop_front();
+        if (end >= position)
+            break;
+    }
+}
+}
@@ -4,7 +4,10 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include <fmt/std.h>
+
 #include "glw/log.hpp"
+#include "glwx/compressedtexture.hpp"
 #include "glwx/utility.hpp"
 
 using namespace glw;
@@ -36,6 +39,28 @@ Texture makeTexture2D(
     return texture;
 }
 
+Texture makeTexture2D(const uint8_t* buffer, size_t width, size_t height, size_t channels,
+    const MipmapGenerator& generator, const MipmapGenerator::Options& options)
+{
+    assert(channels >= 1 && channels <= 4);
+    auto format = channelsToFormat[channels - 1];
+    const auto dataFormat = static_cast<Texture::DataFormat>(format);
+    // There are no sRGB formats with 1 or 2 channels, so those stay linear and must be filtered
+    // as linear too, otherwise the levels would be darker than the base level.
+    auto genOptions = options;
+    genOptions.srgb = options.srgb && channels >= 3;
+    if (genOptions.srgb)
+        format = channels == 3 ? ImageFormat::Srgb8 : ImageFormat::Srgb8Alpha8;
+    // Generate first, so the texture is not half-initialized for as long
+    const auto levels = generator.generate(buffer, width, height, channels, genOptions);
+    Texture texture(Texture::Target::Texture2D);
+    texture.storage(0, format, width, height);
+    texture.subImage(dataFormat, Texture::DataType::U8, buffer);
+    MipmapGenerator::upload(texture, levels, dataFormat);
+    texture.setFilter(Texture::MinFilter::LinearMipmapNearest, Texture::MagFilter::Linear);
+    return texture;
+}
+
 Texture makeTexture2D(const glm::vec4& color, size_t width, size_t height, bool mipmaps)
 {
     const auto c = colorToInt(color);
@@ -87,6 +112,36 @@ std::optional<glw::Texture> makeTexture2D(const std::filesystem::path& path, boo
     return makeTexture2D(image.get(), width, height, channels, mipmaps);
 }
 
+std::optional<glw::Texture> makeTexture2D(const std::filesystem::path& path,
+    const BlockCompressor& compressor, const BlockCompressor::Options& options,
+    CompressedTextureCache* cache)
+{
+    const auto contents = readFile(path);
+    if (!contents) {
+        LOG_ERROR("Could not read '{}'", path);
+        return std::nullopt;
+    }
+    const auto key
+        = cache ? CompressedTextureCache::getKey(contents->data(), contents->size(), options) : 0;
+    if (cache) {
+        if (const auto data = cache->load(key))
+            return makeCompressedTexture(*data);
+    }
+
+    int width = 0, height = 0, channels = 0;
+    const auto image = stbiImagePtr(
+        stbi_load_from_memory(reinterpret_cast<const uint8_t*>(contents->data()),
+            static_cast<int>(contents->size()), &width, &height, &channels, 0));
+    if (!image) {
+        LOG_ERROR("Could not load image from file: {}", stbi_failure_reason());
+        return std::nullopt;
+    }
+    const auto data = compressor.compress(image.get(), width, height, channels, options);
+    if (cache)
+        cache->store(key, data);
+    return makeCompressedTexture(data);
+}
+
 std::optional<glw::Texture> makeCubeTexture(const std::filesystem::path& posX,
     const std::filesystem::path& negX, const std::filesystem::path& posY,
     const std::filesystem::path& negY, const std::filesystem::path& posZ,
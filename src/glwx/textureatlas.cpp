@@ -0,0 +1,389 @@
+#include "glwx/textureatlas.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <limits>
+
+#include <fmt/std.h>
+
+#include "stb_image.h"
+
+#include "glw/log.hpp"
+#include "glwx/utility.hpp"
+
+using namespace glw;
+
+namespace glwx {
+namespace {
+    bool contains(const RectPacker::Rect& outer, const RectPacker::Rect& inner)
+    {
+        return inner.x >= outer.x && inner.y >= outer.y
+            && inner.x + inner.width <= outer.x + outer.width
+            && inner.y + inner.height <= outer.y + outer.height;
+    }
+
+    bool intersects(const RectPacker::Rect& a, const RectPacker::Rect& b)
+    {
+        return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height
+            && b.y < a.y + a.height;
+    }
+
+    // Invalid options are logged and fixed up, so the alignment shift is always defined
+    TextureAtlas::Options validate(TextureAtlas::Options options)
+    {
+        if (options.pageWidth == 0 || options.pageHeight == 0) {
+            LOG_ERROR("Invalid atlas page size {}x{}", options.pageWidth, options.pageHeight);
+            options.pageWidth = std::max(options.pageWidth, size_t(1));
+            options.pageHeight = std::max(options.pageHeight, size_t(1));
+        }
+        // The alignment (2^(mipLevels - 1)) must not be larger than a page
+        size_t maxLevels = 1;
+        while ((size_t(1) << maxLevels) <= std::min(options.pageWidth, options.pageHeight))
+            maxLevels++;
+        if (options.mipLevels < 1 || options.mipLevels > maxLevels) {
+            const auto levels = std::clamp(options.mipLevels, size_t(1), maxLevels);
+            LOG_ERROR("Invalid atlas mip level count {}, using {}", options.mipLevels, levels);
+            options.mipLevels = levels;
+        }
+        return options;
+    }
+}
+
+RectPacker::RectPacker(size_t width, size_t height, Method method)
+    : width_(width)
+    , height_(height)
+    , method_(method)
+{
+    clear();
+}
+
+std::optional<RectPacker::Rect> RectPacker::insert(size_t width, size_t height)
+{
+    if (width == 0 || height == 0 || width > width_ || height > height_)
+        return std::nullopt;
+    const auto rect
+        = method_ == Method::Skyline ? insertSkyline(width, height) : insertMaxRects(width, height);
+    if (rect)
+        usedArea_ += width * height;
+    return rect;
+}
+
+void RectPacker::clear()
+{
+    usedArea_ = 0;
+    skyline_.clear();
+    freeRects_.clear();
+    if (method_ == Method::Skyline)
+        skyline_.push_back(SkylineNode { 0, 0, width_ });
+    else
+        freeRects_.push_back(Rect { 0, 0, width_, height_ });
+}
+
+size_t RectPacker::getWidth() const
+{
+    return width_;
+}
+
+size_t RectPacker::getHeight() const
+{
+    return height_;
+}
+
+float RectPacker::getOccupancy() const
+{
+    return static_cast<float>(usedArea_) / static_cast<float>(width_ * height_);
+}
+
+std::optional<size_t> RectPacker::fitSkyline(size_t index, size_t width, size_t height) const
+{
+    if (skyline_[index].x + width > width_)
+        return std::nullopt;
+    // The rectangle has to sit on the highest node it spans
+    size_t y = 0;
+    size_t covered = 0;
+    for (auto i = index; covered < width; ++i) {
+        assert(i < skyline_.size());
+        y = std::max(y, skyline_[i].y);
+        if (y + height > height_)
+            return std::nullopt;
+        covered += skyline_[i].width;
+    }
+    return y;
+}
+
+std::optional<RectPacker::Rect> RectPacker::insertSkyline(size_t width, size_t height)
+{
+    // The lowest top edge wins and of those the one on the narrowest node, so gaps get filled
+    auto bestTop = std::numeric_limits<size_t>::max();
+    auto bestWidth = std::numeric_limits<size_t>::max();
+    auto bestIndex = skyline_.size();
+    size_t bestY = 0;
+    for (size_t i = 0; i < skyline_.size(); ++i) {
+        const auto y = fitSkyline(i, width, height);
+        if (!y)
+            continue;
+        const auto top = *y + height;
+        if (top < bestTop || (top == bestTop && skyline_[i].width < bestWidth)) {
+            bestTop = top;
+            bestWidth = skyline_[i].width;
+            bestIndex = i;
+            bestY = *y;
+        }
+    }
+    if (bestIndex == skyline_.size())
+        return std::nullopt;
+
+    const Rect rect { skyline_[bestIndex].x, bestY, width, height };
+    skyline_.insert(skyline_.begin() + bestIndex, SkylineNode { rect.x, bestTop, width });
+
+    // Cut the nodes that are now below the new one
+    for (auto i = bestIndex + 1; i < skyline_.size();) {
+        const auto& prev = skyline_[i - 1];
+        const auto prevEnd = prev.x + prev.width;
+        if (skyline_[i].x >= prevEnd)
+            break;
+        const auto shrink = prevEnd - skyline_[i].x;
+        if (skyline_[i].width <= shrink) {
+            skyline_.erase(skyline_.begin() + i);
+        } else {
+            skyline_[i].x += shrink;
+            skyline_[i].width -= shrink;
+            break;
+        }
+    }
+
+    // Merge neighbours of the same height
+    for (size_t i = 0; i + 1 < skyline_.size();) {
+        if (skyline_[i].y == skyline_[i + 1].y) {
+            skyline_[i].width += skyline_[i + 1].width;
+            skyline_.erase(skyline_.begin() + i + 1);
+        } else {
+            ++i;
+        }
+    }
+    return rect;
+}
+
+// Jukka Jylänki, "A Thousand Ways to Pack the Bin"
+std::optional<RectPacker::Rect> RectPacker::insertMaxRects(size_t width, size_t height)
+{
+    auto bestShortSide = std::numeric_limits<size_t>::max();
+    auto bestLongSide = std::numeric_limits<size_t>::max();
+    std::optional<Rect> best;
+    for (const auto& free : freeRects_) {
+        if (free.width < width || free.height < height)
+            continue;
+        const auto dx = free.width - width, dy = free.height - height;
+        const auto shortSide = std::min(dx, dy), longSide = std::max(dx, dy);
+        if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide)) {
+            bestShortSide = shortSide;
+            bestLongSide = longSide;
+            best = Rect { free.x, free.y, width, height };
+        }
+    }
+    if (!best)
+        return std::nullopt;
+    splitFreeRects(*best);
+    pruneFreeRects();
+    return best;
+}
+
+void RectPacker::splitFreeRects(const Rect& used)
+{
+    // Every free rectangle that overlaps the new one is replaced by the (up to 4) maximal
+    // rectangles around it
+    const auto count = freeRects_.size();
+    for (size_t i = 0; i < count; ++i) {
+        const auto free = freeRects_[i];
+        if (!intersects(free, used))
+            continue;
+        if (used.x > free.x)
+            freeRects_.push_back(Rect { free.x, free.y, used.x - free.x, free.height });
+        if (used.x + used.width < free.x + free.width)
+            freeRects_.push_back(Rect { used.x + used.width, free.y,
+                free.x + free.width - (used.x + used.width), free.height });
+        if (used.y > free.y)
+            freeRects_.push_back(Rect { free.x, free.y, free.width, used.y - free.y });
+        if (used.y + used.height < free.y + free.height)
+            freeRects_.push_back(Rect { free.x, used.y + used.height, free.width,
+                free.y + free.height - (used.y + used.height) });
+        // Mark it for removal
+        freeRects_[i].width = 0;
+    }
+    freeRects_.erase(std::remove_if(freeRects_.begin(), freeRects_.end(),
+                         [](const Rect& r) { return r.width == 0; }),
+        freeRects_.end());
+}
+
+void RectPacker::pruneFreeRects()
+{
+    for (size_t i = 0; i < freeRects_.size(); ++i) {
+        for (size_t j = i + 1; j < freeRects_.size();) {
+            if (contains(freeRects_[i], freeRects_[j])) {
+                freeRects_.erase(freeRects_.begin() + j);
+            } else if (contains(freeRects_[j], freeRects_[i])) {
+                freeRects_.erase(freeRects_.begin() + i);
+                --i;
+                break;
+            } else {
+                ++j;
+            }
+        }
+    }
+}
+
+glm::vec2 TextureAtlas::Region::getSize() const
+{
+    return glm::vec2(static_cast<float>(width), static_cast<float>(height));
+}
+
+TextureAtlas::TextureAtlas()
+    : TextureAtlas(Options {})
+{
+}
+
+TextureAtlas::TextureAtlas(const Options& options)
+    : options_(validate(options))
+    , alignment_(size_t(1) << (options_.mipLevels - 1))
+    , padding_(options_.padding * alignment_)
+{
+}
+
+std::optional<TextureAtlas::Region> TextureAtlas::add(
+    const uint8_t* data, size_t width, size_t height, size_t channels)
+{
+    assert(channels >= 1 && channels <= 4);
+    if (width == 0 || height == 0) {
+        LOG_ERROR("Can't add an empty image ({}x{}) to an atlas", width, height);
+        return std::nullopt;
+    }
+    const auto cellsX = (width + 2 * padding_ + alignment_ - 1) / alignment_;
+    const auto cellsY = (height + 2 * padding_ + alignment_ - 1) / alignment_;
+    if (cellsX > options_.pageWidth / alignment_ || cellsY > options_.pageHeight / alignment_) {
+        LOG_ERROR("Image of size {}x{} does not fit into an atlas page of size {}x{}", width,
+            height, options_.pageWidth, options_.pageHeight);
+        return std::nullopt;
+    }
+
+    size_t pageIndex = 0;
+    std::optional<RectPacker::Rect> rect;
+    while (pageIndex < pages_.size()) {
+        rect = pages_[pageIndex]->packer.insert(cellsX, cellsY);
+        if (rect)
+            break;
+        ++pageIndex;
+    }
+    if (!rect) {
+        rect = addPage().packer.insert(cellsX, cellsY);
+        assert(rect);
+    }
+    auto& page = *pages_[pageIndex];
+
+    // Fill the whole cell, not just the padding, so the lower mip levels of the cell only
+    // contain this image
+    const auto cellWidth = cellsX * alignment_, cellHeight = cellsY * alignment_;
+    std::vector<uint8_t> texels(cellWidth * cellHeight * 4);
+    const auto clampToImage = [this](size_t v, size_t size) {
+        return std::min(v > padding_ ? v - padding_ : 0, size - 1);
+    };
+    for (size_t y = 0; y < cellHeight; ++y) {
+        const auto srcY = clampToImage(y, height);
+        for (size_t x = 0; x < cellWidth; ++x) {
+            const auto srcX = clampToImage(x, width);
+            const auto texel = readTexelRgba(data + (srcY * width + srcX) * channels, channels);
+            std::copy(texel.begin(), texel.end(), texels.data() + (y * cellWidth + x) * 4);
+        }
+    }
+    page.texture.subImage(Texture::Target::Texture2D, 0, rect->x * alignment_,
+        rect->y * alignment_, cellWidth, cellHeight, Texture::DataFormat::Rgba,
+        Texture::DataType::U8, texels.data());
+    page.dirty = true;
+
+    Region region;
+    region.texture = &page.texture;
+    region.page = pageIndex;
+    region.x = rect->x * alignment_ + padding_;
+    region.y = rect->y * alignment_ + padding_;
+    region.width = width;
+    region.height = height;
+    const auto pageSize = glm::vec2(
+        static_cast<float>(options_.pageWidth), static_cast<float>(options_.pageHeight));
+    region.region.position
+        = glm::vec2(static_cast<float>(region.x), static_cast<float>(region.y)) / pageSize;
+    region.region.size = region.getSize() / pageSize;
+    return region;
+}
+
+std::optional<TextureAtlas::Region> TextureAtlas::add(const std::filesystem::path& path)
+{
+    // The pages are RGBA anyway and this way stb_image expands gray + alpha images properly
+    int width = 0, height = 0, channels = 0;
+    const auto image = stbi_load(
+        reinterpret_cast<const char*>(path.u8string().c_str()), &width, &height, &channels, 4);
+    if (!image) {
+        LOG_ERROR("Could not load image from file: {}", stbi_failure_reason());
+        return std::nullopt;
+    }
+    const auto region = add(image, width, height, 4);
+    stbi_image_free(image);
+    return region;
+}
+
+void TextureAtlas::generateMipmaps()
+{
+    for (auto& page : pages_) {
+        if (page->dirty && options_.mipLevels > 1)
+            page->texture.generateMipmaps();
+        page->dirty = false;
+    }
+}
+
+void TextureAtlas::clear()
+{
+    for (auto& page : pages_)
+        page->packer.clear();
+}
+
+size_t TextureAtlas::getPageCount() const
+{
+    return pages_.size();
+}
+
+const glw::Texture& TextureAtlas::getTexture(size_t page) const
+{
+    assert(page < pages_.size());
+    return pages_[page]->texture;
+}
+
+float TextureAtlas::getOccupancy() const
+{
+    if (pages_.empty())
+        return 0.0f;
+    float sum = 0.0f;
+    for (const auto& page : pages_)
+        sum += page->packer.getOccupancy();
+    return sum / static_cast<float>(pages_.size());
+}
+
+TextureAtlas::Page& TextureAtlas::addPage()
+{
+    auto page = std::make_unique<Page>(Page {
+        Texture(Texture::Target::Texture2D),
+        RectPacker(options_.pageWidth / alignment_, options_.pageHeight / alignment_,
+            options_.method),
+    });
+    // The texels between the images are never sampled, so the pages are not cleared
+    page->texture.storage(options_.mipLevels,
+        options_.srgb ? ImageFormat::Srgb8Alpha8 : ImageFormat::Rgba8, options_.pageWidth,
+        options_.pageHeight);
+    if (options_.mipLevels > 1)
+        page->texture.setFilter(
+            Texture::MinFilter::LinearMipmapNearest, Texture::MagFilter::Linear);
+    else
+        page->texture.setFilter(Texture::MinFilter::Linear, Texture::MagFilter::Linear);
+    page->texture.setWrap(Texture::WrapMode::ClampToEdge);
+    pages_.push_back(std::move(page));
+    return *pages_.back();
+}
+}
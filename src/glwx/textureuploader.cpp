@@ -0,0 +1,224 @@
+#include "glwx/textureuploader.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "glw/log.hpp"
+
+using namespace glw;
+
+namespace glwx {
+TextureUploader::TextureUploader(size_t poolSize, bool workerThread)
+{
+    assert(poolSize > 0);
+    for (size_t i = 0; i < poolSize; ++i)
+        slots_.push_back(std::make_unique<Slot>());
+    if (workerThread)
+        worker_ = std::thread(&TextureUploader::workerMain, this);
+}
+
+TextureUploader::~TextureUploader()
+{
+    if (worker_.joinable()) {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        jobsCondition_.notify_all();
+        worker_.join();
+    }
+    // Buffers that are still mapped are unmapped implicitly when they are deleted
+}
+
+TextureUploader::Ticket TextureUploader::upload(const Texture& texture, Texture::Target target,
+    size_t level, size_t x, size_t y, size_t width, size_t height, Texture::DataFormat dataFormat,
+    Texture::DataType dataType, std::vector<uint8_t> pixels)
+{
+    const auto rowSize = width * Texture::getPixelSize(dataFormat, dataType);
+    assert(pixels.size() >= rowSize * height);
+    auto fill = [pixels = std::move(pixels), rowSize, height](uint8_t* dst, size_t rowPitch) {
+        if (rowPitch == rowSize) {
+            std::memcpy(dst, pixels.data(), rowSize * height);
+            return;
+        }
+        for (size_t row = 0; row < height; ++row)
+            std::memcpy(dst + row * rowPitch, pixels.data() + row * rowSize, rowSize);
+    };
+    return upload(texture, target, level, x, y, width, height, dataFormat, dataType,
+        FillFunc(std::move(fill)));
+}
+
+TextureUploader::Ticket TextureUploader::upload(const Texture& texture,
+    Texture::DataFormat dataFormat, Texture::DataType dataType, std::vector<uint8_t> pixels)
+{
+    return upload(texture, texture.getTarget(), 0, 0, 0, texture.getWidth(), texture.getHeight(),
+        dataFormat, dataType, std::move(pixels));
+}
+
+TextureUploader::Ticket TextureUploader::upload(const Texture& texture, Texture::Target target,
+    size_t level, size_t x, size_t y, size_t width, size_t height, Texture::DataFormat dataFormat,
+    Texture::DataType dataType, FillFunc fill)
+{
+    const auto rowSize = width * Texture::getPixelSize(dataFormat, dataType);
+    const auto rowPitch = (rowSize + unpackAlignment - 1) / unpackAlignment * unpackAlignment;
+    const auto ticket = nextTicket_++;
+    std::lock_guard lock(mutex_);
+    queue_.push_back(Upload { ticket, &texture, target, level, x, y, width, height, dataFormat,
+        dataType, rowPitch, rowPitch * height, std::move(fill) });
+    return ticket;
+}
+
+void TextureUploader::update()
+{
+    // The mutex is only held to look at or change the slot status and the jobs, so the worker can
+    // keep copying while the GL calls are made. Slots only leave Copied, InFlight and Free on this
+    // thread, so the snapshot stays valid for those.
+    std::vector<Slot::Status> status(slots_.size());
+    {
+        std::lock_guard lock(mutex_);
+        for (size_t i = 0; i < slots_.size(); ++i)
+            status[i] = slots_[i]->status;
+    }
+
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        auto& slot = *slots_[i];
+        if (status[i] == Slot::Status::InFlight && slot.fence.isSignaled()) {
+            slot.fence.free();
+            std::lock_guard lock(mutex_);
+            slot.status = status[i] = Slot::Status::Free;
+        } else if (status[i] == Slot::Status::Copied) {
+            submit(slot);
+            status[i] = Slot::Status::InFlight;
+        }
+    }
+
+    for (size_t i = 0; i < slots_.size() && !queue_.empty(); ++i) {
+        if (status[i] != Slot::Status::Free)
+            continue;
+        auto& slot = *slots_[i];
+        {
+            std::lock_guard lock(mutex_);
+            slot.upload = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        // Only ever grow the buffers. If the buffer is big enough, we can just map it, because the
+        // fence of its last upload is signaled already.
+        if (slot.buffer.getSize() < slot.upload.size)
+            slot.buffer.data(Buffer::Target::PixelUnpack, Buffer::UsageHint::StreamDraw,
+                static_cast<const void*>(nullptr), slot.upload.size);
+        constexpr GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+        slot.mapped = static_cast<uint8_t*>(
+            slot.buffer.map(Buffer::Target::PixelUnpack, 0, slot.upload.size, access));
+        if (!slot.mapped) {
+            // Don't drop the upload, but do it the slow way. The slot stays free.
+            LOG_WARNING("Could not map texture staging buffer, uploading from client memory");
+            uploadDirect(slot.upload);
+            slot.upload = Upload {};
+            continue;
+        }
+
+        if (worker_.joinable()) {
+            {
+                std::lock_guard lock(mutex_);
+                slot.status = Slot::Status::Copying;
+                jobs_.push_back(&slot);
+            }
+            jobsCondition_.notify_one();
+        } else {
+            slot.upload.fill(slot.mapped, slot.upload.rowPitch);
+            submit(slot);
+        }
+        status[i] = Slot::Status::InFlight;
+    }
+}
+
+void TextureUploader::finish()
+{
+    while (getPendingCount() > 0) {
+        update();
+        std::this_thread::yield();
+    }
+    // Wait for the GPU too, so everything is actually uploaded
+    for (auto& slot : slots_)
+        slot->fence.wait();
+}
+
+bool TextureUploader::isDone(Ticket ticket) const
+{
+    if (ticket == 0 || ticket >= nextTicket_)
+        return false;
+    std::lock_guard lock(mutex_);
+    for (const auto& upload : queue_)
+        if (upload.ticket == ticket)
+            return false;
+    for (const auto& slot : slots_)
+        if (slot->status != Slot::Status::Free && slot->status != Slot::Status::InFlight
+            && slot->upload.ticket == ticket)
+            return false;
+    return true;
+}
+
+size_t TextureUploader::getPendingCount() const
+{
+    std::lock_guard lock(mutex_);
+    const auto copying = std::count_if(slots_.begin(), slots_.end(), [](const auto& slot) {
+        return slot->status == Slot::Status::Copying || slot->status == Slot::Status::Copied;
+    });
+    return queue_.size() + static_cast<size_t>(copying);
+}
+
+void TextureUploader::submit(Slot& slot)
+{
+    assert(slot.mapped);
+    if (!slot.buffer.unmap(Buffer::Target::PixelUnpack))
+        LOG_ERROR("Texture staging buffer was corrupted while mapped");
+    slot.mapped = nullptr;
+
+    const auto& upload = slot.upload;
+    slot.buffer.bind(Buffer::Target::PixelUnpack);
+    // Someone else might have changed it and rowPitch depends on it
+    glPixelStorei(GL_UNPACK_ALIGNMENT, static_cast<GLint>(unpackAlignment));
+    // With a PixelUnpack buffer bound, the data pointer is an offset into that buffer
+    upload.texture->subImage(upload.target, upload.level, upload.x, upload.y, upload.width,
+        upload.height, upload.dataFormat, upload.dataType, nullptr);
+    // Unbind, so uploads from client memory work as expected
+    Buffer::unbind(Buffer::Target::PixelUnpack);
+    slot.fence.insert();
+
+    // Free the pixels early
+    slot.upload.fill = nullptr;
+    std::lock_guard lock(mutex_);
+    slot.status = Slot::Status::InFlight;
+}
+
+void TextureUploader::uploadDirect(const Upload& upload)
+{
+    std::vector<uint8_t> pixels(upload.size);
+    upload.fill(pixels.data(), upload.rowPitch);
+    // With a PixelUnpack buffer bound (by anyone), the pointer would be taken as an offset
+    Buffer::unbind(Buffer::Target::PixelUnpack);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, static_cast<GLint>(unpackAlignment));
+    upload.texture->subImage(upload.target, upload.level, upload.x, upload.y, upload.width,
+        upload.height, upload.dataFormat, upload.dataType, pixels.data());
+}
+
+void TextureUploader::workerMain()
+{
+    while (true) {
+        std::unique_lock lock(mutex_);
+        jobsCondition_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+        if (stop_)
+            return;
+        auto slot = jobs_.front();
+        jobs_.pop_front();
+        lock.unlock();
+
+        slot->upload.fill(slot->mapped, slot->upload.rowPitch);
+
+        lock.lock();
+        slot->status = Slot::Status::Copied;
+    }
+}
+}
@@ -0,0 +1,107 @@
+#include "glwx/uniformbuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "glw/state.hpp"
+
+using namespace glw;
+
+namespace glwx {
+Std140Writer::Std140Writer(size_t size)
+{
+    resize(size);
+}
+
+void Std140Writer::beginStruct()
+{
+    alignTo(16);
+}
+
+void Std140Writer::endStruct()
+{
+    // The member after a struct is aligned to 16 as well
+    alignTo(16);
+}
+
+const uint8_t* Std140Writer::getData() const
+{
+    return data_.data();
+}
+
+size_t Std140Writer::getSize() const
+{
+    return data_.size();
+}
+
+void Std140Writer::clear()
+{
+    data_.clear();
+    end_ = 0;
+}
+
+size_t Std140Writer::alignTo(size_t alignment)
+{
+    const auto offset = (end_ + alignment - 1) / alignment * alignment;
+    resize(offset);
+    return offset;
+}
+
+void Std140Writer::resize(size_t size)
+{
+    end_ = std::max(end_, size);
+    const auto padded = (end_ + 15) / 16 * 16;
+    if (padded > data_.size())
+        data_.resize(padded, 0);
+}
+
+namespace {
+    size_t getUniformBufferOffsetAlignment()
+    {
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        // The spec says it's at most 256, so we fall back to that if the query goes wrong
+        return alignment > 0 ? static_cast<size_t>(alignment) : 256;
+    }
+}
+
+UniformBufferRing::UniformBufferRing(size_t size)
+    : buffer_(size)
+    , offsetAlignment_(getUniformBufferOffsetAlignment())
+{
+}
+
+std::optional<size_t> UniformBufferRing::bind(
+    unsigned int binding, const void* data, size_t size)
+{
+    const auto alloc = buffer_.map(size, offsetAlignment_);
+    // StreamBuffer logs this already. Binding the range anyway would make the draw use whatever
+    // happens to be in there.
+    if (!alloc.data)
+        return std::nullopt;
+    std::memcpy(alloc.data, data, size);
+    buffer_.unmap();
+    buffer_.getBuffer().bindRange(Buffer::Target::Uniform, binding, alloc.offset, size);
+    return alloc.offset;
+}
+
+std::optional<size_t> UniformBufferRing::bind(unsigned int binding, const Std140Writer& writer)
+{
+    return bind(binding, writer.getData(), writer.getSize());
+}
+
+void UniformBufferRing::fence()
+{
+    buffer_.fence();
+}
+
+const StreamBuffer& UniformBufferRing::getStreamBuffer() const
+{
+    return buffer_;
+}
+
+size_t UniformBufferRing::getOffsetAlignment() const
+{
+    return offsetAlignment_;
+}
+}
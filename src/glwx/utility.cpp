@@ -1,6 +1,7 @@
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
+#include <random>
 #include <sstream>
 #include <string>
 
@@ -22,6 +23,26 @@ std::optional<std::string> readFile(const std::filesystem::path& filename)
     return contents;
 }
 
+std::filesystem::path getTempPath(const std::filesystem::path& path)
+{
+    static thread_local std::mt19937_64 rng(std::random_device {}());
+    std::stringstream ss;
+    ss << "." << std::hex << std::setfill('0') << std::setw(16) << rng() << ".tmp";
+    auto tmpPath = path;
+    tmpPath += ss.str();
+    return tmpPath;
+}
+
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size)
+{
+    const auto bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
 std::string toHexStream(const uint8_t* buffer, size_t size)
 {
     std::stringstream ss;
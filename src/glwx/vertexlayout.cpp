@@ -0,0 +1,98 @@
+#include "glwx/vertexlayout.hpp"
+
+#include <algorithm>
+
+using namespace glw;
+
+namespace glwx {
+namespace {
+    bool isFloatAttributeType(AttributeInfo::Type type)
+    {
+        using T = AttributeInfo::Type;
+        switch (type) {
+        case T::Int:
+        case T::IVec2:
+        case T::IVec3:
+        case T::IVec4:
+        case T::UInt:
+        case T::UVec2:
+        case T::UVec3:
+        case T::UVec4:
+        case T::Double:
+            return false;
+        default:
+            return true;
+        }
+    }
+}
+
+bool validateVertexFormat(const VertexFormat& vfmt, const ShaderProgram& program)
+{
+    bool valid = true;
+    std::vector<size_t> usedLocations;
+    for (const auto& [name, info] : program.getAttributeInfo()) {
+        if (info.location < 0)
+            continue;
+        const auto locationCount = getAttributeLocationCount(info.type) * info.size;
+        const auto components = getAttributeComponentCount(info.type);
+        for (size_t i = 0; i < locationCount; ++i) {
+            const auto location = static_cast<size_t>(info.location) + i;
+            usedLocations.push_back(location);
+            const auto attr = vfmt.get(location);
+            if (!attr) {
+                LOG_ERROR("Attribute '{}' (location {}) is not provided by the vertex format",
+                    name, location);
+                valid = false;
+                continue;
+            }
+            if (!isFloatAttributeType(info.type)) {
+                LOG_ERROR("Attribute '{}' (location {}) is not a float attribute, but the vertex "
+                          "format can only provide floats",
+                    name, location);
+                valid = false;
+            }
+            if (attr->components > components) {
+                LOG_WARNING("Vertex format provides {} components for attribute '{}' (location "
+                            "{}), which only has {}",
+                    attr->components, name, location, components);
+            }
+        }
+    }
+
+    for (const auto& attr : vfmt.getAttributes()) {
+        if (std::find(usedLocations.begin(), usedLocations.end(), attr.location)
+            == usedLocations.end())
+            LOG_WARNING("Vertex format provides location {}, which is not used", attr.location);
+    }
+    return valid;
+}
+
+std::optional<VertexFormat> makeVertexFormat(
+    const ShaderProgram& program, const std::vector<NamedAttribute>& attrs)
+{
+    const auto& infos = program.getAttributeInfo();
+    VertexFormat vfmt;
+    size_t stride = 0;
+    for (const auto& attr : attrs) {
+        // Same as VertexFormat::add, but we have to track the stride ourselves, because not all
+        // attributes end up in the format.
+        const auto offset = attr.offset == static_cast<size_t>(-1) ? stride : attr.offset;
+        auto formatAttr = VertexFormat::Attribute {
+            0, attr.components, attr.dataType, attr.normalized, attr.divisor, offset };
+        stride = std::max(stride, offset + formatAttr.getAlignedSize());
+
+        const auto it = infos.find(attr.name);
+        if (it == infos.end() || it->second.location < 0) {
+            LOG_DEBUG("Attribute '{}' is not active in the program", attr.name);
+            continue;
+        }
+        formatAttr.location = static_cast<size_t>(it->second.location);
+        vfmt.add(formatAttr);
+    }
+    vfmt.setStride(stride);
+
+    if (!validateVertexFormat(vfmt, program))
+        return std::nullopt;
+    return vfmt;
+}
+}
@@ -103,6 +103,55 @@ bool initSubSystem(uint32_t flags)
     return true;
 }
 
+SharedContext::SharedContext(SDL_Window* window, SDL_GLContext glContext)
+    : window_(window)
+    , glContext_(glContext)
+    , state_(std::make_unique<glw::State>())
+{
+}
+
+SharedContext::~SharedContext()
+{
+    if (glContext_)
+        SDL_GL_DeleteContext(glContext_);
+}
+
+SharedContext::SharedContext(SharedContext&& other)
+    : window_(other.window_)
+    , glContext_(other.glContext_)
+    , state_(std::move(other.state_))
+{
+    other.window_ = nullptr;
+    other.glContext_ = nullptr;
+}
+
+bool SharedContext::makeCurrent() const
+{
+    if (SDL_GL_MakeCurrent(window_, glContext_) < 0) {
+        LOG_ERROR("SDL_GL_MakeCurrent failed: {}", SDL_GetError());
+        return false;
+    }
+    glw::State::setCurrent(state_.get());
+    return true;
+}
+
+void SharedContext::release() const
+{
+    SDL_GL_MakeCurrent(window_, nullptr);
+    if (glw::State::getCurrent() == state_.get())
+        glw::State::setCurrent(nullptr);
+}
+
+glw::State& SharedContext::getState() const
+{
+    return *state_;
+}
+
+SDL_GLContext SharedContext::getSdlGlContext() const
+{
+    return glContext_;
+}
+
 Window::~Window()
 {
     if (glContext_)
@@ -114,6 +163,7 @@ Window::~Window()
 Window::Window(Window&& other)
     : window_(other.window_)
     , glContext_(other.glContext_)
+    , state_(std::move(other.state_))
 {
     other.window_ = nullptr;
     other.glContext_ = nullptr;
@@ -123,6 +173,7 @@ Window& Window::operator=(Window&& other)
 {
     window_ = other.window_;
     glContext_ = other.glContext_;
+    state_ = std::move(other.state_);
     other.window_ = nullptr;
     other.glContext_ = nullptr;
     return *this;
@@ -189,6 +240,9 @@ bool Window::init(
         LOG_CRITICAL("SDL_GL_CreateContext failed! - '%s'\n", SDL_GetError());
         return false;
     }
+    // SDL_GL_CreateContext makes the context current
+    state_ = std::make_unique<glw::State>();
+    glw::State::setCurrent(state_.get());
 
     if (!initGladOnce()) {
         LOG_CRITICAL("Could not initialize GLAD");
@@ -239,6 +293,35 @@ SDL_GLContext Window::getSdlGlContext() const
     return glContext_;
 }
 
+bool Window::makeCurrent() const
+{
+    if (SDL_GL_MakeCurrent(window_, glContext_) < 0) {
+        LOG_ERROR("SDL_GL_MakeCurrent failed: {}", SDL_GetError());
+        return false;
+    }
+    glw::State::setCurrent(state_.get());
+    return true;
+}
+
+glw::State& Window::getState() const
+{
+    return *state_;
+}
+
+std::optional<SharedContext> Window::createSharedContext() const
+{
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+    const auto glContext = SDL_GL_CreateContext(window_);
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+    // SDL_GL_CreateContext makes the new context current, so we have to switch back
+    makeCurrent();
+    if (!glContext) {
+        LOG_ERROR("Could not create shared context: {}", SDL_GetError());
+        return std::nullopt;
+    }
+    return SharedContext(window_, glContext);
+}
+
 float getTime()
 {
     if (!initSubSystem(SDL_INIT_TIMER))
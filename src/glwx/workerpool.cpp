@@ -0,0 +1,95 @@
+#include "glwx/workerpool.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace glwx {
+size_t WorkerPool::getDefaultThreadCount()
+{
+    return std::max(1u, std::thread::hardware_concurrency()) - 1;
+}
+
+WorkerPool::WorkerPool(size_t threads)
+{
+    for (size_t i = 0; i < threads; ++i)
+        workers_.emplace_back(&WorkerPool::workerMain, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    batchCondition_.notify_all();
+    for (auto& worker : workers_)
+        worker.join();
+}
+
+void WorkerPool::parallelFor(size_t count, size_t chunkSize, const RangeFunc& func)
+{
+    assert(chunkSize > 0);
+    const auto chunks = (count + chunkSize - 1) / chunkSize;
+    if (workers_.empty() || chunks <= 1) {
+        func(0, count);
+        return;
+    }
+
+    Batch batch { &func, count, chunkSize, chunks };
+    {
+        std::lock_guard lock(mutex_);
+        batches_.push_back(&batch);
+    }
+    batchCondition_.notify_all();
+    while (runChunk(batch)) { }
+
+    std::unique_lock lock(mutex_);
+    // Workers that pick up the batch from now on would not find any chunks anyways
+    const auto it = std::find(batches_.begin(), batches_.end(), &batch);
+    if (it != batches_.end())
+        batches_.erase(it);
+    // Wait until the workers that are still running a chunk (or just looking at the batch) are
+    // done with it, so it's safe to destroy it.
+    doneCondition_.wait(
+        lock, [&batch] { return batch.finished == batch.chunks && batch.users == 0; });
+}
+
+bool WorkerPool::runChunk(Batch& batch)
+{
+    const auto chunk = batch.next.fetch_add(1);
+    if (chunk >= batch.chunks)
+        return false;
+    const auto begin = chunk * batch.chunkSize;
+    (*batch.func)(begin, std::min(begin + batch.chunkSize, batch.count));
+    std::lock_guard lock(mutex_);
+    batch.finished++;
+    return true;
+}
+
+void WorkerPool::workerMain()
+{
+    while (true) {
+        std::unique_lock lock(mutex_);
+        batchCondition_.wait(lock, [this] { return stop_ || !batches_.empty(); });
+        if (stop_)
+            return;
+        auto batch = batches_.front();
+        batch->users++;
+        lock.unlock();
+
+        const auto ran = runChunk(*batch);
+
+        lock.lock();
+        batch->users--;
+        if (!ran && !batches_.empty() && batches_.front() == batch)
+            batches_.pop_front();
+        if (batch->finished == batch->chunks && batch->users == 0)
+            doneCondition_.notify_all();
+    }
+}
+
+size_t WorkerPool::getThreadCount() const
+{
+    return workers_.size();
+}
+}
@@ -16,4 +16,73 @@ bool hasStencil(ImageFormat format)
         || format == ImageFormat::Stencil16 || format == ImageFormat::DepthStencil
         || format == ImageFormat::Depth24Stencil8 || format == ImageFormat::Depth32FStencil8;
 }
+
+ImageFormat getSizedFormat(ImageFormat format)
+{
+    switch (format) {
+    case ImageFormat::Red:
+        return ImageFormat::R8;
+    case ImageFormat::Rg:
+        return ImageFormat::Rg8;
+    case ImageFormat::Rgb:
+        return ImageFormat::Rgb8;
+    case ImageFormat::Rgba:
+        return ImageFormat::Rgba8;
+    case ImageFormat::Depth:
+        return ImageFormat::Depth24;
+    case ImageFormat::Stencil:
+        return ImageFormat::Stencil8;
+    case ImageFormat::DepthStencil:
+        return ImageFormat::Depth24Stencil8;
+    default:
+        return format;
+    }
+}
+
+size_t getCompressedBlockSize(ImageFormat format)
+{
+    switch (format) {
+    case ImageFormat::CompressedRedRgtc1:
+    case ImageFormat::CompressedSignedRedRgtc1:
+    case ImageFormat::CompressedRgbS3tcDxt1:
+    case ImageFormat::CompressedRgbaS3tcDxt1:
+    case ImageFormat::CompressedSrgbS3tcDxt1:
+    case ImageFormat::CompressedSrgbAlphaS3tcDxt1:
+        return 8;
+    case ImageFormat::CompressedRgRgtc2:
+    case ImageFormat::CompressedSignedRgRgtc2:
+    case ImageFormat::CompressedRgbaS3tcDxt3:
+    case ImageFormat::CompressedRgbaS3tcDxt5:
+    case ImageFormat::CompressedSrgbAlphaS3tcDxt3:
+    case ImageFormat::CompressedSrgbAlphaS3tcDxt5:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+size_t getCompressedImageSize(ImageFormat format, size_t width, size_t height)
+{
+    // Partial blocks at the edges (and levels smaller than a block) still take up a whole block
+    return ((width + 3) / 4) * ((height + 3) / 4) * getCompressedBlockSize(format);
+}
+
+bool isCompressedFormatSupported(ImageFormat format)
+{
+    switch (format) {
+    case ImageFormat::CompressedRgbS3tcDxt1:
+    case ImageFormat::CompressedRgbaS3tcDxt1:
+    case ImageFormat::CompressedRgbaS3tcDxt3:
+    case ImageFormat::CompressedRgbaS3tcDxt5:
+        return GLAD_GL_EXT_texture_compression_s3tc;
+    case ImageFormat::CompressedSrgbS3tcDxt1:
+    case ImageFormat::CompressedSrgbAlphaS3tcDxt1:
+    case ImageFormat::CompressedSrgbAlphaS3tcDxt3:
+    case ImageFormat::CompressedSrgbAlphaS3tcDxt5:
+        return GLAD_GL_EXT_texture_compression_s3tc && GLAD_GL_EXT_texture_sRGB;
+    default:
+        // RGTC is core since 3.0
+        return true;
+    }
+}
 }
@@ -0,0 +1,1391 @@
+#include "glw/mockgl.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "glw/texture.hpp"
+
+namespace glw::mock {
+namespace {
+    struct Variable {
+        std::string name;
+        GLint size;
+        GLenum type;
+    };
+
+    struct ShaderInfo {
+        GLenum type = 0;
+        std::vector<Variable> uniforms;
+        std::vector<Variable> attributes;
+    };
+
+    struct ProgramInfo {
+        std::vector<GLuint> shaders;
+        // Filled from the attached shaders when the program is linked
+        std::vector<Variable> uniforms;
+        std::vector<Variable> attributes;
+    };
+
+    struct Context {
+        std::map<std::string_view, CallStats> calls;
+        GLuint nextName = 1;
+        std::unordered_set<GLuint> objects;
+        std::unordered_map<GLuint, std::vector<uint8_t>> bufferData;
+        std::unordered_map<GLenum, GLuint> buffers;
+        std::map<std::tuple<unsigned int, GLenum>, GLuint> textures;
+        std::unordered_map<GLenum, GLuint> framebuffers;
+        unsigned int activeTexture = 0;
+        GLuint vertexArray = 0;
+        GLuint program = 0;
+        std::unordered_map<GLuint, ShaderInfo> shaders;
+        std::unordered_map<GLuint, ProgramInfo> programs;
+        // (program, name) -> location, handed out in order of lookup
+        std::map<std::tuple<GLuint, std::string>, GLint> locations;
+        uintptr_t nextSync = 1;
+        bool programBinary = false;
+    };
+
+    Context& ctx()
+    {
+        static Context context;
+        return context;
+    }
+
+    void record(std::string_view entryPoint, size_t bytes = 0)
+    {
+        auto& stats = ctx().calls[entryPoint];
+        stats.calls++;
+        stats.bytes += bytes;
+    }
+
+    GLuint genName()
+    {
+        const auto name = ctx().nextName++;
+        ctx().objects.insert(name);
+        return name;
+    }
+
+    void genNames(GLsizei n, GLuint* names)
+    {
+        for (GLsizei i = 0; i < n; ++i)
+            names[i] = genName();
+    }
+
+    void deleteNames(GLsizei n, const GLuint* names)
+    {
+        for (GLsizei i = 0; i < n; ++i)
+            ctx().objects.erase(names[i]);
+    }
+
+    GLint getLocation(GLuint program, const GLchar* name)
+    {
+        auto& locations = ctx().locations;
+        const auto key = std::tuple(program, std::string(name));
+        const auto it = locations.find(key);
+        if (it != locations.end())
+            return it->second;
+        const auto loc = static_cast<GLint>(locations.size());
+        locations.emplace(key, loc);
+        return loc;
+    }
+
+    // Identifiers, numbers and single punctuation characters. Comments and preprocessor lines are
+    // dropped (so code in #if 0 is not, but that doesn't matter much here).
+    std::vector<std::string> tokenize(std::string_view source)
+    {
+        std::vector<std::string> tokens;
+        const auto skipPast = [&source](size_t i, std::string_view end) {
+            const auto pos = source.find(end, i);
+            return pos == std::string_view::npos ? source.size() : pos + end.size();
+        };
+        const auto isIdent = [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+        };
+        size_t i = 0;
+        while (i < source.size()) {
+            const auto c = source[i];
+            if (std::isspace(static_cast<unsigned char>(c))) {
+                i++;
+            } else if (source.substr(i, 2) == "//" || c == '#') {
+                i = skipPast(i, "\n");
+            } else if (source.substr(i, 2) == "/*") {
+                i = skipPast(i + 2, "*/");
+            } else if (isIdent(c)) {
+                const auto start = i;
+                while (i < source.size() && isIdent(source[i]))
+                    i++;
+                tokens.emplace_back(source.substr(start, i - start));
+            } else {
+                tokens.emplace_back(1, c);
+                i++;
+            }
+        }
+        return tokens;
+    }
+
+    GLenum getVariableType(std::string_view name)
+    {
+        static const std::unordered_map<std::string_view, GLenum> types {
+            { "float", GL_FLOAT },
+            { "vec2", GL_FLOAT_VEC2 },
+            { "vec3", GL_FLOAT_VEC3 },
+            { "vec4", GL_FLOAT_VEC4 },
+            { "int", GL_INT },
+            { "ivec2", GL_INT_VEC2 },
+            { "ivec3", GL_INT_VEC3 },
+            { "ivec4", GL_INT_VEC4 },
+            { "uint", GL_UNSIGNED_INT },
+            { "uvec2", GL_UNSIGNED_INT_VEC2 },
+            { "uvec3", GL_UNSIGNED_INT_VEC3 },
+            { "uvec4", GL_UNSIGNED_INT_VEC4 },
+            { "bool", GL_BOOL },
+            { "bvec2", GL_BOOL_VEC2 },
+            { "bvec3", GL_BOOL_VEC3 },
+            { "bvec4", GL_BOOL_VEC4 },
+            { "mat2", GL_FLOAT_MAT2 },
+            { "mat3", GL_FLOAT_MAT3 },
+            { "mat4", GL_FLOAT_MAT4 },
+            { "sampler2D", GL_SAMPLER_2D },
+            { "sampler3D", GL_SAMPLER_3D },
+            { "samplerCube", GL_SAMPLER_CUBE },
+            { "sampler2DArray", GL_SAMPLER_2D_ARRAY },
+            { "sampler2DShadow", GL_SAMPLER_2D_SHADOW },
+            { "samplerBuffer", GL_SAMPLER_BUFFER },
+        };
+        const auto it = types.find(name);
+        return it != types.end() ? it->second : 0;
+    }
+
+    // statement is a declaration without the semicolon, e.g. "layout(location = 0) in vec3 pos"
+    // or "uniform vec4 colors[4]". Anything else (multiple declarators, structs) is ignored.
+    void addDeclaration(ShaderInfo& shader, const std::vector<std::string_view>& statement)
+    {
+        static const std::unordered_set<std::string_view> ignoredQualifiers { "flat", "smooth",
+            "noperspective", "centroid", "highp", "mediump", "lowp", "invariant" };
+        std::vector<std::string_view> tokens;
+        for (size_t i = 0; i < statement.size(); ++i) {
+            if (statement[i] == "layout") {
+                while (i < statement.size() && statement[i] != ")")
+                    i++;
+            } else if (!ignoredQualifiers.count(statement[i])) {
+                tokens.push_back(statement[i]);
+            }
+        }
+        if (tokens.size() < 3)
+            return;
+        const auto type = getVariableType(tokens[1]);
+        if (!type)
+            return;
+        auto var = Variable { std::string(tokens[2]), 1, type };
+        if (tokens.size() == 6 && tokens[3] == "[" && tokens[5] == "]") {
+            // Like a real driver, report arrays by the name of their first element
+            var.size = std::atoi(std::string(tokens[4]).c_str());
+            var.name += "[0]";
+        } else if (tokens.size() != 3) {
+            return;
+        }
+        if (tokens[0] == "uniform")
+            shader.uniforms.push_back(std::move(var));
+        else if ((tokens[0] == "in" || tokens[0] == "attribute") && shader.type == GL_VERTEX_SHADER)
+            shader.attributes.push_back(std::move(var));
+    }
+
+    // Only picks up simple global declarations. Uniform blocks are skipped.
+    void parseDeclarations(ShaderInfo& shader, std::string_view source)
+    {
+        const auto tokens = tokenize(source);
+        std::vector<std::string_view> statement;
+        size_t depth = 0;
+        bool hasBlock = false;
+        for (const auto& token : tokens) {
+            if (token == "{") {
+                depth++;
+                hasBlock = true;
+            } else if (token == "}") {
+                depth = depth > 0 ? depth - 1 : 0;
+                // Function bodies are not followed by a semicolon
+                const auto function = std::find(statement.begin(), statement.end(), "(");
+                if (depth == 0 && function != statement.end()) {
+                    statement.clear();
+                    hasBlock = false;
+                }
+            } else if (depth > 0) {
+                continue;
+            } else if (token == ";") {
+                if (!hasBlock)
+                    addDeclaration(shader, statement);
+                statement.clear();
+                hasBlock = false;
+            } else {
+                statement.push_back(token);
+            }
+        }
+    }
+
+    void addVariables(std::vector<Variable>& dest, const std::vector<Variable>& vars)
+    {
+        for (const auto& var : vars) {
+            const auto it = std::find_if(dest.begin(), dest.end(),
+                [&var](const Variable& other) { return other.name == var.name; });
+            if (it == dest.end())
+                dest.push_back(var);
+        }
+    }
+
+    void getActiveVariable(const std::vector<Variable>& vars, GLuint index, GLsizei bufSize,
+        GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+    {
+        assert(index < vars.size());
+        const auto& var = vars[index];
+        const auto len = std::min(static_cast<size_t>(std::max(bufSize - 1, 0)), var.name.size());
+        if (bufSize > 0) {
+            std::memcpy(name, var.name.data(), len);
+            name[len] = '\0';
+        }
+        if (length)
+            *length = static_cast<GLsizei>(len);
+        *size = var.size;
+        *type = var.type;
+    }
+
+    GLint getMaxNameLength(const std::vector<Variable>& vars)
+    {
+        size_t maxLength = 0;
+        for (const auto& var : vars)
+            maxLength = std::max(maxLength, var.name.size() + 1);
+        return static_cast<GLint>(maxLength);
+    }
+
+    // Bytes read from client memory. If a pixel unpack buffer is bound, pixels is an offset.
+    size_t getUploadSize(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type,
+        const void* pixels)
+    {
+        if (!pixels || getBoundBuffer(GL_PIXEL_UNPACK_BUFFER))
+            return 0;
+        return static_cast<size_t>(width) * static_cast<size_t>(height)
+            * static_cast<size_t>(depth)
+            * Texture::getPixelSize(
+                static_cast<Texture::DataFormat>(format), static_cast<Texture::DataType>(type));
+    }
+
+    size_t getCompressedUploadSize(GLsizei imageSize, const void* data)
+    {
+        if (!data || getBoundBuffer(GL_PIXEL_UNPACK_BUFFER))
+            return 0;
+        return static_cast<size_t>(imageSize);
+    }
+
+    std::vector<uint8_t>& getBufferData(GLuint buffer)
+    {
+        assert(ctx().objects.count(buffer));
+        return ctx().bufferData[buffer];
+    }
+
+    void bufferData(GLuint buffer, GLsizeiptr size, const void* data)
+    {
+        auto& store = getBufferData(buffer);
+        store.assign(static_cast<size_t>(size), 0);
+        if (data)
+            std::memcpy(store.data(), data, static_cast<size_t>(size));
+    }
+
+    void bufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+    {
+        auto& store = getBufferData(buffer);
+        assert(static_cast<size_t>(offset + size) <= store.size());
+        std::memcpy(store.data() + offset, data, static_cast<size_t>(size));
+    }
+
+    void* mapBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr length)
+    {
+        auto& store = getBufferData(buffer);
+        assert(static_cast<size_t>(offset + length) <= store.size());
+        return store.data() + offset;
+    }
+
+    // Objects
+
+    void APIENTRY mockGenBuffers(GLsizei n, GLuint* buffers)
+    {
+        record("glGenBuffers");
+        genNames(n, buffers);
+    }
+
+    void APIENTRY mockCreateBuffers(GLsizei n, GLuint* buffers)
+    {
+        record("glCreateBuffers");
+        genNames(n, buffers);
+    }
+
+    void APIENTRY mockDeleteBuffers(GLsizei n, const GLuint* buffers)
+    {
+        record("glDeleteBuffers");
+        for (GLsizei i = 0; i < n; ++i)
+            ctx().bufferData.erase(buffers[i]);
+        deleteNames(n, buffers);
+    }
+
+    void APIENTRY mockGenTextures(GLsizei n, GLuint* textures)
+    {
+        record("glGenTextures");
+        genNames(n, textures);
+    }
+
+    void APIENTRY mockCreateTextures(GLenum, GLsizei n, GLuint* textures)
+    {
+        record("glCreateTextures");
+        genNames(n, textures);
+    }
+
+    void APIENTRY mockDeleteTextures(GLsizei n, const GLuint* textures)
+    {
+        record("glDeleteTextures");
+        deleteNames(n, textures);
+    }
+
+    void APIENTRY mockGenVertexArrays(GLsizei n, GLuint* arrays)
+    {
+        record("glGenVertexArrays");
+        genNames(n, arrays);
+    }
+
+    void APIENTRY mockDeleteVertexArrays(GLsizei n, const GLuint* arrays)
+    {
+        record("glDeleteVertexArrays");
+        deleteNames(n, arrays);
+    }
+
+    void APIENTRY mockGenFramebuffers(GLsizei n, GLuint* framebuffers)
+    {
+        record("glGenFramebuffers");
+        genNames(n, framebuffers);
+    }
+
+    void APIENTRY mockDeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+    {
+        record("glDeleteFramebuffers");
+        deleteNames(n, framebuffers);
+    }
+
+    void APIENTRY mockGenRenderbuffers(GLsizei n, GLuint* renderbuffers)
+    {
+        record("glGenRenderbuffers");
+        genNames(n, renderbuffers);
+    }
+
+    void APIENTRY mockDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers)
+    {
+        record("glDeleteRenderbuffers");
+        deleteNames(n, renderbuffers);
+    }
+
+    GLuint APIENTRY mockCreateShader(GLenum type)
+    {
+        record("glCreateShader");
+        const auto shader = genName();
+        ctx().shaders[shader].type = type;
+        return shader;
+    }
+
+    void APIENTRY mockDeleteShader(GLuint shader)
+    {
+        record("glDeleteShader");
+        ctx().objects.erase(shader);
+        ctx().shaders.erase(shader);
+    }
+
+    GLuint APIENTRY mockCreateProgram()
+    {
+        record("glCreateProgram");
+        const auto program = genName();
+        ctx().programs[program] = ProgramInfo {};
+        return program;
+    }
+
+    void APIENTRY mockDeleteProgram(GLuint program)
+    {
+        record("glDeleteProgram");
+        ctx().objects.erase(program);
+        ctx().programs.erase(program);
+    }
+
+    GLsync APIENTRY mockFenceSync(GLenum, GLbitfield)
+    {
+        record("glFenceSync");
+        return reinterpret_cast<GLsync>(ctx().nextSync++);
+    }
+
+    void APIENTRY mockDeleteSync(GLsync)
+    {
+        record("glDeleteSync");
+    }
+
+    GLenum APIENTRY mockClientWaitSync(GLsync, GLbitfield, GLuint64)
+    {
+        record("glClientWaitSync");
+        return GL_ALREADY_SIGNALED;
+    }
+
+    void APIENTRY mockGetSynciv(GLsync, GLenum pname, GLsizei, GLsizei* length, GLint* values)
+    {
+        record("glGetSynciv");
+        if (length)
+            *length = 1;
+        *values = pname == GL_SYNC_STATUS ? GL_SIGNALED : 0;
+    }
+
+    // Bindings
+
+    void APIENTRY mockBindBuffer(GLenum target, GLuint buffer)
+    {
+        record("glBindBuffer");
+        ctx().buffers[target] = buffer;
+    }
+
+    void APIENTRY mockBindBufferBase(GLenum target, GLuint, GLuint buffer)
+    {
+        record("glBindBufferBase");
+        ctx().buffers[target] = buffer;
+    }
+
+    void APIENTRY mockBindBufferRange(GLenum target, GLuint, GLuint buffer, GLintptr, GLsizeiptr)
+    {
+        record("glBindBufferRange");
+        ctx().buffers[target] = buffer;
+    }
+
+    void APIENTRY mockActiveTexture(GLenum texture)
+    {
+        record("glActiveTexture");
+        ctx().activeTexture = texture - GL_TEXTURE0;
+    }
+
+    void APIENTRY mockBindTexture(GLenum target, GLuint texture)
+    {
+        record("glBindTexture");
+        ctx().textures[std::tuple(ctx().activeTexture, target)] = texture;
+    }
+
+    void APIENTRY mockBindVertexArray(GLuint array)
+    {
+        record("glBindVertexArray");
+        ctx().vertexArray = array;
+    }
+
+    void APIENTRY mockBindFramebuffer(GLenum target, GLuint framebuffer)
+    {
+        record("glBindFramebuffer");
+        if (target == GL_FRAMEBUFFER) {
+            ctx().framebuffers[GL_READ_FRAMEBUFFER] = framebuffer;
+            ctx().framebuffers[GL_DRAW_FRAMEBUFFER] = framebuffer;
+        } else {
+            ctx().framebuffers[target] = framebuffer;
+        }
+    }
+
+    void APIENTRY mockBindRenderbuffer(GLenum, GLuint)
+    {
+        record("glBindRenderbuffer");
+    }
+
+    void APIENTRY mockUseProgram(GLuint program)
+    {
+        record("glUseProgram");
+        ctx().program = program;
+    }
+
+    // Buffers
+
+    void APIENTRY mockBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum)
+    {
+        record("glBufferData", data ? static_cast<size_t>(size) : 0);
+        bufferData(getBoundBuffer(target), size, data);
+    }
+
+    void APIENTRY mockNamedBufferData(GLuint buffer, GLsizeiptr size, const void* data, GLenum)
+    {
+        record("glNamedBufferData", data ? static_cast<size_t>(size) : 0);
+        bufferData(buffer, size, data);
+    }
+
+    void APIENTRY mockBufferStorage(
+        GLenum target, GLsizeiptr size, const void* data, GLbitfield)
+    {
+        record("glBufferStorage", data ? static_cast<size_t>(size) : 0);
+        bufferData(getBoundBuffer(target), size, data);
+    }
+
+    void APIENTRY mockNamedBufferStorage(
+        GLuint buffer, GLsizeiptr size, const void* data, GLbitfield)
+    {
+        record("glNamedBufferStorage", data ? static_cast<size_t>(size) : 0);
+        bufferData(buffer, size, data);
+    }
+
+    void APIENTRY mockBufferSubData(
+        GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+    {
+        record("glBufferSubData", static_cast<size_t>(size));
+        bufferSubData(getBoundBuffer(target), offset, size, data);
+    }
+
+    void APIENTRY mockNamedBufferSubData(
+        GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+    {
+        record("glNamedBufferSubData", static_cast<size_t>(size));
+        bufferSubData(buffer, offset, size, data);
+    }
+
+    // The bytes written through a mapping are not known, so they are not counted
+    void* APIENTRY mockMapBufferRange(
+        GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield)
+    {
+        record("glMapBufferRange");
+        return mapBufferRange(getBoundBuffer(target), offset, length);
+    }
+
+    void* APIENTRY mockMapNamedBufferRange(
+        GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield)
+    {
+        record("glMapNamedBufferRange");
+        return mapBufferRange(buffer, offset, length);
+    }
+
+    void APIENTRY mockFlushMappedBufferRange(GLenum, GLintptr, GLsizeiptr)
+    {
+        record("glFlushMappedBufferRange");
+    }
+
+    void APIENTRY mockFlushMappedNamedBufferRange(GLuint, GLintptr, GLsizeiptr)
+    {
+        record("glFlushMappedNamedBufferRange");
+    }
+
+    GLboolean APIENTRY mockUnmapBuffer(GLenum)
+    {
+        record("glUnmapBuffer");
+        return GL_TRUE;
+    }
+
+    GLboolean APIENTRY mockUnmapNamedBuffer(GLuint)
+    {
+        record("glUnmapNamedBuffer");
+        return GL_TRUE;
+    }
+
+    // Textures
+
+    void APIENTRY mockTexImage2D(GLenum, GLint, GLint, GLsizei width, GLsizei height, GLint,
+        GLenum format, GLenum type, const void* pixels)
+    {
+        record("glTexImage2D", getUploadSize(width, height, 1, format, type, pixels));
+    }
+
+    void APIENTRY mockTexImage3D(GLenum, GLint, GLint, GLsizei width, GLsizei height,
+        GLsizei depth, GLint, GLenum format, GLenum type, const void* pixels)
+    {
+        record("glTexImage3D", getUploadSize(width, height, depth, format, type, pixels));
+    }
+
+    void APIENTRY mockCompressedTexImage2D(GLenum, GLint, GLenum, GLsizei, GLsizei, GLint,
+        GLsizei imageSize, const void* data)
+    {
+        record("glCompressedTexImage2D", getCompressedUploadSize(imageSize, data));
+    }
+
+    void APIENTRY mockCompressedTexSubImage2D(GLenum, GLint, GLint, GLint, GLsizei, GLsizei,
+        GLenum, GLsizei imageSize, const void* data)
+    {
+        record("glCompressedTexSubImage2D", getCompressedUploadSize(imageSize, data));
+    }
+
+    void APIENTRY mockCompressedTextureSubImage2D(GLuint, GLint, GLint, GLint, GLsizei, GLsizei,
+        GLenum, GLsizei imageSize, const void* data)
+    {
+        record("glCompressedTextureSubImage2D", getCompressedUploadSize(imageSize, data));
+    }
+
+    void APIENTRY mockCompressedTextureSubImage3D(GLuint, GLint, GLint, GLint, GLint, GLsizei,
+        GLsizei, GLsizei, GLenum, GLsizei imageSize, const void* data)
+    {
+        record("glCompressedTextureSubImage3D", getCompressedUploadSize(imageSize, data));
+    }
+
+    void APIENTRY mockTexStorage2D(GLenum, GLsizei, GLenum, GLsizei, GLsizei)
+    {
+        record("glTexStorage2D");
+    }
+
+    void APIENTRY mockTexStorage3D(GLenum, GLsizei, GLenum, GLsizei, GLsizei, GLsizei)
+    {
+        record("glTexStorage3D");
+    }
+
+    void APIENTRY mockTextureStorage2D(GLuint, GLsizei, GLenum, GLsizei, GLsizei)
+    {
+        record("glTextureStorage2D");
+    }
+
+    void APIENTRY mockTextureStorage3D(GLuint, GLsizei, GLenum, GLsizei, GLsizei, GLsizei)
+    {
+        record("glTextureStorage3D");
+    }
+
+    void APIENTRY mockTexSubImage2D(GLenum, GLint, GLint, GLint, GLsizei width, GLsizei height,
+        GLenum format, GLenum type, const void* pixels)
+    {
+        record("glTexSubImage2D", getUploadSize(width, height, 1, format, type, pixels));
+    }
+
+    void APIENTRY mockTextureSubImage2D(GLuint, GLint, GLint, GLint, GLsizei width,
+        GLsizei height, GLenum format, GLenum type, const void* pixels)
+    {
+        record("glTextureSubImage2D", getUploadSize(width, height, 1, format, type, pixels));
+    }
+
+    void APIENTRY mockTextureSubImage3D(GLuint, GLint, GLint, GLint, GLint, GLsizei width,
+        GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels)
+    {
+        record("glTextureSubImage3D", getUploadSize(width, height, depth, format, type, pixels));
+    }
+
+    void APIENTRY mockTexParameterf(GLenum, GLenum, GLfloat)
+    {
+        record("glTexParameterf");
+    }
+
+    void APIENTRY mockTexParameterfv(GLenum, GLenum, const GLfloat*)
+    {
+        record("glTexParameterfv");
+    }
+
+    void APIENTRY mockTexParameteri(GLenum, GLenum, GLint)
+    {
+        record("glTexParameteri");
+    }
+
+    void APIENTRY mockTexParameteriv(GLenum, GLenum, const GLint*)
+    {
+        record("glTexParameteriv");
+    }
+
+    void APIENTRY mockTextureParameterf(GLuint, GLenum, GLfloat)
+    {
+        record("glTextureParameterf");
+    }
+
+    void APIENTRY mockTextureParameterfv(GLuint, GLenum, const GLfloat*)
+    {
+        record("glTextureParameterfv");
+    }
+
+    void APIENTRY mockTextureParameteri(GLuint, GLenum, GLint)
+    {
+        record("glTextureParameteri");
+    }
+
+    void APIENTRY mockTextureParameteriv(GLuint, GLenum, const GLint*)
+    {
+        record("glTextureParameteriv");
+    }
+
+    void APIENTRY mockGenerateMipmap(GLenum)
+    {
+        record("glGenerateMipmap");
+    }
+
+    void APIENTRY mockGenerateTextureMipmap(GLuint)
+    {
+        record("glGenerateTextureMipmap");
+    }
+
+    // Framebuffers
+
+    GLenum APIENTRY mockCheckFramebufferStatus(GLenum)
+    {
+        record("glCheckFramebufferStatus");
+        return GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    void APIENTRY mockFramebufferTexture(GLenum, GLenum, GLuint, GLint)
+    {
+        record("glFramebufferTexture");
+    }
+
+    void APIENTRY mockFramebufferTexture2D(GLenum, GLenum, GLenum, GLuint, GLint)
+    {
+        record("glFramebufferTexture2D");
+    }
+
+    void APIENTRY mockFramebufferRenderbuffer(GLenum, GLenum, GLenum, GLuint)
+    {
+        record("glFramebufferRenderbuffer");
+    }
+
+    void APIENTRY mockRenderbufferStorage(GLenum, GLenum, GLsizei, GLsizei)
+    {
+        record("glRenderbufferStorage");
+    }
+
+    void APIENTRY mockReadBuffer(GLenum)
+    {
+        record("glReadBuffer");
+    }
+
+    void APIENTRY mockPixelStorei(GLenum, GLint)
+    {
+        record("glPixelStorei");
+    }
+
+    void APIENTRY mockReadPixels(GLint, GLint, GLsizei width, GLsizei height, GLenum format,
+        GLenum type, void* pixels)
+    {
+        // Only count bytes transferred into client memory
+        if (!pixels || getBoundBuffer(GL_PIXEL_PACK_BUFFER)) {
+            record("glReadPixels");
+            return;
+        }
+        record("glReadPixels",
+            static_cast<size_t>(width) * static_cast<size_t>(height)
+                * Texture::getPixelSize(static_cast<Texture::DataFormat>(format),
+                    static_cast<Texture::DataType>(type)));
+    }
+
+    // Shaders
+
+    void APIENTRY mockShaderSource(
+        GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths)
+    {
+        record("glShaderSource");
+        std::string source;
+        for (GLsizei i = 0; i < count; ++i) {
+            if (lengths && lengths[i] >= 0)
+                source.append(strings[i], static_cast<size_t>(lengths[i]));
+            else
+                source.append(strings[i]);
+        }
+        auto& info = ctx().shaders[shader];
+        info.uniforms.clear();
+        info.attributes.clear();
+        parseDeclarations(info, source);
+    }
+
+    void APIENTRY mockCompileShader(GLuint)
+    {
+        record("glCompileShader");
+    }
+
+    void APIENTRY mockGetShaderiv(GLuint, GLenum pname, GLint* params)
+    {
+        record("glGetShaderiv");
+        *params = pname == GL_COMPILE_STATUS || pname == GL_COMPLETION_STATUS_KHR ? GL_TRUE : 0;
+    }
+
+    void APIENTRY mockGetShaderInfoLog(GLuint, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+    {
+        record("glGetShaderInfoLog");
+        if (length)
+            *length = 0;
+        if (bufSize > 0)
+            infoLog[0] = '\0';
+    }
+
+    void APIENTRY mockAttachShader(GLuint program, GLuint shader)
+    {
+        record("glAttachShader");
+        ctx().programs[program].shaders.push_back(shader);
+    }
+
+    void APIENTRY mockDetachShader(GLuint program, GLuint shader)
+    {
+        record("glDetachShader");
+        auto& shaders = ctx().programs[program].shaders;
+        shaders.erase(std::remove(shaders.begin(), shaders.end(), shader), shaders.end());
+    }
+
+    void APIENTRY mockLinkProgram(GLuint program)
+    {
+        record("glLinkProgram");
+        auto& info = ctx().programs[program];
+        info.uniforms.clear();
+        info.attributes.clear();
+        for (const auto shader : info.shaders) {
+            const auto it = ctx().shaders.find(shader);
+            if (it == ctx().shaders.end())
+                continue;
+            addVariables(info.uniforms, it->second.uniforms);
+            addVariables(info.attributes, it->second.attributes);
+        }
+    }
+
+    // The active uniforms and attributes are the ones declared in the shader sources
+    void APIENTRY mockGetProgramiv(GLuint program, GLenum pname, GLint* params)
+    {
+        record("glGetProgramiv");
+        const auto& info = ctx().programs[program];
+        if (pname == GL_LINK_STATUS || pname == GL_COMPLETION_STATUS_KHR)
+            *params = GL_TRUE;
+        else if (pname == GL_PROGRAM_BINARY_LENGTH && ctx().programBinary)
+            *params = sizeof(GLuint);
+        else if (pname == GL_ACTIVE_UNIFORMS)
+            *params = static_cast<GLint>(info.uniforms.size());
+        else if (pname == GL_ACTIVE_UNIFORM_MAX_LENGTH)
+            *params = getMaxNameLength(info.uniforms);
+        else if (pname == GL_ACTIVE_ATTRIBUTES)
+            *params = static_cast<GLint>(info.attributes.size());
+        else if (pname == GL_ACTIVE_ATTRIBUTE_MAX_LENGTH)
+            *params = getMaxNameLength(info.attributes);
+        else
+            *params = 0;
+    }
+
+    void APIENTRY mockMaxShaderCompilerThreadsKHR(GLuint)
+    {
+        record("glMaxShaderCompilerThreadsKHR");
+    }
+
+    void APIENTRY mockProgramParameteri(GLuint, GLenum, GLint)
+    {
+        record("glProgramParameteri");
+    }
+
+    void APIENTRY mockGetProgramBinary(
+        GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary)
+    {
+        record("glGetProgramBinary");
+        assert(bufSize >= static_cast<GLsizei>(sizeof(GLuint)));
+        std::memcpy(binary, &program, sizeof(GLuint));
+        *length = sizeof(GLuint);
+        *binaryFormat = 1;
+    }
+
+    // The binary is the name of the program it was retrieved from, so the variables can be copied
+    void APIENTRY mockProgramBinary(GLuint program, GLenum, const void* binary, GLsizei length)
+    {
+        record("glProgramBinary", static_cast<size_t>(length));
+        GLuint source = 0;
+        if (length == sizeof(GLuint))
+            std::memcpy(&source, binary, sizeof(GLuint));
+        const auto it = ctx().programs.find(source);
+        if (it != ctx().programs.end() && source != program) {
+            auto& info = ctx().programs[program];
+            info.uniforms = it->second.uniforms;
+            info.attributes = it->second.attributes;
+        }
+    }
+
+    void APIENTRY mockGetProgramInfoLog(
+        GLuint, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+    {
+        record("glGetProgramInfoLog");
+        if (length)
+            *length = 0;
+        if (bufSize > 0)
+            infoLog[0] = '\0';
+    }
+
+    void APIENTRY mockGetActiveAttrib(GLuint program, GLuint index, GLsizei bufSize,
+        GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+    {
+        record("glGetActiveAttrib");
+        getActiveVariable(
+            ctx().programs[program].attributes, index, bufSize, length, size, type, name);
+    }
+
+    void APIENTRY mockGetActiveUniform(GLuint program, GLuint index, GLsizei bufSize,
+        GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+    {
+        record("glGetActiveUniform");
+        getActiveVariable(
+            ctx().programs[program].uniforms, index, bufSize, length, size, type, name);
+    }
+
+    GLint APIENTRY mockGetUniformLocation(GLuint program, const GLchar* name)
+    {
+        record("glGetUniformLocation");
+        return getLocation(program, name);
+    }
+
+    GLint APIENTRY mockGetAttribLocation(GLuint program, const GLchar* name)
+    {
+        record("glGetAttribLocation");
+        return getLocation(program, name);
+    }
+
+    // Uniforms
+
+    void APIENTRY mockUniformBlockBinding(GLuint, GLuint, GLuint)
+    {
+        record("glUniformBlockBinding");
+    }
+
+    void APIENTRY mockUniform1i(GLint, GLint)
+    {
+        record("glUniform1i", sizeof(GLint));
+    }
+
+    void APIENTRY mockUniform1iv(GLint, GLsizei count, const GLint*)
+    {
+        record("glUniform1iv", sizeof(GLint) * static_cast<size_t>(count));
+    }
+
+    void APIENTRY mockUniform1f(GLint, GLfloat)
+    {
+        record("glUniform1f", sizeof(GLfloat));
+    }
+
+    void APIENTRY mockUniform1fv(GLint, GLsizei count, const GLfloat*)
+    {
+        record("glUniform1fv", sizeof(GLfloat) * static_cast<size_t>(count));
+    }
+
+    void APIENTRY mockUniform2fv(GLint, GLsizei count, const GLfloat*)
+    {
+        record("glUniform2fv", 2 * sizeof(GLfloat) * static_cast<size_t>(count));
+    }
+
+    void APIENTRY mockUniform3fv(GLint, GLsizei count, const GLfloat*)
+    {
+        record("glUniform3fv", 3 * sizeof(GLfloat) * static_cast<size_t>(count));
+    }
+
+    void APIENTRY mockUniform4fv(GLint, GLsizei count, const GLfloat*)
+    {
+        record("glUniform4fv", 4 * sizeof(GLfloat) * static_cast<size_t>(count));
+    }
+
+    void APIENTRY mockUniformMatrix2fv(GLint, GLsizei count, GLboolean, const GLfloat*)
+    {
+        record("glUniformMatrix2fv", 4 * sizeof(GLfloat) * static_cast<size_t>(count));
+    }
+
+    void APIENTRY mockUniformMatrix3fv(GLint, GLsizei count, GLboolean, const GLfloat*)
+    {
+        record("glUniformMatrix3fv", 9 * sizeof(GLfloat) * static_cast<size_t>(count));
+    }
+
+    void APIENTRY mockUniformMatrix4fv(GLint, GLsizei count, GLboolean, const GLfloat*)
+    {
+        record("glUniformMatrix4fv", 16 * sizeof(GLfloat) * static_cast<size_t>(count));
+    }
+
+    // Vertex specification
+
+    void APIENTRY mockEnableVertexAttribArray(GLuint)
+    {
+        record("glEnableVertexAttribArray");
+    }
+
+    void APIENTRY mockVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*)
+    {
+        record("glVertexAttribPointer");
+    }
+
+    void APIENTRY mockVertexAttribDivisor(GLuint, GLuint)
+    {
+        record("glVertexAttribDivisor");
+    }
+
+    // Drawing
+
+    void APIENTRY mockDrawArrays(GLenum, GLint, GLsizei)
+    {
+        record("glDrawArrays");
+    }
+
+    void APIENTRY mockDrawArraysInstanced(GLenum, GLint, GLsizei, GLsizei)
+    {
+        record("glDrawArraysInstanced");
+    }
+
+    void APIENTRY mockDrawElements(GLenum, GLsizei, GLenum, const void*)
+    {
+        record("glDrawElements");
+    }
+
+    void APIENTRY mockDrawElementsBaseVertex(GLenum, GLsizei, GLenum, const void*, GLint)
+    {
+        record("glDrawElementsBaseVertex");
+    }
+
+    void APIENTRY mockDrawElementsInstanced(GLenum, GLsizei, GLenum, const void*, GLsizei)
+    {
+        record("glDrawElementsInstanced");
+    }
+
+    void APIENTRY mockDrawElementsInstancedBaseVertex(
+        GLenum, GLsizei, GLenum, const void*, GLsizei, GLint)
+    {
+        record("glDrawElementsInstancedBaseVertex");
+    }
+
+    // Queries
+
+    const GLubyte* APIENTRY mockGetString(GLenum)
+    {
+        record("glGetString");
+        return reinterpret_cast<const GLubyte*>("glwrap mock");
+    }
+
+    void APIENTRY mockGetIntegerv(GLenum pname, GLint* data)
+    {
+        record("glGetIntegerv");
+        if (pname == GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT)
+            *data = 256; // What most desktop drivers report
+        else
+            *data = pname == GL_NUM_PROGRAM_BINARY_FORMATS && ctx().programBinary ? 1 : 0;
+    }
+
+    // Fixed function state
+
+    void APIENTRY mockEnable(GLenum)
+    {
+        record("glEnable");
+    }
+
+    void APIENTRY mockDisable(GLenum)
+    {
+        record("glDisable");
+    }
+
+    void APIENTRY mockViewport(GLint, GLint, GLsizei, GLsizei)
+    {
+        record("glViewport");
+    }
+
+    void APIENTRY mockScissor(GLint, GLint, GLsizei, GLsizei)
+    {
+        record("glScissor");
+    }
+
+    void APIENTRY mockDepthFunc(GLenum)
+    {
+        record("glDepthFunc");
+    }
+
+    void APIENTRY mockDepthMask(GLboolean)
+    {
+        record("glDepthMask");
+    }
+
+    void APIENTRY mockColorMask(GLboolean, GLboolean, GLboolean, GLboolean)
+    {
+        record("glColorMask");
+    }
+
+    void APIENTRY mockCullFace(GLenum)
+    {
+        record("glCullFace");
+    }
+
+    void APIENTRY mockFrontFace(GLenum)
+    {
+        record("glFrontFace");
+    }
+
+    void APIENTRY mockBlendColor(GLfloat, GLfloat, GLfloat, GLfloat)
+    {
+        record("glBlendColor");
+    }
+
+    void APIENTRY mockBlendEquationSeparate(GLenum, GLenum)
+    {
+        record("glBlendEquationSeparate");
+    }
+
+    void APIENTRY mockBlendFuncSeparate(GLenum, GLenum, GLenum, GLenum)
+    {
+        record("glBlendFuncSeparate");
+    }
+
+    void APIENTRY mockStencilFuncSeparate(GLenum, GLenum, GLint, GLuint)
+    {
+        record("glStencilFuncSeparate");
+    }
+
+    void APIENTRY mockStencilMaskSeparate(GLenum, GLuint)
+    {
+        record("glStencilMaskSeparate");
+    }
+
+    void APIENTRY mockStencilOpSeparate(GLenum, GLenum, GLenum, GLenum)
+    {
+        record("glStencilOpSeparate");
+    }
+
+    void APIENTRY mockPolygonOffset(GLfloat, GLfloat)
+    {
+        record("glPolygonOffset");
+    }
+
+    // Debug
+
+    void APIENTRY mockDebugMessageCallback(GLDEBUGPROC, const void*)
+    {
+        record("glDebugMessageCallback");
+    }
+
+    void APIENTRY mockDebugMessageControl(
+        GLenum, GLenum, GLenum, GLsizei, const GLuint*, GLboolean)
+    {
+        record("glDebugMessageControl");
+    }
+
+    void APIENTRY mockDebugMessageInsert(GLenum, GLenum, GLuint, GLenum, GLsizei, const GLchar*)
+    {
+        record("glDebugMessageInsert");
+    }
+
+    void APIENTRY mockPushDebugGroup(GLenum, GLuint, GLsizei, const GLchar*)
+    {
+        record("glPushDebugGroup");
+    }
+
+    void APIENTRY mockPopDebugGroup()
+    {
+        record("glPopDebugGroup");
+    }
+
+    void APIENTRY mockObjectLabel(GLenum, GLuint, GLsizei, const GLchar*)
+    {
+        record("glObjectLabel");
+    }
+}
+
+void install(const Options& options)
+{
+    ctx() = Context {};
+    ctx().programBinary = options.programBinary;
+
+    GLVersion.major = 3;
+    GLVersion.minor = 3;
+    GLAD_GL_VERSION_1_0 = GLAD_GL_VERSION_1_1 = GLAD_GL_VERSION_1_2 = GLAD_GL_VERSION_1_3 = 1;
+    GLAD_GL_VERSION_1_4 = GLAD_GL_VERSION_1_5 = GLAD_GL_VERSION_2_0 = GLAD_GL_VERSION_2_1 = 1;
+    GLAD_GL_VERSION_3_0 = GLAD_GL_VERSION_3_1 = GLAD_GL_VERSION_3_2 = GLAD_GL_VERSION_3_3 = 1;
+    GLAD_GL_ARB_direct_state_access = options.directStateAccess;
+    GLAD_GL_ARB_buffer_storage = options.bufferStorage;
+    GLAD_GL_ARB_texture_storage = options.textureStorage;
+    // Every desktop driver has these
+    GLAD_GL_EXT_texture_compression_s3tc = GLAD_GL_EXT_texture_sRGB = 1;
+    GLAD_GL_ARB_get_program_binary = options.programBinary;
+    GLAD_GL_KHR_parallel_shader_compile = options.parallelShaderCompile;
+
+    glad_glGenBuffers = mockGenBuffers;
+    glad_glCreateBuffers = mockCreateBuffers;
+    glad_glDeleteBuffers = mockDeleteBuffers;
+    glad_glGenTextures = mockGenTextures;
+    glad_glCreateTextures = mockCreateTextures;
+    glad_glDeleteTextures = mockDeleteTextures;
+    glad_glGenVertexArrays = mockGenVertexArrays;
+    glad_glDeleteVertexArrays = mockDeleteVertexArrays;
+    glad_glGenFramebuffers = mockGenFramebuffers;
+    glad_glDeleteFramebuffers = mockDeleteFramebuffers;
+    glad_glGenRenderbuffers = mockGenRenderbuffers;
+    glad_glDeleteRenderbuffers = mockDeleteRenderbuffers;
+    glad_glCreateShader = mockCreateShader;
+    glad_glDeleteShader = mockDeleteShader;
+    glad_glCreateProgram = mockCreateProgram;
+    glad_glDeleteProgram = mockDeleteProgram;
+    glad_glFenceSync = mockFenceSync;
+    glad_glDeleteSync = mockDeleteSync;
+    glad_glClientWaitSync = mockClientWaitSync;
+    glad_glGetSynciv = mockGetSynciv;
+
+    glad_glBindBuffer = mockBindBuffer;
+    glad_glBindBufferBase = mockBindBufferBase;
+    glad_glBindBufferRange = mockBindBufferRange;
+    glad_glActiveTexture = mockActiveTexture;
+    glad_glBindTexture = mockBindTexture;
+    glad_glBindVertexArray = mockBindVertexArray;
+    glad_glBindFramebuffer = mockBindFramebuffer;
+    glad_glBindRenderbuffer = mockBindRenderbuffer;
+    glad_glUseProgram = mockUseProgram;
+
+    glad_glBufferData = mockBufferData;
+    glad_glNamedBufferData = mockNamedBufferData;
+    glad_glBufferStorage = mockBufferStorage;
+    glad_glNamedBufferStorage = mockNamedBufferStorage;
+    glad_glBufferSubData = mockBufferSubData;
+    glad_glNamedBufferSubData = mockNamedBufferSubData;
+    glad_glMapBufferRange = mockMapBufferRange;
+    glad_glMapNamedBufferRange = mockMapNamedBufferRange;
+    glad_glFlushMappedBufferRange = mockFlushMappedBufferRange;
+    glad_glFlushMappedNamedBufferRange = mockFlushMappedNamedBufferRange;
+    glad_glUnmapBuffer = mockUnmapBuffer;
+    glad_glUnmapNamedBuffer = mockUnmapNamedBuffer;
+
+    glad_glTexImage2D = mockTexImage2D;
+    glad_glTexImage3D = mockTexImage3D;
+    glad_glCompressedTexImage2D = mockCompressedTexImage2D;
+    glad_glCompressedTexSubImage2D = mockCompressedTexSubImage2D;
+    glad_glCompressedTextureSubImage2D = mockCompressedTextureSubImage2D;
+    glad_glCompressedTextureSubImage3D = mockCompressedTextureSubImage3D;
+    glad_glTexStorage2D = mockTexStorage2D;
+    glad_glTexStorage3D = mockTexStorage3D;
+    glad_glTextureStorage2D = mockTextureStorage2D;
+    glad_glTextureStorage3D = mockTextureStorage3D;
+    glad_glTexSubImage2D = mockTexSubImage2D;
+    glad_glTextureSubImage2D = mockTextureSubImage2D;
+    glad_glTextureSubImage3D = mockTextureSubImage3D;
+    glad_glTexParameterf = mockTexParameterf;
+    glad_glTexParameterfv = mockTexParameterfv;
+    glad_glTexParameteri = mockTexParameteri;
+    glad_glTexParameteriv = mockTexParameteriv;
+    glad_glTextureParameterf = mockTextureParameterf;
+    glad_glTextureParameterfv = mockTextureParameterfv;
+    glad_glTextureParameteri = mockTextureParameteri;
+    glad_glTextureParameteriv = mockTextureParameteriv;
+    glad_glGenerateMipmap = mockGenerateMipmap;
+    glad_glGenerateTextureMipmap = mockGenerateTextureMipmap;
+
+    glad_glCheckFramebufferStatus = mockCheckFramebufferStatus;
+    glad_glFramebufferTexture = mockFramebufferTexture;
+    glad_glFramebufferTexture2D = mockFramebufferTexture2D;
+    glad_glFramebufferRenderbuffer = mockFramebufferRenderbuffer;
+    glad_glRenderbufferStorage = mockRenderbufferStorage;
+    glad_glReadBuffer = mockReadBuffer;
+    glad_glReadPixels = mockReadPixels;
+    glad_glPixelStorei = mockPixelStorei;
+
+    glad_glShaderSource = mockShaderSource;
+    glad_glCompileShader = mockCompileShader;
+    glad_glGetShaderiv = mockGetShaderiv;
+    glad_glGetShaderInfoLog = mockGetShaderInfoLog;
+    glad_glAttachShader = mockAttachShader;
+    glad_glDetachShader = mockDetachShader;
+    glad_glLinkProgram = mockLinkProgram;
+    glad_glGetProgramiv = mockGetProgramiv;
+    glad_glGetProgramInfoLog = mockGetProgramInfoLog;
+    glad_glGetActiveAttrib = mockGetActiveAttrib;
+    glad_glGetActiveUniform = mockGetActiveUniform;
+    glad_glGetUniformLocation = mockGetUniformLocation;
+    glad_glGetAttribLocation = mockGetAttribLocation;
+    glad_glMaxShaderCompilerThreadsKHR = mockMaxShaderCompilerThreadsKHR;
+    glad_glProgramParameteri = mockProgramParameteri;
+    glad_glGetProgramBinary = mockGetProgramBinary;
+    glad_glProgramBinary = mockProgramBinary;
+
+    glad_glGetString = mockGetString;
+    glad_glGetIntegerv = mockGetIntegerv;
+
+    glad_glUniformBlockBinding = mockUniformBlockBinding;
+    glad_glUniform1i = mockUniform1i;
+    glad_glUniform1iv = mockUniform1iv;
+    glad_glUniform1f = mockUniform1f;
+    glad_glUniform1fv = mockUniform1fv;
+    glad_glUniform2fv = mockUniform2fv;
+    glad_glUniform3fv = mockUniform3fv;
+    glad_glUniform4fv = mockUniform4fv;
+    glad_glUniformMatrix2fv = mockUniformMatrix2fv;
+    glad_glUniformMatrix3fv = mockUniformMatrix3fv;
+    glad_glUniformMatrix4fv = mockUniformMatrix4fv;
+
+    glad_glEnableVertexAttribArray = mockEnableVertexAttribArray;
+    glad_glVertexAttribPointer = mockVertexAttribPointer;
+    glad_glVertexAttribDivisor = mockVertexAttribDivisor;
+
+    glad_glDrawArrays = mockDrawArrays;
+    glad_glDrawArraysInstanced = mockDrawArraysInstanced;
+    glad_glDrawElements = mockDrawElements;
+    glad_glDrawElementsBaseVertex = mockDrawElementsBaseVertex;
+    glad_glDrawElementsInstanced = mockDrawElementsInstanced;
+    glad_glDrawElementsInstancedBaseVertex = mockDrawElementsInstancedBaseVertex;
+
+    glad_glEnable = mockEnable;
+    glad_glDisable = mockDisable;
+    glad_glViewport = mockViewport;
+    glad_glScissor = mockScissor;
+    glad_glDepthFunc = mockDepthFunc;
+    glad_glDepthMask = mockDepthMask;
+    glad_glColorMask = mockColorMask;
+    glad_glCullFace = mockCullFace;
+    glad_glFrontFace = mockFrontFace;
+    glad_glBlendColor = mockBlendColor;
+    glad_glBlendEquationSeparate = mockBlendEquationSeparate;
+    glad_glBlendFuncSeparate = mockBlendFuncSeparate;
+    glad_glStencilFuncSeparate = mockStencilFuncSeparate;
+    glad_glStencilMaskSeparate = mockStencilMaskSeparate;
+    glad_glStencilOpSeparate = mockStencilOpSeparate;
+    glad_glPolygonOffset = mockPolygonOffset;
+
+    glad_glDebugMessageCallback = mockDebugMessageCallback;
+    glad_glDebugMessageControl = mockDebugMessageControl;
+    glad_glDebugMessageInsert = mockDebugMessageInsert;
+    glad_glPushDebugGroup = mockPushDebugGroup;
+    glad_glPopDebugGroup = mockPopDebugGroup;
+    glad_glObjectLabel = mockObjectLabel;
+}
+
+void resetCounters()
+{
+    ctx().calls.clear();
+}
+
+const std::map<std::string_view, CallStats>& getCalls()
+{
+    return ctx().calls;
+}
+
+CallStats getCalls(std::string_view entryPoint)
+{
+    const auto it = ctx().calls.find(entryPoint);
+    return it != ctx().calls.end() ? it->second : CallStats {};
+}
+
+size_t getTotalCalls()
+{
+    size_t total = 0;
+    for (const auto& [name, stats] : ctx().calls)
+        total += stats.calls;
+    return total;
+}
+
+size_t getTotalBytes()
+{
+    size_t total = 0;
+    for (const auto& [name, stats] : ctx().calls)
+        total += stats.bytes;
+    return total;
+}
+
+size_t getLiveObjectCount()
+{
+    return ctx().objects.size();
+}
+
+GLuint getBoundBuffer(GLenum target)
+{
+    const auto it = ctx().buffers.find(target);
+    return it != ctx().buffers.end() ? it->second : 0;
+}
+
+GLuint getBoundTexture(unsigned int unit, GLenum target)
+{
+    const auto it = ctx().textures.find(std::tuple(unit, target));
+    return it != ctx().textures.end() ? it->second : 0;
+}
+
+GLuint getBoundVertexArray()
+{
+    return ctx().vertexArray;
+}
+
+GLuint getBoundFramebuffer(GLenum target)
+{
+    const auto it = ctx().framebuffers.find(target);
+    return it != ctx().framebuffers.end() ? it->second : 0;
+}
+
+GLuint getCurrentProgram()
+{
+    return ctx().program;
+}
+}
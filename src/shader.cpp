@@ -1,5 +1,8 @@
 #include "glw/shader.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 #include "glw/log.hpp"
 
 namespace glw {
@@ -15,6 +18,105 @@ ShaderResult::operator bool() const
     return success;
 }
 
+namespace {
+    size_t getUniformTypeSize(UniformInfo::Type type)
+    {
+        using T = UniformInfo::Type;
+        switch (type) {
+        case T::Double:
+            return 8;
+        case T::Vec2:
+        case T::IVec2:
+        case T::UVec2:
+        case T::BVec2:
+            return 2 * 4;
+        case T::Vec3:
+        case T::IVec3:
+        case T::UVec3:
+        case T::BVec3:
+            return 3 * 4;
+        case T::Vec4:
+        case T::IVec4:
+        case T::UVec4:
+        case T::BVec4:
+        case T::Mat2:
+            return 4 * 4;
+        case T::Mat2x3:
+        case T::Mat3x2:
+            return 6 * 4;
+        case T::Mat2x4:
+        case T::Mat4x2:
+            return 8 * 4;
+        case T::Mat3:
+            return 9 * 4;
+        case T::Mat3x4:
+        case T::Mat4x3:
+            return 12 * 4;
+        case T::Mat4:
+            return 16 * 4;
+        default:
+            // Scalars and samplers
+            return 4;
+        }
+    }
+}
+
+size_t getAttributeLocationCount(AttributeInfo::Type type)
+{
+    using T = AttributeInfo::Type;
+    switch (type) {
+    case T::Mat2:
+    case T::Mat2x3:
+    case T::Mat2x4:
+        return 2;
+    case T::Mat3:
+    case T::Mat3x2:
+    case T::Mat3x4:
+        return 3;
+    case T::Mat4:
+    case T::Mat4x2:
+    case T::Mat4x3:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+size_t getAttributeComponentCount(AttributeInfo::Type type)
+{
+    using T = AttributeInfo::Type;
+    switch (type) {
+    case T::Vec2:
+    case T::IVec2:
+    case T::UVec2:
+    case T::Mat2:
+    case T::Mat3x2:
+    case T::Mat4x2:
+        return 2;
+    case T::Vec3:
+    case T::IVec3:
+    case T::UVec3:
+    case T::Mat3:
+    case T::Mat2x3:
+    case T::Mat4x3:
+        return 3;
+    case T::Vec4:
+    case T::IVec4:
+    case T::UVec4:
+    case T::Mat4:
+    case T::Mat2x4:
+    case T::Mat3x4:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+bool getParallelCompileSupported()
+{
+    return GLAD_GL_KHR_parallel_shader_compile;
+}
+
 Shader::Shader(Type type)
     : shader_(glCreateShader(static_cast<GLenum>(type)))
 {
@@ -66,9 +168,27 @@ void Shader::setSources(std::initializer_list<std::string_view> sources) const
 }
 
 ShaderResult Shader::compile() const
+{
+    startCompile();
+    return getCompileResult();
+}
+
+void Shader::startCompile() const
 {
     glCompileShader(shader_);
+}
+
+bool Shader::isCompileFinished() const
+{
+    if (!getParallelCompileSupported())
+        return true;
+    GLint completionStatus = GL_FALSE;
+    glGetShaderiv(shader_, GL_COMPLETION_STATUS_KHR, &completionStatus);
+    return completionStatus == GL_TRUE;
+}
 
+ShaderResult Shader::getCompileResult() const
+{
     // get the log in any case
     GLint logLength = 0;
     glGetShaderiv(shader_, GL_INFO_LOG_LENGTH, &logLength);
@@ -103,7 +223,12 @@ ShaderProgram::ShaderProgram(ShaderProgram&& other)
     , attachedShaders_(std::move(other.attachedShaders_))
     , attribLocations_(std::move(other.attribLocations_))
     , uniformLocations_(std::move(other.uniformLocations_))
+    , attributeInfo_(std::move(other.attributeInfo_))
     , uniformInfo_(std::move(other.uniformInfo_))
+    , uniformBlockInfo_(std::move(other.uniformBlockInfo_))
+    , shadowSlots_(std::move(other.shadowSlots_))
+    , shadowData_(std::move(other.shadowData_))
+    , shadowKnown_(std::move(other.shadowKnown_))
 {
     other.program_ = 0;
 }
@@ -116,7 +241,12 @@ ShaderProgram& ShaderProgram::operator=(ShaderProgram&& other)
     attachedShaders_ = std::move(other.attachedShaders_);
     attribLocations_ = std::move(other.attribLocations_);
     uniformLocations_ = std::move(other.uniformLocations_);
+    attributeInfo_ = std::move(other.attributeInfo_);
     uniformInfo_ = std::move(other.uniformInfo_);
+    uniformBlockInfo_ = std::move(other.uniformBlockInfo_);
+    shadowSlots_ = std::move(other.shadowSlots_);
+    shadowData_ = std::move(other.shadowData_);
+    shadowKnown_ = std::move(other.shadowKnown_);
     return *this;
 }
 
@@ -150,9 +280,27 @@ void ShaderProgram::detach()
 }
 
 ShaderResult ShaderProgram::link()
+{
+    startLink();
+    return getLinkResult();
+}
+
+void ShaderProgram::startLink() const
 {
     glLinkProgram(program_);
+}
+
+bool ShaderProgram::isLinkFinished() const
+{
+    if (!getParallelCompileSupported())
+        return true;
+    GLint completionStatus = GL_FALSE;
+    glGetProgramiv(program_, GL_COMPLETION_STATUS_KHR, &completionStatus);
+    return completionStatus == GL_TRUE;
+}
 
+ShaderResult ShaderProgram::getLinkResult()
+{
     GLint logLength = 0;
     glGetProgramiv(program_, GL_INFO_LOG_LENGTH, &logLength);
     std::string log;
@@ -163,11 +311,58 @@ ShaderResult ShaderProgram::link()
 
     GLint linkStatus;
     glGetProgramiv(program_, GL_LINK_STATUS, &linkStatus);
-    if (linkStatus == GL_TRUE)
+    if (linkStatus == GL_TRUE) {
+        retrieveAttributeInfo();
         retrieveUniformInfo();
+    }
     return ShaderResult(linkStatus == GL_TRUE, log);
 }
 
+bool ShaderProgram::getBinarySupported()
+{
+    if (!GLAD_GL_ARB_get_program_binary)
+        return false;
+    // Some drivers expose the extension, but don't support any formats
+    GLint numFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+    return numFormats > 0;
+}
+
+void ShaderProgram::setBinaryRetrievable(bool retrievable) const
+{
+    glProgramParameteri(
+        program_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, retrievable ? GL_TRUE : GL_FALSE);
+}
+
+std::optional<ShaderProgram::Binary> ShaderProgram::getBinary() const
+{
+    GLint length = 0;
+    glGetProgramiv(program_, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return std::nullopt;
+    Binary binary { 0, std::vector<uint8_t>(static_cast<size_t>(length)) };
+    GLsizei written = 0;
+    glGetProgramBinary(program_, length, &written, &binary.format, binary.data.data());
+    if (written <= 0)
+        return std::nullopt;
+    binary.data.resize(static_cast<size_t>(written));
+    return binary;
+}
+
+ShaderResult ShaderProgram::loadBinary(const Binary& binary)
+{
+    glProgramBinary(program_, binary.format, binary.data.data(),
+        static_cast<GLsizei>(binary.data.size()));
+
+    GLint linkStatus;
+    glGetProgramiv(program_, GL_LINK_STATUS, &linkStatus);
+    if (linkStatus != GL_TRUE)
+        return ShaderResult(false, "Program binary was rejected");
+    retrieveAttributeInfo();
+    retrieveUniformInfo();
+    return ShaderResult(true, "");
+}
+
 ShaderProgram::AttributeLocation ShaderProgram::getAttributeLocation(const std::string& name) const
 {
     const auto it = attribLocations_.find(name);
@@ -180,16 +375,19 @@ ShaderProgram::AttributeLocation ShaderProgram::getAttributeLocation(const std::
     }
 }
 
-ShaderProgram::UniformLocation ShaderProgram::getUniformLocation(const std::string& name) const
+const std::unordered_map<std::string, AttributeInfo>& ShaderProgram::getAttributeInfo() const
 {
-    const auto it = uniformLocations_.find(name);
-    if (it == uniformLocations_.end()) {
-        const auto loc = glGetUniformLocation(program_, name.c_str());
-        uniformLocations_.emplace(name, loc);
-        return loc;
-    } else {
-        return it->second;
-    }
+    return attributeInfo_;
+}
+
+ShaderProgram::UniformLocation ShaderProgram::getUniformLocation(UniformName name) const
+{
+    if (const auto loc = uniformLocations_.find(name.getHash()))
+        return *loc;
+    // The name might not be null-terminated
+    const auto loc = glGetUniformLocation(program_, std::string(name.getName()).c_str());
+    uniformLocations_.insert(name.getHash(), loc);
+    return loc;
 }
 
 const std::unordered_map<std::string, UniformInfo>& ShaderProgram::getUniformInfo() const
@@ -197,6 +395,36 @@ const std::unordered_map<std::string, UniformInfo>& ShaderProgram::getUniformInf
     return uniformInfo_;
 }
 
+const std::unordered_map<std::string, UniformBlockInfo>& ShaderProgram::getUniformBlockInfo() const
+{
+    return uniformBlockInfo_;
+}
+
+const UniformBlockInfo* ShaderProgram::getUniformBlockInfo(const std::string& name) const
+{
+    const auto it = uniformBlockInfo_.find(name);
+    return it != uniformBlockInfo_.end() ? &it->second : nullptr;
+}
+
+void ShaderProgram::setUniformBlockBinding(GLuint blockIndex, GLuint binding)
+{
+    glUniformBlockBinding(program_, blockIndex, binding);
+    for (auto& [name, block] : uniformBlockInfo_) {
+        if (block.index == blockIndex)
+            block.binding = binding;
+    }
+}
+
+bool ShaderProgram::setUniformBlockBinding(const std::string& blockName, GLuint binding)
+{
+    const auto it = uniformBlockInfo_.find(blockName);
+    if (it == uniformBlockInfo_.end())
+        return false;
+    glUniformBlockBinding(program_, it->second.index, binding);
+    it->second.binding = binding;
+    return true;
+}
+
 void ShaderProgram::bind() const
 {
     glw::State::instance().bindShader(program_);
@@ -214,102 +442,310 @@ GLuint ShaderProgram::getProgram() const
 
 void ShaderProgram::setUniform(UniformLocation loc, int value) const
 {
+    if (!updateShadow(loc, &value, sizeof(value)))
+        return;
     bind();
     glUniform1i(loc, value);
 }
 
-void ShaderProgram::setUniform(UniformLocation loc, const int* vals, size_t count)
+void ShaderProgram::setUniform(UniformLocation loc, const int* vals, size_t count) const
 {
+    if (!updateShadow(loc, vals, sizeof(int) * count))
+        return;
     bind();
     glUniform1iv(loc, static_cast<GLsizei>(count), vals);
 }
 
 void ShaderProgram::setUniform(UniformLocation loc, float value) const
 {
+    if (!updateShadow(loc, &value, sizeof(value)))
+        return;
     bind();
     glUniform1f(loc, value);
 }
 
 void ShaderProgram::setUniform(UniformLocation loc, const float* vals, size_t count) const
 {
+    if (!updateShadow(loc, vals, sizeof(float) * count))
+        return;
     bind();
     glUniform1fv(loc, static_cast<GLsizei>(count), vals);
 }
 
 void ShaderProgram::setUniform(UniformLocation loc, const glm::vec2& val) const
 {
+    if (!updateShadow(loc, &val, sizeof(val)))
+        return;
     bind();
     glUniform2fv(loc, 1, glm::value_ptr(val));
 }
 
 void ShaderProgram::setUniform(UniformLocation loc, const glm::vec2* vals, size_t count) const
 {
+    if (!updateShadow(loc, vals, sizeof(glm::vec2) * count))
+        return;
     bind();
     glUniform2fv(loc, static_cast<GLsizei>(count), glm::value_ptr(*vals));
 }
 
 void ShaderProgram::setUniform(UniformLocation loc, const glm::vec3& val) const
 {
+    if (!updateShadow(loc, &val, sizeof(val)))
+        return;
     bind();
     glUniform3fv(loc, 1, glm::value_ptr(val));
 }
 
 void ShaderProgram::setUniform(UniformLocation loc, const glm::vec3* vals, size_t count) const
 {
+    if (!updateShadow(loc, vals, sizeof(glm::vec3) * count))
+        return;
     bind();
     glUniform3fv(loc, static_cast<GLsizei>(count), glm::value_ptr(*vals));
 }
 
 void ShaderProgram::setUniform(UniformLocation loc, const glm::vec4& val) const
 {
+    if (!updateShadow(loc, &val, sizeof(val)))
+        return;
     bind();
     glUniform4fv(loc, 1, glm::value_ptr(val));
 }
 
 void ShaderProgram::setUniform(UniformLocation loc, const glm::vec4* vals, size_t count) const
 {
+    if (!updateShadow(loc, vals, sizeof(glm::vec4) * count))
+        return;
     bind();
     glUniform4fv(loc, static_cast<GLsizei>(count), glm::value_ptr(*vals));
 }
 
 void ShaderProgram::setUniform(UniformLocation loc, const glm::mat2& val) const
 {
+    if (!updateShadow(loc, &val, sizeof(val)))
+        return;
     bind();
     glUniformMatrix2fv(loc, 1, GL_FALSE, glm::value_ptr(val));
 }
 
 void ShaderProgram::setUniform(UniformLocation loc, const glm::mat2* vals, size_t count) const
 {
+    if (!updateShadow(loc, vals, sizeof(glm::mat2) * count))
+        return;
     bind();
     glUniformMatrix2fv(loc, static_cast<GLsizei>(count), GL_FALSE, glm::value_ptr(*vals));
 }
 
 void ShaderProgram::setUniform(UniformLocation loc, const glm::mat3& val) const
 {
+    if (!updateShadow(loc, &val, sizeof(val)))
+        return;
     bind();
     glUniformMatrix3fv(loc, 1, GL_FALSE, glm::value_ptr(val));
 }
 
 void ShaderProgram::setUniform(UniformLocation loc, const glm::mat3* vals, size_t count) const
 {
+    if (!updateShadow(loc, vals, sizeof(glm::mat3) * count))
+        return;
     bind();
     glUniformMatrix3fv(loc, static_cast<GLsizei>(count), GL_FALSE, glm::value_ptr(*vals));
 }
 
 void ShaderProgram::setUniform(UniformLocation loc, const glm::mat4& val) const
 {
+    if (!updateShadow(loc, &val, sizeof(val)))
+        return;
     bind();
     glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(val));
 }
 
 void ShaderProgram::setUniform(UniformLocation loc, const glm::mat4* vals, size_t count) const
 {
+    if (!updateShadow(loc, vals, sizeof(glm::mat4) * count))
+        return;
     bind();
     glUniformMatrix4fv(loc, static_cast<GLsizei>(count), GL_FALSE, glm::value_ptr(*vals));
 }
 
+void ShaderProgram::setUniform(UniformLocation loc, const Texture& tex) const
+{
+    setUniform(loc, static_cast<int>(tex.bind()));
+}
+
+void ShaderProgram::setUniform(UniformLocation loc, const Texture& tex, unsigned int unit) const
+{
+    tex.bind(unit);
+    setUniform(loc, static_cast<int>(unit));
+}
+
+void ShaderProgram::copyUniformValues(const ShaderProgram& other) const
+{
+    using T = UniformInfo::Type;
+    std::vector<uint8_t> values;
+    for (const auto& [name, info] : other.uniformInfo_) {
+        // Arrays are in there twice
+        if (name != info.name)
+            continue;
+        const auto it = uniformInfo_.find(name);
+        if (it == uniformInfo_.end() || it->second.type != info.type)
+            continue;
+        const auto otherLoc = other.getUniformLocation(UniformName(name));
+        const auto loc = getUniformLocation(UniformName(name));
+        if (otherLoc < 0 || static_cast<size_t>(otherLoc) >= other.shadowSlots_.size() || loc < 0)
+            continue;
+        const auto& slot = other.shadowSlots_[otherLoc];
+        const auto elemSize = getUniformTypeSize(info.type);
+        // Only the elements up to the first one that was never set
+        size_t count = 0;
+        const auto maxCount = std::min<size_t>(slot.size / elemSize, it->second.size);
+        while (count < maxCount && other.shadowKnown_[slot.element + count])
+            count++;
+        if (count == 0)
+            continue;
+        // Copy them out, so the setUniform below can update our shadow copy from it
+        values.assign(other.shadowData_.data() + slot.offset,
+            other.shadowData_.data() + slot.offset + count * elemSize);
+        const auto data = values.data();
+        switch (info.type) {
+        case T::Float:
+            setUniform(loc, reinterpret_cast<const float*>(data), count);
+            break;
+        case T::Vec2:
+            setUniform(loc, reinterpret_cast<const glm::vec2*>(data), count);
+            break;
+        case T::Vec3:
+            setUniform(loc, reinterpret_cast<const glm::vec3*>(data), count);
+            break;
+        case T::Vec4:
+            setUniform(loc, reinterpret_cast<const glm::vec4*>(data), count);
+            break;
+        case T::Mat2:
+            setUniform(loc, reinterpret_cast<const glm::mat2*>(data), count);
+            break;
+        case T::Mat3:
+            setUniform(loc, reinterpret_cast<const glm::mat3*>(data), count);
+            break;
+        case T::Mat4:
+            setUniform(loc, reinterpret_cast<const glm::mat4*>(data), count);
+            break;
+        case T::Double:
+        case T::IVec2:
+        case T::IVec3:
+        case T::IVec4:
+        case T::UInt:
+        case T::UVec2:
+        case T::UVec3:
+        case T::UVec4:
+        case T::BVec2:
+        case T::BVec3:
+        case T::BVec4:
+        case T::Mat2x3:
+        case T::Mat2x4:
+        case T::Mat3x2:
+        case T::Mat3x4:
+        case T::Mat4x2:
+        case T::Mat4x3:
+            break;
+        default:
+            // int, bool and samplers
+            setUniform(loc, reinterpret_cast<const int*>(data), count);
+            break;
+        }
+    }
+}
+
+void ShaderProgram::addShadowSlots(const UniformInfo& info)
+{
+    const auto elemSize = getUniformTypeSize(info.type);
+    const auto count = static_cast<size_t>(std::max(info.size, 1));
+    const auto offset = shadowData_.size();
+    const auto element = shadowKnown_.size();
+    shadowData_.resize(offset + elemSize * count);
+    shadowKnown_.resize(element + count, 0);
+    // The elements of an array are not guaranteed to have consecutive locations, so ask for each
+    const auto baseName = info.name.substr(0, info.name.find('['));
+    for (size_t i = 0; i < count; ++i) {
+        auto loc = info.location;
+        if (i > 0) {
+            const auto elementName = baseName + "[" + std::to_string(i) + "]";
+            loc = glGetUniformLocation(program_, elementName.c_str());
+        }
+        if (loc < 0 || static_cast<size_t>(loc) >= maxShadowLocation)
+            continue;
+        if (static_cast<size_t>(loc) >= shadowSlots_.size())
+            shadowSlots_.resize(loc + 1);
+        shadowSlots_[loc] = ShadowSlot {
+            static_cast<uint32_t>(offset + elemSize * i),
+            static_cast<uint32_t>(elemSize * (count - i)),
+            static_cast<uint32_t>(elemSize),
+            static_cast<uint32_t>(element + i),
+        };
+    }
+}
+
+bool ShaderProgram::updateShadow(UniformLocation loc, const void* data, size_t size) const
+{
+    auto& stats = State::instance().getStatistics();
+    if (loc < 0 || static_cast<size_t>(loc) >= shadowSlots_.size()) {
+        stats.uniformUpdates++;
+        return true;
+    }
+    const auto& slot = shadowSlots_[loc];
+    // Writing past the end of the uniform or with the wrong type is an error anyway (and does not
+    // change anything), so just pass it through
+    if (size > slot.size || slot.elementSize == 0 || size % slot.elementSize != 0) {
+        stats.uniformUpdates++;
+        return true;
+    }
+    auto shadow = shadowData_.data() + slot.offset;
+    const auto known = shadowKnown_.begin() + slot.element;
+    const auto count = size / slot.elementSize;
+    if (std::all_of(known, known + count, [](uint8_t k) { return k != 0; })
+        && std::memcmp(shadow, data, size) == 0) {
+        stats.uniformUpdatesSkipped++;
+        return false;
+    }
+    std::memcpy(shadow, data, size);
+    std::fill(known, known + count, 1);
+    stats.uniformUpdates++;
+    return true;
+}
+
+void ShaderProgram::retrieveAttributeInfo()
+{
+    attributeInfo_.clear();
+    attribLocations_.clear();
+    GLint maxNameLength = 0;
+    glGetProgramiv(program_, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxNameLength);
+    std::string name;
+    GLint activeAttributeCount = 0;
+    glGetProgramiv(program_, GL_ACTIVE_ATTRIBUTES, &activeAttributeCount);
+    for (int i = 0; i < activeAttributeCount; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        name.assign(maxNameLength, '\0');
+        glGetActiveAttrib(program_, i, maxNameLength, &length, &size, &type, name.data());
+        name.resize(std::max(length, 0));
+        // Some drivers list gl_VertexID and friends
+        if (name.empty() || name.starts_with("gl_"))
+            continue;
+        const auto loc = glGetAttribLocation(program_, name.c_str());
+        attributeInfo_.emplace(
+            name, AttributeInfo { name, i, size, static_cast<AttributeInfo::Type>(type), loc });
+        attribLocations_.emplace(name, loc);
+    }
+}
+
 void ShaderProgram::retrieveUniformInfo()
 {
+    // The locations might have changed, if the program was linked before
+    uniformInfo_.clear();
+    uniformLocations_.clear();
+    shadowSlots_.clear();
+    shadowData_.clear();
+    shadowKnown_.clear();
     GLint maxUniformNameLength = 0;
     glGetProgramiv(program_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxUniformNameLength);
     std::string name(maxUniformNameLength, '\0');
@@ -323,8 +759,14 @@ void ShaderProgram::retrieveUniformInfo()
         glGetActiveUniform(program_, i, maxUniformNameLength, &length, &size, &type, name.data());
         if (length > 0) {
             name.resize(length);
-            const auto info = UniformInfo { name, i, size, static_cast<UniformInfo::Type>(type) };
+            // Uniforms in uniform blocks have no location
+            const auto loc = glGetUniformLocation(program_, name.c_str());
+            const auto info
+                = UniformInfo { name, i, size, static_cast<UniformInfo::Type>(type), loc };
             uniformInfo_.emplace(name, info);
+            uniformLocations_.insert(hashUniformName(name), loc);
+            if (loc >= 0)
+                addShadowSlots(info);
 
             // For arrays the name will include '[0]' (and only that).
             // So we insert another entry without this silly index, because the query-by-name API
@@ -334,9 +776,87 @@ void ShaderProgram::retrieveUniformInfo()
             const auto bracket = name.find('[');
             if (bracket != std::string::npos) {
                 uniformInfo_.emplace(name.substr(0, bracket), info);
+                uniformLocations_.insert(hashUniformName(name.substr(0, bracket)), loc);
             }
         }
     }
+    retrieveUniformBlockInfo();
+}
+
+void ShaderProgram::retrieveUniformBlockInfo()
+{
+    uniformBlockInfo_.clear();
+    GLint blockCount = 0;
+    glGetProgramiv(program_, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    if (blockCount == 0)
+        return;
+
+    // The member names and types are already in uniformInfo_, we just need them by index
+    GLint activeUniformCount = 0;
+    glGetProgramiv(program_, GL_ACTIVE_UNIFORMS, &activeUniformCount);
+    std::vector<const UniformInfo*> uniformsByIndex(activeUniformCount, nullptr);
+    for (const auto& [key, info] : uniformInfo_) {
+        if (key == info.name && info.index >= 0 && info.index < activeUniformCount)
+            uniformsByIndex[info.index] = &info;
+    }
+
+    GLint maxNameLength = 0;
+    glGetProgramiv(program_, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxNameLength);
+    std::string name;
+    for (GLuint b = 0; b < static_cast<GLuint>(blockCount); ++b) {
+        name.assign(maxNameLength, '\0');
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(program_, b, maxNameLength, &length, name.data());
+        if (length <= 0)
+            continue;
+        name.resize(length);
+
+        GLint dataSize = 0, binding = 0, memberCount = 0;
+        glGetActiveUniformBlockiv(program_, b, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+        glGetActiveUniformBlockiv(program_, b, GL_UNIFORM_BLOCK_BINDING, &binding);
+        glGetActiveUniformBlockiv(program_, b, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &memberCount);
+        auto& block = uniformBlockInfo_[name];
+        block.name = name;
+        block.index = b;
+        block.size = static_cast<size_t>(dataSize);
+        block.binding = static_cast<GLuint>(binding);
+        if (memberCount <= 0)
+            continue;
+
+        std::vector<GLint> indices(memberCount);
+        glGetActiveUniformBlockiv(
+            program_, b, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, indices.data());
+        const std::vector<GLuint> uindices(indices.begin(), indices.end());
+        const auto query = [&](GLenum pname) {
+            std::vector<GLint> values(memberCount);
+            glGetActiveUniformsiv(program_, memberCount, uindices.data(), pname, values.data());
+            return values;
+        };
+        const auto offsets = query(GL_UNIFORM_OFFSET);
+        const auto arrayStrides = query(GL_UNIFORM_ARRAY_STRIDE);
+        const auto matrixStrides = query(GL_UNIFORM_MATRIX_STRIDE);
+        const auto rowMajor = query(GL_UNIFORM_IS_ROW_MAJOR);
+
+        for (GLint m = 0; m < memberCount; ++m) {
+            const auto index = indices[m];
+            if (index < 0 || index >= activeUniformCount || !uniformsByIndex[index])
+                continue;
+            const auto& uniform = *uniformsByIndex[index];
+            const auto member = UniformBlockInfo::Member {
+                uniform.name,
+                uniform.type,
+                uniform.size,
+                static_cast<size_t>(offsets[m]),
+                static_cast<size_t>(std::max(arrayStrides[m], 0)),
+                static_cast<size_t>(std::max(matrixStrides[m], 0)),
+                rowMajor[m] != 0,
+            };
+            block.members.emplace(uniform.name, member);
+            const auto bracket = uniform.name.find('[');
+            if (bracket != std::string::npos)
+                block.members.emplace(uniform.name.substr(0, bracket), member);
+        }
+    }
 }
 
 }
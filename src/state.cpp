@@ -1,7 +1,11 @@
 #include "glw/state.hpp"
 
+#include "glw/utility.hpp"
+
 namespace glw {
 namespace {
+    thread_local State* currentState = nullptr;
+
     void setEnabled(GLenum capability, bool enabled)
     {
         if (enabled) {
@@ -12,10 +16,74 @@ namespace {
     }
 }
 
+PipelineState::PipelineState(const Desc& desc)
+    : desc_(desc)
+    , hash_(hash(desc))
+{
+}
+
+const PipelineState::Desc& PipelineState::getDesc() const
+{
+    return desc_;
+}
+
+size_t PipelineState::getHash() const
+{
+    return hash_;
+}
+
+bool PipelineState::operator==(const PipelineState& other) const
+{
+    return hash_ == other.hash_ && desc_ == other.desc_;
+}
+
+size_t PipelineState::hash(const Desc& desc)
+{
+    size_t seed = 0;
+    const auto combine = [&seed](const auto&... values) { (hashCombine(seed, values), ...); };
+    const auto combineStencil = [&combine](const StencilFaceState& face) {
+        combine(face.func, face.ref, face.readMask, face.writeMask, face.stencilFail,
+            face.depthFail, face.depthPass);
+    };
+    combine(desc.depth.test, desc.depth.write, desc.depth.func);
+    combine(desc.cull.enabled, desc.cull.mode, desc.cull.frontFace);
+    const auto& [r, g, b, a] = desc.blend.color;
+    combine(desc.blend.enabled, desc.blend.func.srcRgb, desc.blend.func.srcAlpha,
+        desc.blend.func.dstRgb, desc.blend.func.dstAlpha, desc.blend.equation.rgb,
+        desc.blend.equation.a, r, g, b, a);
+    combine(desc.colorMask.r, desc.colorMask.g, desc.colorMask.b, desc.colorMask.a);
+    combine(desc.stencil.enabled);
+    combineStencil(desc.stencil.front);
+    combineStencil(desc.stencil.back);
+    combine(desc.scissor.enabled, desc.scissor.x, desc.scissor.y, desc.scissor.width,
+        desc.scissor.height);
+    combine(desc.polygonOffset.enabled, desc.polygonOffset.factor, desc.polygonOffset.units);
+    return seed;
+}
+
 State& State::instance()
 {
-    static State inst;
-    return inst;
+    if (!currentState) {
+        thread_local State defaultState;
+        currentState = &defaultState;
+    }
+    return *currentState;
+}
+
+State* State::getCurrent()
+{
+    return currentState;
+}
+
+void State::setCurrent(State* state)
+{
+    currentState = state;
+}
+
+State::~State()
+{
+    if (currentState == this)
+        currentState = nullptr;
 }
 
 void State::resetStatistics()
@@ -27,6 +95,16 @@ State::Statistics& State::getStatistics()
     return statistics_;
 }
 
+bool State::getDirectStateAccess() const
+{
+    return directStateAccess_ && GLAD_GL_ARB_direct_state_access;
+}
+
+void State::setDirectStateAccess(bool enabled)
+{
+    directStateAccess_ = enabled;
+}
+
 std::tuple<int, int, size_t, size_t> State::getViewport() const
 {
     return viewport_;
@@ -49,96 +127,230 @@ void State::setViewport(size_t width, size_t height)
     setViewport(0, 0, width, height);
 }
 
+void State::apply(const PipelineState& pipelineState)
+{
+    // This is the number of calls a full apply would issue
+    constexpr size_t maxCalls = 22;
+    if (appliedPipelineState_ && *appliedPipelineState_ == pipelineState) {
+        statistics_.pipelineStateCallsElided += maxCalls;
+        return;
+    }
+
+    size_t calls = 0;
+    // Updates the current value and calls `issue` only if the value changed
+    const auto update = [&calls](auto& current, const auto& target, auto&& issue) {
+        if (current == target)
+            return;
+        issue(target);
+        current = target;
+        calls++;
+    };
+
+    const auto& desc = pipelineState.getDesc();
+    auto& cur = pipeline_;
+
+    update(cur.depth.test, desc.depth.test, [](bool v) { setEnabled(GL_DEPTH_TEST, v); });
+    update(cur.depth.write, desc.depth.write, [](bool v) { glDepthMask(v ? GL_TRUE : GL_FALSE); });
+    if (desc.depth.test)
+        update(cur.depth.func, desc.depth.func,
+            [](DepthFunc v) { glDepthFunc(static_cast<GLenum>(v)); });
+
+    update(cur.cull.enabled, desc.cull.enabled, [](bool v) { setEnabled(GL_CULL_FACE, v); });
+    // The front face also determines gl_FrontFacing and which stencil state is used
+    update(cur.cull.frontFace, desc.cull.frontFace,
+        [](FrontFaceMode v) { glFrontFace(static_cast<GLenum>(v)); });
+    if (desc.cull.enabled)
+        update(cur.cull.mode, desc.cull.mode,
+            [](FaceCullMode v) { glCullFace(static_cast<GLenum>(v)); });
+
+    update(cur.blend.enabled, desc.blend.enabled, [](bool v) { setEnabled(GL_BLEND, v); });
+    if (desc.blend.enabled) {
+        update(cur.blend.func, desc.blend.func, [](const BlendFuncSeparate& v) {
+            glBlendFuncSeparate(static_cast<GLenum>(v.srcRgb), static_cast<GLenum>(v.dstRgb),
+                static_cast<GLenum>(v.srcAlpha), static_cast<GLenum>(v.dstAlpha));
+        });
+        update(cur.blend.equation, desc.blend.equation, [](const BlendEquationRgba& v) {
+            glBlendEquationSeparate(static_cast<GLenum>(v.rgb), static_cast<GLenum>(v.a));
+        });
+        update(cur.blend.color, desc.blend.color,
+            [](const std::tuple<float, float, float, float>& v) {
+                glBlendColor(std::get<0>(v), std::get<1>(v), std::get<2>(v), std::get<3>(v));
+            });
+    }
+
+    update(cur.colorMask, desc.colorMask, [](const PipelineState::Desc::ColorMask& v) {
+        glColorMask(v.r ? GL_TRUE : GL_FALSE, v.g ? GL_TRUE : GL_FALSE, v.b ? GL_TRUE : GL_FALSE,
+            v.a ? GL_TRUE : GL_FALSE);
+    });
+
+    update(cur.stencil.enabled, desc.stencil.enabled,
+        [](bool v) { setEnabled(GL_STENCIL_TEST, v); });
+    for (const GLenum face : { GL_FRONT, GL_BACK }) {
+        auto& current = face == GL_FRONT ? cur.stencil.front : cur.stencil.back;
+        const auto& target = face == GL_FRONT ? desc.stencil.front : desc.stencil.back;
+        update(current.writeMask, target.writeMask,
+            [face](GLuint v) { glStencilMaskSeparate(face, v); });
+        if (!desc.stencil.enabled)
+            continue;
+        if (current.func != target.func || current.ref != target.ref
+            || current.readMask != target.readMask) {
+            glStencilFuncSeparate(
+                face, static_cast<GLenum>(target.func), target.ref, target.readMask);
+            current.func = target.func;
+            current.ref = target.ref;
+            current.readMask = target.readMask;
+            calls++;
+        }
+        if (current.stencilFail != target.stencilFail || current.depthFail != target.depthFail
+            || current.depthPass != target.depthPass) {
+            glStencilOpSeparate(face, static_cast<GLenum>(target.stencilFail),
+                static_cast<GLenum>(target.depthFail), static_cast<GLenum>(target.depthPass));
+            current.stencilFail = target.stencilFail;
+            current.depthFail = target.depthFail;
+            current.depthPass = target.depthPass;
+            calls++;
+        }
+    }
+
+    update(cur.scissor.enabled, desc.scissor.enabled,
+        [](bool v) { setEnabled(GL_SCISSOR_TEST, v); });
+    if (desc.scissor.enabled && cur.scissor != desc.scissor) {
+        glScissor(desc.scissor.x, desc.scissor.y, static_cast<GLsizei>(desc.scissor.width),
+            static_cast<GLsizei>(desc.scissor.height));
+        cur.scissor = desc.scissor;
+        calls++;
+    }
+
+    update(cur.polygonOffset.enabled, desc.polygonOffset.enabled,
+        [](bool v) { setEnabled(GL_POLYGON_OFFSET_FILL, v); });
+    if (desc.polygonOffset.enabled && cur.polygonOffset != desc.polygonOffset) {
+        glPolygonOffset(desc.polygonOffset.factor, desc.polygonOffset.units);
+        cur.polygonOffset = desc.polygonOffset;
+        calls++;
+    }
+
+    assert(calls <= maxCalls);
+    statistics_.pipelineStateCalls += calls;
+    statistics_.pipelineStateCallsElided += maxCalls - calls;
+    appliedPipelineState_ = pipelineState;
+}
+
+const PipelineState::Desc& State::getPipelineState() const
+{
+    return pipeline_;
+}
+
+bool State::getDepthTestEnabled() const
+{
+    return pipeline_.depth.test;
+}
+
+void State::setDepthTestEnabled(bool enabled)
+{
+    if (pipeline_.depth.test == enabled)
+        return;
+    setEnabled(GL_DEPTH_TEST, enabled);
+    pipeline_.depth.test = enabled;
+    appliedPipelineState_.reset();
+}
+
 DepthFunc State::getDepthFunc() const
 {
-    return depthFunc_;
+    return pipeline_.depth.func;
 }
 
 void State::setDepthFunc(DepthFunc func)
 {
-    if (depthFunc_ == func)
+    if (pipeline_.depth.func == func)
         return;
     glDepthFunc(static_cast<GLenum>(func));
-    depthFunc_ = func;
+    pipeline_.depth.func = func;
+    appliedPipelineState_.reset();
 }
 
 bool State::getDepthWrite() const
 {
-    return depthWrite_;
+    return pipeline_.depth.write;
 }
 
 void State::setDepthWrite(bool write)
 {
-    if (depthWrite_ == write)
+    if (pipeline_.depth.write == write)
         return;
     glDepthMask(write ? GL_TRUE : GL_FALSE);
-    depthWrite_ = write;
+    pipeline_.depth.write = write;
+    appliedPipelineState_.reset();
 }
 
 bool State::getCullFaceEnabled() const
 {
-    return cullFaceEnabled_;
+    return pipeline_.cull.enabled;
 }
 
 void State::setCullFaceEnabled(bool enabled)
 {
-    if (cullFaceEnabled_ == enabled)
+    if (pipeline_.cull.enabled == enabled)
         return;
     setEnabled(GL_CULL_FACE, enabled);
-    cullFaceEnabled_ = enabled;
+    pipeline_.cull.enabled = enabled;
+    appliedPipelineState_.reset();
 }
 
 FrontFaceMode State::getFrontFaceMode() const
 {
-    return frontFaceMode_;
+    return pipeline_.cull.frontFace;
 }
 
 void State::setFrontFaceMode(FrontFaceMode mode)
 {
-    if (frontFaceMode_ == mode)
+    if (pipeline_.cull.frontFace == mode)
         return;
     glFrontFace(static_cast<GLenum>(mode));
-    frontFaceMode_ = mode;
+    pipeline_.cull.frontFace = mode;
+    appliedPipelineState_.reset();
 }
 
 FaceCullMode State::getFaceCullMode() const
 {
-    return faceCullMode_;
+    return pipeline_.cull.mode;
 }
 
 void State::setFaceCullMode(FaceCullMode mode)
 {
-    if (faceCullMode_ == mode)
+    if (pipeline_.cull.mode == mode)
         return;
     glCullFace(static_cast<GLenum>(mode));
-    faceCullMode_ = mode;
+    pipeline_.cull.mode = mode;
+    appliedPipelineState_.reset();
 }
 
 bool State::getBlendEnabled() const
 {
-    return blendEnabled_;
+    return pipeline_.blend.enabled;
 }
 
 void State::setBlendEnabled(bool enabled)
 {
-    if (blendEnabled_ == enabled)
+    if (pipeline_.blend.enabled == enabled)
         return;
     setEnabled(GL_BLEND, enabled);
-    blendEnabled_ = enabled;
+    pipeline_.blend.enabled = enabled;
+    appliedPipelineState_.reset();
 }
 
 std::tuple<float, float, float, float> State::getBlendColor() const
 {
-    return blendColor_;
+    return pipeline_.blend.color;
 }
 
 void State::setBlendColor(float r, float g, float b, float a)
 {
     const auto color = std::tuple(r, g, b, a);
-    if (blendColor_ != color)
+    if (pipeline_.blend.color == color)
         return;
     glBlendColor(r, g, b, a);
-    blendColor_ = color;
+    pipeline_.blend.color = color;
+    appliedPipelineState_.reset();
 }
 
 void State::setBlendColor(const std::tuple<float, float, float, float>& color)
@@ -148,20 +360,20 @@ void State::setBlendColor(const std::tuple<float, float, float, float>& color)
 
 BlendFuncSeparate State::getBlendFunc() const
 {
-    return blendFunc_;
+    return pipeline_.blend.func;
 }
 
 void State::setBlendFunc(BlendFunc srcRgb, BlendFunc srcAlpha, BlendFunc dstRgb, BlendFunc dstAlpha)
 {
-    if (blendFunc_.srcRgb == srcRgb && blendFunc_.srcAlpha == srcAlpha
-        && blendFunc_.dstRgb == dstRgb && blendFunc_.dstAlpha == dstAlpha) {
+    const auto func = BlendFuncSeparate {
+        .srcRgb = srcRgb, .srcAlpha = srcAlpha, .dstRgb = dstRgb, .dstAlpha = dstAlpha
+    };
+    if (pipeline_.blend.func == func)
         return;
-    }
     glBlendFuncSeparate(static_cast<GLenum>(srcRgb), static_cast<GLenum>(dstRgb),
         static_cast<GLenum>(srcAlpha), static_cast<GLenum>(dstAlpha));
-    blendFunc_ = BlendFuncSeparate {
-        .srcRgb = srcRgb, .srcAlpha = srcAlpha, .dstRgb = dstRgb, .dstAlpha = dstAlpha
-    };
+    pipeline_.blend.func = func;
+    appliedPipelineState_.reset();
 }
 
 void State::setBlendFunc(const BlendFuncSeparate& func)
@@ -176,15 +388,17 @@ void State::setBlendFunc(BlendFunc src, BlendFunc dst)
 
 BlendEquationRgba State::getBlendEquation() const
 {
-    return blendEquation_;
+    return pipeline_.blend.equation;
 }
 
 void State::setBlendEquation(BlendEquation rgb, BlendEquation a)
 {
-    if (blendEquation_.rgb == rgb && blendEquation_.a == a)
+    const auto eq = BlendEquationRgba { .rgb = rgb, .a = a };
+    if (pipeline_.blend.equation == eq)
         return;
     glBlendEquationSeparate(static_cast<GLenum>(rgb), static_cast<GLenum>(a));
-    blendEquation_ = BlendEquationRgba { .rgb = rgb, .a = a };
+    pipeline_.blend.equation = eq;
+    appliedPipelineState_.reset();
 }
 
 void State::setBlendEquation(const BlendEquationRgba& eq)
@@ -252,15 +466,58 @@ void State::unbindBuffer(GLenum target)
     bindBuffer(target, 0);
 }
 
+bool State::updateIndexedBinding(GLenum target, unsigned int index, const IndexedBufferBinding& b)
+{
+    // Both glBindBufferBase and glBindBufferRange bind the generic target too
+    buffers_[getBufferIndex(target)] = b.buffer;
+    if (target != GL_UNIFORM_BUFFER)
+        return true;
+    if (index < uniformBuffers_.size()) {
+        if (uniformBuffers_[index] == b)
+            return false;
+        uniformBuffers_[index] = b;
+    }
+    statistics_.uniformBufferBinds++;
+    return true;
+}
+
+void State::bindBufferBase(GLenum target, unsigned int index, GLuint buffer)
+{
+    if (updateIndexedBinding(target, index, IndexedBufferBinding { buffer, 0, 0 }))
+        glBindBufferBase(target, index, buffer);
+}
+
+void State::bindBufferRange(
+    GLenum target, unsigned int index, GLuint buffer, size_t offset, size_t size)
+{
+    assert(size > 0);
+    if (updateIndexedBinding(target, index, IndexedBufferBinding { buffer, offset, size }))
+        glBindBufferRange(target, index, buffer, static_cast<GLintptr>(offset),
+            static_cast<GLsizeiptr>(size));
+}
+
+void State::bufferDeleted(GLuint buffer)
+{
+    for (auto& b : buffers_) {
+        if (b == buffer)
+            b = 0;
+    }
+    for (auto& b : uniformBuffers_) {
+        if (b.buffer == buffer)
+            b = IndexedBufferBinding {};
+    }
+}
+
 GLuint State::getCurrentTexture(unsigned int unit, GLenum target) const
 {
-    return textures_[unit][getTextureIndex(target)];
+    return textures_[getTextureIndex(target)][unit];
 }
 
 std::optional<unsigned int> State::getTextureUnit(GLenum target, GLuint texture) const
 {
-    for (size_t unit = 0; unit < textures_.size(); ++unit) {
-        if (getCurrentTexture(static_cast<unsigned int>(unit), target) == texture)
+    const auto& units = textures_[getTextureIndex(target)];
+    for (size_t unit = 0; unit < units.size(); ++unit) {
+        if (units[unit] == texture)
             return static_cast<unsigned int>(unit);
     }
     return std::nullopt;
@@ -268,20 +525,54 @@ std::optional<unsigned int> State::getTextureUnit(GLenum target, GLuint texture)
 
 void State::bindTexture(unsigned int unit, GLenum target, GLuint texture)
 {
-    auto& currentTexture = textures_[unit][getTextureIndex(target)];
+    assert(unit < maxTextureUnits);
+    textureUnitLastUse_[unit] = ++textureUnitClock_;
+    auto& currentTexture = textures_[getTextureIndex(target)][unit];
     if (currentTexture == texture)
         return;
-    glActiveTexture(GL_TEXTURE0 + unit);
+    if (activeTextureUnit_ != unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeTextureUnit_ = unit;
+    }
     glBindTexture(target, texture);
     currentTexture = texture;
     statistics_.textureBinds++;
 }
 
+unsigned int State::allocateTextureUnit(GLenum target, GLuint texture)
+{
+    assert(texture != 0);
+    const auto& units = textures_[getTextureIndex(target)];
+    // Unit 0 is for editing, see Texture::bind
+    const unsigned int firstUnit = 1;
+    auto lru = firstUnit;
+    for (auto unit = firstUnit; unit < maxTextureUnits; ++unit) {
+        if (units[unit] == texture) {
+            textureUnitLastUse_[unit] = ++textureUnitClock_;
+            return unit;
+        }
+        if (textureUnitLastUse_[unit] < textureUnitLastUse_[lru])
+            lru = unit;
+    }
+    bindTexture(lru, target, texture);
+    return lru;
+}
+
 void State::unbindTexture(unsigned int unit, GLenum target)
 {
     bindTexture(unit, target, 0);
 }
 
+void State::textureDeleted(GLuint texture)
+{
+    for (auto& units : textures_) {
+        for (auto& t : units) {
+            if (t == texture)
+                t = 0;
+        }
+    }
+}
+
 size_t State::getBufferIndex(GLenum target)
 {
     return getTargetIndex(bufferBindings, target);
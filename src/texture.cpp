@@ -3,9 +3,81 @@
 #include "glw/log.hpp"
 
 namespace glw {
+size_t Texture::getPixelSize(DataFormat dataFormat, DataType dataType)
+{
+    // Packed types contain all components
+    switch (dataType) {
+    case DataType::R3G3B2:
+    case DataType::B2G3R3:
+        return 1;
+    case DataType::R5G6B5:
+    case DataType::B5G6R5:
+    case DataType::R4G4B4A4:
+    case DataType::A4B4G4R4:
+    case DataType::R5G5B5A1:
+    case DataType::A1B5G5R5:
+        return 2;
+    case DataType::R8G8B8A8:
+    case DataType::A8B8G8R8:
+    case DataType::R10G10B10A2:
+    case DataType::A2B10G10R10:
+        return 4;
+    default:
+        break;
+    }
+
+    size_t components = 0;
+    switch (dataFormat) {
+    case DataFormat::Red:
+    case DataFormat::RedInteger:
+    case DataFormat::Stencil:
+    case DataFormat::Depth:
+    case DataFormat::DepthStencil:
+        components = 1;
+        break;
+    case DataFormat::Rg:
+    case DataFormat::RgInteger:
+        components = 2;
+        break;
+    case DataFormat::Rgb:
+    case DataFormat::Bgr:
+    case DataFormat::RgbInteger:
+    case DataFormat::BgrInteger:
+        components = 3;
+        break;
+    case DataFormat::Rgba:
+    case DataFormat::Bgra:
+    case DataFormat::RgbaInteger:
+    case DataFormat::BgraInteger:
+        components = 4;
+        break;
+    }
+
+    switch (dataType) {
+    case DataType::U8:
+    case DataType::S8:
+        return components;
+    case DataType::U16:
+    case DataType::S16:
+    case DataType::F16:
+        return components * 2;
+    case DataType::U32:
+    case DataType::I32:
+    case DataType::F32:
+        return components * 4;
+    default:
+        assert(false && "Unhandled data type");
+        return 0;
+    }
+}
+
 Texture::Texture(Target target)
     : target_(target)
 {
+    if (State::instance().getDirectStateAccess()) {
+        glCreateTextures(static_cast<GLenum>(target_), 1, &texture_);
+        return;
+    }
     glGenTextures(1, &texture_);
     // https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glBindTexture.xhtml
     // "When a texture is first bound, it assumes the specified target"...
@@ -22,7 +94,10 @@ Texture::Texture(Texture&& other)
     , texture_(other.texture_)
     , width_(other.width_)
     , height_(other.height_)
+    , depth_(other.depth_)
     , imageFormat_(other.imageFormat_)
+    , levels_(other.levels_)
+    , immutable_(other.immutable_)
 {
     other.reset();
 }
@@ -34,7 +109,10 @@ Texture& Texture::operator=(Texture&& other)
     texture_ = other.texture_;
     width_ = other.width_;
     height_ = other.height_;
+    depth_ = other.depth_;
     imageFormat_ = other.imageFormat_;
+    levels_ = other.levels_;
+    immutable_ = other.immutable_;
     other.reset();
     return *this;
 }
@@ -42,6 +120,8 @@ Texture& Texture::operator=(Texture&& other)
 void Texture::free() const
 {
     // silently ignores 0s
+    if (texture_)
+        State::instance().textureDeleted(texture_);
     glDeleteTextures(1, &texture_);
 }
 
@@ -50,17 +130,31 @@ void Texture::bind(unsigned int unit) const
     State::instance().bindTexture(unit, static_cast<GLenum>(target_), texture_);
 }
 
+unsigned int Texture::bind() const
+{
+    return State::instance().allocateTextureUnit(static_cast<GLenum>(target_), texture_);
+}
+
 void Texture::bind(unsigned int unit, Target target) const
 {
     State::instance().bindTexture(unit, static_cast<GLenum>(target), texture_);
 }
 
+bool Texture::storageSupported()
+{
+    return GLAD_GL_ARB_texture_storage;
+}
+
 void Texture::image(Target target, size_t level, ImageFormat imageFormat, size_t width,
     size_t height, DataFormat dataFormat, DataType dataType, const void* data)
 {
+    // Redefining a level of an immutable texture is an error
+    assert(!immutable_);
     imageFormat_ = imageFormat;
     width_ = width;
     height_ = height;
+    depth_ = 1;
+    // There is no DSA version of glTexImage2D (only of glTexStorage2D), so we have to bind
     bind(0);
     glTexImage2D(static_cast<GLenum>(target), static_cast<GLint>(level),
         static_cast<GLenum>(imageFormat), static_cast<GLsizei>(width), static_cast<GLsizei>(height),
@@ -82,6 +176,23 @@ void Texture::image(size_t level, ImageFormat imageFormat, size_t width, size_t
 void Texture::subImage(Target target, size_t level, size_t x, size_t y, size_t width, size_t height,
     DataFormat dataFormat, DataType dataType, const void* data) const
 {
+    if (State::instance().getDirectStateAccess()) {
+        const auto face = getCubeMapFace(target);
+        if (face) {
+            // With DSA the faces of a cube map are layers of a 3D image
+            glTextureSubImage3D(texture_, static_cast<GLint>(level), static_cast<GLint>(x),
+                static_cast<GLint>(y), static_cast<GLint>(*face), static_cast<GLsizei>(width),
+                static_cast<GLsizei>(height), 1, static_cast<GLenum>(dataFormat),
+                static_cast<GLenum>(dataType), data);
+        } else {
+            assert(target == target_);
+            glTextureSubImage2D(texture_, static_cast<GLint>(level), static_cast<GLint>(x),
+                static_cast<GLint>(y), static_cast<GLsizei>(width), static_cast<GLsizei>(height),
+                static_cast<GLenum>(dataFormat), static_cast<GLenum>(dataType), data);
+        }
+        return;
+    }
+
     bind(0);
     glTexSubImage2D(static_cast<GLenum>(target), static_cast<GLint>(level), static_cast<GLint>(x),
         static_cast<GLint>(y), static_cast<GLsizei>(width), static_cast<GLsizei>(height),
@@ -95,39 +206,125 @@ void Texture::subImage(DataFormat dataFormat, DataType dataType, const void* dat
 
 void Texture::subImage(size_t level, DataFormat dataFormat, DataType dataType, const void* data)
 {
-    subImage(target_, level, 0, 0, width_, height_, dataFormat, dataType, data);
+    const auto width = std::max(static_cast<size_t>(1), width_ >> level);
+    const auto height = std::max(static_cast<size_t>(1), height_ >> level);
+    subImage(target_, level, 0, 0, width, height, dataFormat, dataType, data);
+}
+
+void Texture::compressedImage(Target target, size_t level, ImageFormat imageFormat, size_t width,
+    size_t height, size_t imageSize, const void* data)
+{
+    assert(!immutable_);
+    imageFormat_ = imageFormat;
+    // Like image(), this describes level 0, so only update the size for that
+    if (level == 0) {
+        width_ = width;
+        height_ = height;
+        depth_ = 1;
+    }
+    bind(0);
+    glCompressedTexImage2D(static_cast<GLenum>(target), static_cast<GLint>(level),
+        static_cast<GLenum>(imageFormat), static_cast<GLsizei>(width),
+        static_cast<GLsizei>(height), 0, static_cast<GLsizei>(imageSize), data);
+}
+
+void Texture::compressedSubImage(Target target, size_t level, size_t x, size_t y, size_t width,
+    size_t height, size_t imageSize, const void* data) const
+{
+    const auto format = static_cast<GLenum>(imageFormat_);
+    if (State::instance().getDirectStateAccess()) {
+        const auto face = getCubeMapFace(target);
+        if (face) {
+            glCompressedTextureSubImage3D(texture_, static_cast<GLint>(level),
+                static_cast<GLint>(x), static_cast<GLint>(y), static_cast<GLint>(*face),
+                static_cast<GLsizei>(width), static_cast<GLsizei>(height), 1, format,
+                static_cast<GLsizei>(imageSize), data);
+        } else {
+            assert(target == target_);
+            glCompressedTextureSubImage2D(texture_, static_cast<GLint>(level),
+                static_cast<GLint>(x), static_cast<GLint>(y), static_cast<GLsizei>(width),
+                static_cast<GLsizei>(height), format, static_cast<GLsizei>(imageSize), data);
+        }
+        return;
+    }
+
+    bind(0);
+    glCompressedTexSubImage2D(static_cast<GLenum>(target), static_cast<GLint>(level),
+        static_cast<GLint>(x), static_cast<GLint>(y), static_cast<GLsizei>(width),
+        static_cast<GLsizei>(height), format, static_cast<GLsizei>(imageSize), data);
+}
+
+void Texture::compressedSubImage(size_t level, size_t imageSize, const void* data) const
+{
+    const auto width = std::max(static_cast<size_t>(1), width_ >> level);
+    const auto height = std::max(static_cast<size_t>(1), height_ >> level);
+    compressedSubImage(target_, level, 0, 0, width, height, imageSize, data);
 }
 
 size_t Texture::getMaxNumMipLevels() const
 {
-    return 1 + static_cast<size_t>(std::floor(std::log2(std::max(width_, height_))));
+    // The layers of an array texture are not mipmapped, but the depth of a 3D texture is
+    const auto depth = target_ == Target::Texture3D ? depth_ : 1;
+    return 1
+        + static_cast<size_t>(std::floor(std::log2(std::max({ width_, height_, depth }))));
 }
 
 void Texture::storage(
     Target target, size_t levels, ImageFormat imageFormat, size_t width, size_t height)
 {
     assert(width > 0 && height > 0);
-    imageFormat_ = imageFormat;
+    // https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glTexStorage2D.xhtml
+    assert(target == Target::Texture2D || target == Target::TextureRectangle
+        || target == Target::TextureCubeMap);
+    assert(!immutable_);
+    imageFormat_ = getSizedFormat(imageFormat);
     width_ = width;
     height_ = height;
+    depth_ = 1;
     if (levels == 0)
         levels = getMaxNumMipLevels();
+    levels_ = levels;
+
+    const auto format = static_cast<GLenum>(imageFormat_);
+    if (storageSupported()) {
+        immutable_ = true;
+        if (State::instance().getDirectStateAccess()) {
+            glTextureStorage2D(texture_, static_cast<GLsizei>(levels), format,
+                static_cast<GLsizei>(width), static_cast<GLsizei>(height));
+            return;
+        }
+        bind(0);
+        glTexStorage2D(static_cast<GLenum>(target), static_cast<GLsizei>(levels), format,
+            static_cast<GLsizei>(width), static_cast<GLsizei>(height));
+        return;
+    }
 
+    // This uses glTexImage2D, so even with DSA we have to bind
     bind(0);
-    // https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glTexStorage2D.xhtml
-    assert(target == Target::Texture2D || target == Target::TextureRectangle);
-    const auto format = static_cast<GLenum>(imageFormat);
-    const auto dataFormat = static_cast<GLenum>(getStorageFormat(imageFormat));
+    const auto dataFormat = static_cast<GLenum>(getStorageFormat(imageFormat_));
+    const auto faces = target == Target::TextureCubeMap ? 6 : 1;
     for (size_t level = 0; level < levels; ++level) {
-        glTexImage2D(static_cast<GLenum>(target), static_cast<GLint>(level), format,
-            static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, dataFormat, GL_FLOAT,
-            nullptr);
+        for (int face = 0; face < faces; ++face) {
+            const auto faceTarget = target == Target::TextureCubeMap
+                ? static_cast<GLenum>(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face)
+                : static_cast<GLenum>(target);
+            if (getCompressedBlockSize(imageFormat_) > 0) {
+                // glTexImage2D does not accept the specific compressed formats
+                glCompressedTexImage2D(faceTarget, static_cast<GLint>(level), format,
+                    static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0,
+                    static_cast<GLsizei>(getCompressedImageSize(imageFormat_, width, height)),
+                    nullptr);
+                continue;
+            }
+            glTexImage2D(faceTarget, static_cast<GLint>(level), format,
+                static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, dataFormat, GL_FLOAT,
+                nullptr);
+        }
         width = std::max(static_cast<size_t>(1), width / 2);
         height = std::max(static_cast<size_t>(1), height / 2);
     }
     // glTexStorage would do this too
-    glTexParameteri(
-        static_cast<GLenum>(target), GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels - 1));
+    setParameter(GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels - 1));
 }
 
 void Texture::storage(size_t levels, ImageFormat imageFormat, size_t width, size_t height)
@@ -135,11 +332,62 @@ void Texture::storage(size_t levels, ImageFormat imageFormat, size_t width, size
     storage(target_, levels, imageFormat, width, height);
 }
 
+void Texture::storage(
+    size_t levels, ImageFormat imageFormat, size_t width, size_t height, size_t depth)
+{
+    assert(width > 0 && height > 0 && depth > 0);
+    assert(target_ == Target::Texture3D || target_ == Target::Texture2DArray);
+    assert(!immutable_);
+    imageFormat_ = getSizedFormat(imageFormat);
+    width_ = width;
+    height_ = height;
+    depth_ = depth;
+    if (levels == 0)
+        levels = getMaxNumMipLevels();
+    levels_ = levels;
+
+    const auto format = static_cast<GLenum>(imageFormat_);
+    if (storageSupported()) {
+        immutable_ = true;
+        if (State::instance().getDirectStateAccess()) {
+            glTextureStorage3D(texture_, static_cast<GLsizei>(levels), format,
+                static_cast<GLsizei>(width), static_cast<GLsizei>(height),
+                static_cast<GLsizei>(depth));
+            return;
+        }
+        bind(0);
+        glTexStorage3D(static_cast<GLenum>(target_), static_cast<GLsizei>(levels), format,
+            static_cast<GLsizei>(width), static_cast<GLsizei>(height),
+            static_cast<GLsizei>(depth));
+        return;
+    }
+
+    bind(0);
+    const auto dataFormat = static_cast<GLenum>(getStorageFormat(imageFormat_));
+    for (size_t level = 0; level < levels; ++level) {
+        glTexImage3D(static_cast<GLenum>(target_), static_cast<GLint>(level), format,
+            static_cast<GLsizei>(width), static_cast<GLsizei>(height),
+            static_cast<GLsizei>(depth), 0, dataFormat, GL_FLOAT, nullptr);
+        width = std::max(static_cast<size_t>(1), width / 2);
+        height = std::max(static_cast<size_t>(1), height / 2);
+        if (target_ == Target::Texture3D)
+            depth = std::max(static_cast<size_t>(1), depth / 2);
+    }
+    setParameter(GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels - 1));
+}
+
 void Texture::generateMipmaps() const
 {
+    // Immutable textures can't grow more levels than they were allocated with
+    const auto levels = immutable_ ? levels_ : getMaxNumMipLevels();
+    const auto maxLevel = static_cast<GLint>(levels - 1);
+    if (State::instance().getDirectStateAccess()) {
+        glTextureParameteri(texture_, GL_TEXTURE_MAX_LEVEL, maxLevel);
+        glGenerateTextureMipmap(texture_);
+        return;
+    }
     bind(0);
-    glTexParameteri(static_cast<GLenum>(target_), GL_TEXTURE_MAX_LEVEL,
-        static_cast<GLint>(getMaxNumMipLevels() - 1));
+    glTexParameteri(static_cast<GLenum>(target_), GL_TEXTURE_MAX_LEVEL, maxLevel);
     glGenerateMipmap(static_cast<GLenum>(target_));
 }
 
@@ -193,12 +441,20 @@ void Texture::setBaseLevel(size_t level)
 
 void Texture::setBorderColor(const glm::vec4& color)
 {
+    if (State::instance().getDirectStateAccess()) {
+        glTextureParameterfv(texture_, GL_TEXTURE_BORDER_COLOR, &color.x);
+        return;
+    }
     bind(0);
     glTexParameterfv(static_cast<GLenum>(target_), GL_TEXTURE_BORDER_COLOR, &color.x);
 }
 
 void Texture::setBorderColor(const glm::ivec4& color)
 {
+    if (State::instance().getDirectStateAccess()) {
+        glTextureParameteriv(texture_, GL_TEXTURE_BORDER_COLOR, &color.x);
+        return;
+    }
     bind(0);
     glTexParameteriv(static_cast<GLenum>(target_), GL_TEXTURE_BORDER_COLOR, &color.x);
 }
@@ -255,9 +511,13 @@ void Texture::setSwizzleA(Swizzle swizzle)
 
 void Texture::setSwizzle(Swizzle r, Swizzle g, Swizzle b, Swizzle a)
 {
-    bind(0);
     const std::array<GLint, 4> swizzle = { static_cast<GLint>(r), static_cast<GLint>(g),
         static_cast<GLint>(b), static_cast<GLint>(a) };
+    if (State::instance().getDirectStateAccess()) {
+        glTextureParameteriv(texture_, GL_TEXTURE_SWIZZLE_RGBA, swizzle.data());
+        return;
+    }
+    bind(0);
     glTexParameteriv(static_cast<GLenum>(target_), GL_TEXTURE_SWIZZLE_RGBA, swizzle.data());
 }
 
@@ -281,11 +541,26 @@ size_t Texture::getHeight() const
     return height_;
 }
 
+size_t Texture::getDepth() const
+{
+    return depth_;
+}
+
 ImageFormat Texture::getImageFormat() const
 {
     return imageFormat_;
 }
 
+size_t Texture::getLevels() const
+{
+    return levels_;
+}
+
+bool Texture::isImmutable() const
+{
+    return immutable_;
+}
+
 Texture::DataFormat Texture::getStorageFormat(ImageFormat format)
 {
     if (hasDepth(format))
@@ -293,20 +568,35 @@ Texture::DataFormat Texture::getStorageFormat(ImageFormat format)
     return DataFormat::Rgba;
 }
 
+std::optional<size_t> Texture::getCubeMapFace(Target target)
+{
+    const auto t = static_cast<GLenum>(target);
+    if (t < GL_TEXTURE_CUBE_MAP_POSITIVE_X || t > GL_TEXTURE_CUBE_MAP_NEGATIVE_Z)
+        return std::nullopt;
+    return t - GL_TEXTURE_CUBE_MAP_POSITIVE_X;
+}
+
 void Texture::setParameter(GLenum param, GLint val)
 {
+    if (State::instance().getDirectStateAccess()) {
+        glTextureParameteri(texture_, param, val);
+        return;
+    }
     bind(0);
     glTexParameteri(static_cast<GLenum>(target_), param, val);
 }
 
 void Texture::setParameter(GLenum param, GLenum val)
 {
-    bind(0);
-    glTexParameteri(static_cast<GLenum>(target_), param, val);
+    setParameter(param, static_cast<GLint>(val));
 }
 
 void Texture::setParameter(GLenum param, float val)
 {
+    if (State::instance().getDirectStateAccess()) {
+        glTextureParameterf(texture_, param, val);
+        return;
+    }
     bind(0);
     glTexParameterf(static_cast<GLenum>(target_), param, val);
 }
@@ -317,6 +607,9 @@ void Texture::reset()
     texture_ = 0;
     width_ = 0;
     height_ = 0;
+    depth_ = 1;
     imageFormat_ = ImageFormat::Invalid;
+    levels_ = 0;
+    immutable_ = false;
 }
 }
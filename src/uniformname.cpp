@@ -0,0 +1,50 @@
+#include "glw/uniformname.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace glw {
+void UniformLocationTable::insert(uint64_t hash, GLint location)
+{
+    assert(hash != 0);
+    if ((count_ + 1) * maxLoadDenominator > entries_.size())
+        rehash(std::max<size_t>(16, entries_.size() * 2));
+
+    const auto mask = entries_.size() - 1;
+    for (auto i = static_cast<size_t>(hash) & mask;; i = (i + 1) & mask) {
+        if (entries_[i].hash == hash) {
+            entries_[i].location = location;
+            return;
+        }
+        if (entries_[i].hash == 0) {
+            entries_[i] = Entry { hash, location };
+            count_++;
+            return;
+        }
+    }
+}
+
+void UniformLocationTable::clear()
+{
+    entries_.clear();
+    count_ = 0;
+}
+
+size_t UniformLocationTable::size() const
+{
+    return count_;
+}
+
+void UniformLocationTable::rehash(size_t capacity)
+{
+    // The capacity has to be a power of two, so we can mask instead of modulo
+    assert((capacity & (capacity - 1)) == 0);
+    auto old = std::move(entries_);
+    entries_.assign(capacity, Entry {});
+    count_ = 0;
+    for (const auto& entry : old) {
+        if (entry.hash != 0)
+            insert(entry.hash, entry.location);
+    }
+}
+}
@@ -78,6 +78,11 @@ const VertexFormat::Attribute* VertexFormat::get(size_t location) const
     return &(*it);
 }
 
+const std::vector<VertexFormat::Attribute>& VertexFormat::getAttributes() const
+{
+    return attributes_;
+}
+
 VertexFormat& VertexFormat::add(Attribute attr)
 {
     assert(attr.components >= 1 && attr.components <= 4);